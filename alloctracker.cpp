@@ -0,0 +1,307 @@
+#include "alloctracker.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ENGINE_RETURN_ADDRESS() _ReturnAddress()
+#else
+#define ENGINE_RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+
+#if defined(__linux__)
+#include <dlfcn.h>
+#endif
+
+namespace engine {
+	// per thread counters are plain thread locals so the common path is a few non-atomic increments
+	static thread_local AllocationStats threadCounters = {};
+
+	// process wide counters, relaxed since they are only ever read as statistics
+	static std::atomic<uint64_t> processAllocations{ 0 };
+	static std::atomic<uint64_t> processDeallocations{ 0 };
+	static std::atomic<uint64_t> processBytes{ 0 };
+
+	// fixed size open addressing table of call sites; it is never resized so recording can't allocate
+	struct CallsiteSlot {
+		std::atomic<uintptr_t> address{ 0 };
+		std::atomic<uint64_t> allocations{ 0 };
+		std::atomic<uint64_t> bytes{ 0 };
+	};
+	static constexpr size_t CALLSITE_SLOTS = 4096; // must be a power of two
+	static CallsiteSlot callsites[CALLSITE_SLOTS];
+	static std::atomic<bool> captureCallsites{ false };
+	static std::atomic<uint64_t> droppedCallsites{ 0 };
+
+	static void recordCallsite(void* returnAddress, size_t size) {
+		uintptr_t address = reinterpret_cast<uintptr_t>(returnAddress);
+		size_t slot = static_cast<size_t>((address >> 4) * 0x9e3779b97f4a7c15ull) & (CALLSITE_SLOTS - 1);
+
+		// linear probing, claiming an empty slot with a compare exchange
+		for (size_t probe = 0; probe < CALLSITE_SLOTS; probe++) {
+			CallsiteSlot& entry = callsites[(slot + probe) & (CALLSITE_SLOTS - 1)];
+			uintptr_t current = entry.address.load(std::memory_order_relaxed);
+			if (current == 0 && entry.address.compare_exchange_strong(current, address, std::memory_order_relaxed)) {
+				current = address;
+			}
+			if (current == address) {
+				entry.allocations.fetch_add(1, std::memory_order_relaxed);
+				entry.bytes.fetch_add(size, std::memory_order_relaxed);
+				return;
+			}
+		}
+
+		droppedCallsites.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	static void countAllocation(size_t size, void* returnAddress) {
+		threadCounters.allocations++;
+		threadCounters.bytesAllocated += size;
+		processAllocations.fetch_add(1, std::memory_order_relaxed);
+		processBytes.fetch_add(size, std::memory_order_relaxed);
+
+		if (captureCallsites.load(std::memory_order_relaxed)) {
+			recordCallsite(returnAddress, size);
+		}
+	}
+
+	static void countDeallocation(void* pointer) {
+		if (pointer == nullptr) return;
+		threadCounters.deallocations++;
+		processDeallocations.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	static void* allocateAligned(size_t size, size_t alignment) {
+		if (size == 0) size = 1;
+#ifdef _WIN32
+		return _aligned_malloc(size, alignment);
+#else
+		void* pointer = nullptr;
+		if (posix_memalign(&pointer, std::max(alignment, sizeof(void*)), size) != 0) {
+			return nullptr;
+		}
+		return pointer;
+#endif
+	}
+
+	static void freeAligned(void* pointer) {
+#ifdef _WIN32
+		_aligned_free(pointer);
+#else
+		free(pointer);
+#endif
+	}
+
+	// *************** Allocation Tracker *********************
+
+	AllocationStats alloctracker::threadStats() {
+		return threadCounters;
+	}
+
+	AllocationStats alloctracker::processStats() {
+		AllocationStats stats = {};
+		stats.allocations = processAllocations.load(std::memory_order_relaxed);
+		stats.deallocations = processDeallocations.load(std::memory_order_relaxed);
+		stats.bytesAllocated = processBytes.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	void alloctracker::beginFrame() {
+		frameStart = processStats();
+		frameExempt = false;
+	}
+
+	AllocationStats alloctracker::endFrame() {
+		AllocationStats now = processStats();
+		AllocationStats frame = {};
+		frame.allocations = now.allocations - frameStart.allocations;
+		frame.deallocations = now.deallocations - frameStart.deallocations;
+		frame.bytesAllocated = now.bytesAllocated - frameStart.bytesAllocated;
+		frameCount++;
+
+		if (zeroAllocationMode && !frameExempt && frameCount > warmupFrameCount && frame.allocations > 0) {
+			std::cerr << "frame " << frameCount << " made " << frame.allocations << " heap allocations (" << frame.bytesAllocated << " bytes)" << std::endl;
+			if (captureCallsites.load(std::memory_order_relaxed)) {
+				reportCallsites(std::cerr);
+			}
+			assert(frame.allocations == 0 && "steady-state frame allocated heap memory");
+		}
+
+		return frame;
+	}
+
+	void alloctracker::exemptCurrentFrame() {
+		frameExempt = true;
+	}
+
+	void alloctracker::setZeroAllocationMode(bool enabled, uint32_t warmupFrames) {
+		zeroAllocationMode = enabled;
+		warmupFrameCount = static_cast<uint32_t>(std::min<uint64_t>(frameCount + warmupFrames, UINT32_MAX));
+	}
+
+	void alloctracker::setCallsiteCapture(bool enabled) {
+		captureCallsites.store(enabled, std::memory_order_relaxed);
+	}
+
+	void alloctracker::resetCallsites() {
+		for (auto& entry : callsites) {
+			entry.allocations.store(0, std::memory_order_relaxed);
+			entry.bytes.store(0, std::memory_order_relaxed);
+			entry.address.store(0, std::memory_order_relaxed);
+		}
+		droppedCallsites.store(0, std::memory_order_relaxed);
+	}
+
+	void alloctracker::reportCallsites(std::ostream& out, size_t maxSites) {
+		// pause capture so the report's own allocations don't show up in it
+		bool wasCapturing = captureCallsites.exchange(false, std::memory_order_relaxed);
+
+		struct Site {
+			uintptr_t address;
+			uint64_t allocations;
+			uint64_t bytes;
+		};
+		std::vector<Site> sites = {};
+		for (const auto& entry : callsites) {
+			uint64_t count = entry.allocations.load(std::memory_order_relaxed);
+			if (count > 0) {
+				sites.push_back({ entry.address.load(std::memory_order_relaxed), count, entry.bytes.load(std::memory_order_relaxed) });
+			}
+		}
+		std::sort(sites.begin(), sites.end(), [](const Site& a, const Site& b) { return a.allocations > b.allocations; });
+
+		out << "allocation call sites (" << sites.size() << " recorded, " << droppedCallsites.load(std::memory_order_relaxed) << " dropped):" << std::endl;
+		for (size_t i = 0; i < sites.size() && i < maxSites; i++) {
+			out << "\t" << std::setw(10) << sites[i].allocations << " allocs " << std::setw(12) << sites[i].bytes << " bytes  0x" << std::hex << sites[i].address << std::dec;
+#if defined(__linux__)
+			Dl_info info = {};
+			if (dladdr(reinterpret_cast<void*>(sites[i].address), &info) != 0) {
+				out << "  " << (info.dli_sname != nullptr ? info.dli_sname : "?") << " in " << (info.dli_fname != nullptr ? info.dli_fname : "?");
+			}
+#endif
+			out << std::endl;
+		}
+
+		captureCallsites.store(wasCapturing, std::memory_order_relaxed);
+	}
+}
+
+// *************** Global Allocation Hooks *********************
+
+void* operator new(size_t size) {
+	void* pointer = std::malloc(size == 0 ? 1 : size);
+	if (pointer == nullptr) throw std::bad_alloc();
+	engine::countAllocation(size, ENGINE_RETURN_ADDRESS());
+	return pointer;
+}
+
+void* operator new[](size_t size) {
+	void* pointer = std::malloc(size == 0 ? 1 : size);
+	if (pointer == nullptr) throw std::bad_alloc();
+	engine::countAllocation(size, ENGINE_RETURN_ADDRESS());
+	return pointer;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	void* pointer = std::malloc(size == 0 ? 1 : size);
+	if (pointer != nullptr) engine::countAllocation(size, ENGINE_RETURN_ADDRESS());
+	return pointer;
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	void* pointer = std::malloc(size == 0 ? 1 : size);
+	if (pointer != nullptr) engine::countAllocation(size, ENGINE_RETURN_ADDRESS());
+	return pointer;
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	void* pointer = engine::allocateAligned(size, static_cast<size_t>(alignment));
+	if (pointer == nullptr) throw std::bad_alloc();
+	engine::countAllocation(size, ENGINE_RETURN_ADDRESS());
+	return pointer;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	void* pointer = engine::allocateAligned(size, static_cast<size_t>(alignment));
+	if (pointer == nullptr) throw std::bad_alloc();
+	engine::countAllocation(size, ENGINE_RETURN_ADDRESS());
+	return pointer;
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	void* pointer = engine::allocateAligned(size, static_cast<size_t>(alignment));
+	if (pointer != nullptr) engine::countAllocation(size, ENGINE_RETURN_ADDRESS());
+	return pointer;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	void* pointer = engine::allocateAligned(size, static_cast<size_t>(alignment));
+	if (pointer != nullptr) engine::countAllocation(size, ENGINE_RETURN_ADDRESS());
+	return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+	engine::countDeallocation(pointer);
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	engine::countDeallocation(pointer);
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+	engine::countDeallocation(pointer);
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+	engine::countDeallocation(pointer);
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+	engine::countDeallocation(pointer);
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+	engine::countDeallocation(pointer);
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+	engine::countDeallocation(pointer);
+	engine::freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+	engine::countDeallocation(pointer);
+	engine::freeAligned(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+	engine::countDeallocation(pointer);
+	engine::freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept {
+	engine::countDeallocation(pointer);
+	engine::freeAligned(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+	engine::countDeallocation(pointer);
+	engine::freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+	engine::countDeallocation(pointer);
+	engine::freeAligned(pointer);
+}
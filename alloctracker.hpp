@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace engine {
+	// counters for heap allocations made through the global operator new/delete
+	struct AllocationStats {
+		uint64_t allocations = 0; // calls to operator new
+		uint64_t deallocations = 0; // calls to operator delete with a non-null pointer
+		uint64_t bytesAllocated = 0; // bytes requested from operator new
+	};
+
+	// tracks heap allocations through the replaced global operator new/delete in alloctracker.cpp
+	// counters are kept per thread and for the whole process; call-site capture is optional because it costs a table lookup per allocation
+	class alloctracker {
+	public:
+		static AllocationStats threadStats(); // allocations made by the calling thread
+		static AllocationStats processStats(); // allocations made by every thread
+
+		static void beginFrame(); // start counting the allocations of a frame
+		static AllocationStats endFrame(); // stop counting, returns the allocations made by all threads since beginFrame
+		static void exemptCurrentFrame(); // mark the current frame as expected to allocate (swap chain recreation, loading)
+		static uint64_t getFrameCount() { return frameCount; } // frames counted since startup
+
+		// zero allocation mode: once warmupFrames have passed, any frame that allocates fails an assertion
+		static void setZeroAllocationMode(bool enabled, uint32_t warmupFrames = 8);
+
+		// call-site capture records the return address of every allocation in a fixed size table
+		static void setCallsiteCapture(bool enabled);
+		static void resetCallsites();
+		static void reportCallsites(std::ostream& out, size_t maxSites = 16); // print the call sites with the most allocations
+
+	private:
+		static inline AllocationStats frameStart = {}; // process counters when the current frame began
+		static inline uint64_t frameCount = 0; // frames counted since startup
+		static inline uint32_t warmupFrameCount = 0; // frames to skip before zero allocation mode kicks in
+		static inline bool zeroAllocationMode = false; // fail frames that allocate after warm-up
+		static inline bool frameExempt = false; // current frame is allowed to allocate
+	};
+}
@@ -4,6 +4,9 @@
 #include "pointlightsystem.hpp"
 #include "buffer.hpp"
 #include "input.hpp"
+#include "alloctracker.hpp"
+#include "startupprofiler.hpp"
+#include "nullvulkan.hpp"
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
@@ -12,40 +15,48 @@
 #include <array>
 #include <chrono>
 #include <cassert>
+#include <iostream>
+#include <cstdio>
 
 namespace engine {
-    // struct to create a global uniform buffer
-    struct GlobalUbo {
-        glm::mat4 projection{ 1.f };
-        glm::mat4 view{ 1.f };
-        glm::vec4 ambientLightColor{ 1.f, 1.f, 1.f, .02f }; // r, g, b, intensity
-        glm::vec3 lightPosition{ -1.f };
-        alignas(16) glm::vec4 lightColor{ 1.f }; // r, g, b, intensity
+    // model files for the scene, parsed on worker threads as soon as the device exists
+    static const char* const MODEL_FILES[] = {
+        "A:\\Dev\\Libraries\\models\\tree.obj",
+        "A:\\Dev\\Libraries\\models\\flat_vase.obj",
+        "A:\\Dev\\Libraries\\models\\quad.obj",
     };
 
-	application::application() {
-        globalPool = descriptorPool::Builder(deviceInstance).setMaxSets(swapchain::MAX_FRAMES_IN_FLIGHT).addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, swapchain::MAX_FRAMES_IN_FLIGHT).build();
-        loadEntities(); 
+	application::application(std::optional<SceneSettings> sceneSettings) : sceneSettings{ sceneSettings } {
+        descriptorAllocatorInstance = descriptorAllocator::Builder(deviceInstance).setSetsPerPool(64).addPoolRatio(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.f).addPoolRatio(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.f).setFrameCount(swapchain::MAX_FRAMES_IN_FLIGHT).build();
+        globalSetLayout = descriptorSetLayout::Builder(deviceInstance).addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS).build();
+
+        // shader loading and pipeline creation only need the device and render pass, so build them on worker threads while models upload
+        VkRenderPass renderPass = rendererInstance.getSwapchainRenderPass();
+        VkDescriptorSetLayout setLayout = globalSetLayout->getDescriptorSetLayout();
+        auto renderSystemTask = std::async(startupProfiler::launchPolicy(), [this, renderPass, setLayout]() { return std::make_unique<rendersystem>(deviceInstance, renderPass, setLayout); });
+        auto pointLightSystemTask = std::async(startupProfiler::launchPolicy(), [this, renderPass, setLayout]() { return std::make_unique<pointlightsystem>(deviceInstance, renderPass, setLayout); });
+
+        loadEntities();
+        renderSystem = renderSystemTask.get();
+        pointLightSystem = pointLightSystemTask.get();
+        deviceInstance.getLayoutCache().report(std::cout);
     }
 
 	application::~application() {}
 
-	void application::run() {
+	void application::run(const RunSettings& settings) {
         std::vector<std::unique_ptr<buffer>> uboBuffers(swapchain::MAX_FRAMES_IN_FLIGHT);
         for (int i = 0; i < uboBuffers.size(); i++) {
             uboBuffers[i] = std::make_unique<buffer>(deviceInstance, sizeof(GlobalUbo), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
             uboBuffers[i]->map();
         }
 
-        auto globalSetLayout = descriptorSetLayout::Builder(deviceInstance).addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS).build();
         std::vector<VkDescriptorSet> globalDescriptorSets(swapchain::MAX_FRAMES_IN_FLIGHT);
         for (int i = 0; i < globalDescriptorSets.size(); i++) {
             auto bufferInfo = uboBuffers[i]->descriptorInfo();
-            descriptorWriter(*globalSetLayout, *globalPool).writeBuffer(0, &bufferInfo).build(globalDescriptorSets[i]);
+            descriptorWriter(*globalSetLayout, *descriptorAllocatorInstance).writeBuffer(0, &bufferInfo).build(globalDescriptorSets[i]);
         }
 
-		rendersystem rendersys{ deviceInstance, rendererInstance.getSwapchainRenderPass(), globalSetLayout->getDescriptorSetLayout() };
-        pointlightsystem pointlightsys{ deviceInstance, rendererInstance.getSwapchainRenderPass(), globalSetLayout->getDescriptorSetLayout() };
         camera cameraInstance = {};
         
         cameraInstance.setViewTarget(glm::vec3(-1.f, -2.f, 2.f), glm::vec3(0.f, 0.f, 2.5f));
@@ -54,66 +65,227 @@ namespace engine {
         auto viewerEntity = entity::createEntity();
         viewerEntity.transform.translation.z = -2.5f;
         input cameraController = {};
+        std::unique_ptr<flythrough> flythroughInstance = settings.flythroughSettings ? std::make_unique<flythrough>(*settings.flythroughSettings) : nullptr; // replaces keyboard input when benchmarking
+        std::unique_ptr<frameReadback> readbackInstance = {}; // copies frames out for screenshots without stalling the queue
+        if (!settings.screenshotPath.empty() || !settings.recordPrefix.empty()) {
+            if (rendererInstance.supportsReadback()) readbackInstance = std::make_unique<frameReadback>(deviceInstance);
+            else std::cerr << "swap chain images can't be copied from on this surface, screenshots disabled" << std::endl;
+        }
+        std::unique_ptr<frameCapture> captureInstance = settings.capturePath.empty() ? nullptr : std::make_unique<frameCapture>(deviceInstance, settings.capturePath, windowInstance.getExtent(), settings.captureFrames);
 
         // for game loop timing
         auto currentTime = std::chrono::high_resolution_clock::now();
 
-		while (!windowInstance.shouldClose()) {
+#ifdef ENGINE_ZERO_ALLOCATION_FRAMES
+        // fail any frame that touches the heap once the first few frames have settled
+        alloctracker::setCallsiteCapture(true);
+        alloctracker::setZeroAllocationMode(true);
+#endif
+
+        staticBatcherInstance.update(gameEntities); // the first frame already draws the static entities as chunks
+        uint64_t framesRendered = 0;
+        auto loopStart = std::chrono::high_resolution_clock::now();
+		while (!windowInstance.shouldClose() && (settings.frameLimit == 0 || framesRendered < settings.frameLimit)) {
+            alloctracker::beginFrame();
 			glfwPollEvents();
             auto newTime = std::chrono::high_resolution_clock::now();
             float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
             frameTime = glm::min(frameTime, 1.f);
-            cameraController.moveInPlaneXZ(windowInstance.getGLFWwindow(), frameTime, viewerEntity);
+            if (flythroughInstance) {
+                frameTime = flythroughInstance->beginFrame(frameTime, viewerEntity);
+                if (flythroughInstance->isFinished()) {
+                    alloctracker::endFrame();
+                    break;
+                }
+            }
+            else {
+                cameraController.moveInPlaneXZ(windowInstance.getGLFWwindow(), frameTime, viewerEntity);
+            }
             cameraInstance.setViewYXZ(viewerEntity.transform.translation, viewerEntity.transform.rotation);
             float aspect = rendererInstance.getAspectRatio();
             cameraInstance.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 100.f);
 			if (auto commandBuffer = rendererInstance.beginFrame()) {
                 // prepare and update entities in memory
                 int frameIndex = rendererInstance.getFrameIndex();
+                frameArenaInstance.beginFrame(frameIndex); // the fence for this slot has signaled, so its scratch memory can be reused
+                descriptorAllocatorInstance->resetFrame(frameIndex); // along with the descriptor sets allocated for it
+                if (readbackInstance) readbackInstance->collect(frameIndex); // and so has the copy recorded the last time this slot was used
                 GlobalUbo ubo = {};
                 ubo.projection = cameraInstance.getProjection();
                 ubo.view = cameraInstance.getView();
+                if (!sceneLights.empty()) {
+                    // the shaders take a single point light, so the first generated light stands in for all of them
+                    ubo.lightPosition = sceneLights[0].position;
+                    ubo.lightColor = sceneLights[0].color;
+                }
                 uboBuffers[frameIndex]->writeToBuffer(&ubo);
                 uboBuffers[frameIndex]->flush();
 
+                // mirror this frame's commands into the capture file while it's in the capture window
+                frameCapture* capture = captureInstance && !captureInstance->isFinished() && framesRendered >= settings.captureStart ? captureInstance.get() : nullptr;
+                if (capture) capture->beginFrame(ubo);
+
                 // render
-                FrameInfo frameInfo{ frameIndex, frameTime, commandBuffer, cameraInstance, globalDescriptorSets[frameIndex], gameEntities };
+                FrameInfo frameInfo{ frameIndex, frameTime, commandBuffer, cameraInstance, globalDescriptorSets[frameIndex], gameEntities, frameArenaInstance, capture, descriptorAllocatorInstance.get(), &staticBatcherInstance };
 				rendererInstance.beginSwapchainRenderPass(commandBuffer);
-				rendersys.renderEntities(frameInfo);
-                pointlightsys.render(frameInfo);
+				uint32_t drawCount = renderSystem->renderEntities(frameInfo);
+                drawCount += pointLightSystem->render(frameInfo);
 				rendererInstance.endSwapchainRenderPass(commandBuffer);
+                if (readbackInstance) {
+                    std::string filepath = {};
+                    if (!settings.recordPrefix.empty()) {
+                        char frameNumber[32] = {};
+                        std::snprintf(frameNumber, sizeof(frameNumber), "%06llu.ppm", static_cast<unsigned long long>(framesRendered));
+                        filepath = settings.recordPrefix + frameNumber;
+                    }
+                    else if (framesRendered == settings.screenshotFrame) {
+                        filepath = settings.screenshotPath;
+                    }
+                    if (!filepath.empty()) {
+                        readbackInstance->record(commandBuffer, frameIndex, rendererInstance.getCurrentImage(), rendererInstance.getSwapchainImageFormat(), rendererInstance.getSwapchainExtent(), VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, std::move(filepath));
+                    }
+                }
 				rendererInstance.endFrame();
+                if (flythroughInstance) flythroughInstance->endFrame();
+                if (capture) capture->endFrame();
+                startupProfiler::markFirstFrame();
+
+                // export frame statistics for external monitoring
+                AllocationStats frameAllocations = alloctracker::endFrame();
+                telemetryInstance.recordFrame(frameTime, drawCount, static_cast<uint32_t>(gameEntities.size()), static_cast<uint32_t>(frameAllocations.allocations));
+                framesRendered++;
+                refineModels(); // outside the frame's allocation tracking, streaming needs staging buffers
+                staticBatcherInstance.update(gameEntities); // likewise for rebuilding the chunks of static entities that changed
 			}
+            else {
+                alloctracker::endFrame();
+            }
 		}
 
 		vkDeviceWaitIdle(deviceInstance.getDevice());
+        if (readbackInstance) {
+            readbackInstance->flush();
+            readbackInstance->report(std::cout);
+        }
+        frameArenaInstance.report(std::cout);
+        descriptorAllocatorInstance->report(std::cout);
+        staticBatcherInstance.report(std::cout);
+        if (!sceneSettings) assetReaderInstance.report(std::cout);
+        if (assetPackInstance) assetPackInstance->report(std::cout);
+        if (flythroughInstance) flythroughInstance->report(std::cout, deviceInstance.deviceProperties.deviceName, gameEntities.size());
+
+#ifdef ENGINE_NULL_VULKAN
+        // with no GPU or driver underneath, the loop time is the engine's own CPU cost
+        double loopMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loopStart).count();
+        std::cout << "cpu time per frame: " << loopMs / static_cast<double>(framesRendered > 0 ? framesRendered : 1) << " ms" << std::endl;
+        nullVulkan::report(std::cout, framesRendered);
+#endif
 	}
 
+    std::vector<std::future<model::Builder>> application::startLoadingModels() {
+        std::vector<std::future<model::Builder>> loads = {};
+        if (sceneSettings) {
+            for (uint32_t i = 0; i < sceneSettings->meshCount; i++) {
+                loads.push_back(std::async(startupProfiler::launchPolicy(), [settings = *sceneSettings, i]() {
+                    startupProfiler::phase phase{ "mesh generation" };
+                    return sceneGenerator::generateMesh(settings, i);
+                }));
+            }
+            return loads;
+        }
+
+        // every read is queued up front so the files come in together, each parse starts as soon as its bytes are there
+        // packed meshes are already cooked, so they need neither and their slot is left without a future; any other
+        // entry under a model's name, e.g. the OBJ stored raw, is read from the loose file like an unpacked model
+        for (const char* filepath : MODEL_FILES) {
+            auto packed = assetPackInstance ? assetPackInstance->find(filepath) : std::nullopt;
+            if (packed && (packed->type == assetPack::AssetType::MESH || packed->type == assetPack::AssetType::ENCODED_MESH || packed->type == assetPack::AssetType::PROGRESSIVE_MESH)) {
+                loads.emplace_back();
+                continue;
+            }
+            std::shared_future<std::vector<char>> data = assetReaderInstance.readFile(filepath).share();
+            loads.push_back(std::async(startupProfiler::launchPolicy(), [filepath, data]() {
+                const std::vector<char>& bytes = data.get();
+                startupProfiler::phase phase{ "model parse" };
+                model::Builder builderInstance = {};
+                builderInstance.loadModelFromMemory(bytes, filepath);
+                return builderInstance;
+            }));
+        }
+        return loads;
+    }
+
+    void application::refineModels() {
+        // one level per frame, so a frame waits on at most one upload
+        if (refiningModels.empty()) return;
+        if (!refiningModels.front()->refine()) {
+            refiningModels.erase(refiningModels.begin());
+            if (refiningModels.empty()) startupProfiler::markFullDetail();
+        }
+    }
+
     void application::loadEntities() {
-        std::shared_ptr<model> modelInstance = model::createModelFromFile(deviceInstance, "A:\\Dev\\Libraries\\models\\tree.obj");
+        if (sceneSettings) {
+            std::vector<std::shared_ptr<model>> models = {};
+            models.reserve(pendingModels.size());
+            for (auto& pending : pendingModels) {
+                models.push_back(std::make_shared<model>(deviceInstance, pending.get()));
+            }
+            pendingModels.clear();
+
+            startupProfiler::phase phase{ "scene nodes" };
+            sceneGenerator::createEntities(sceneGenerator::generateNodes(*sceneSettings), models, gameEntities);
+            if (sceneSettings->staticEntities) {
+                for (auto& kv : gameEntities) kv.second.isStatic = true;
+            }
+            sceneLights = sceneGenerator::generateLights(*sceneSettings);
+            return;
+        }
+
+        // uploads go through the device's single command pool, so they stay on this thread as each parse finishes
+        // packed models upload straight from the mapping, encoded ones are decoded into the staging buffer on the way
+        // and progressive ones upload their coarsest level now and the rest one level per frame
+        auto loadModel = [this](size_t index) {
+            if (pendingModels[index].valid()) return std::make_shared<model>(deviceInstance, pendingModels[index].get());
+            assetPack::AssetType type = assetPackInstance->find(MODEL_FILES[index])->type;
+            if (type == assetPack::AssetType::ENCODED_MESH) {
+                return std::make_shared<model>(deviceInstance, assetPackInstance->getEncodedMesh(MODEL_FILES[index]));
+            }
+            if (type == assetPack::AssetType::PROGRESSIVE_MESH) {
+                auto modelInstance = std::make_shared<model>(deviceInstance, assetPackInstance->getProgressiveMesh(MODEL_FILES[index]));
+                if (!modelInstance->isRefined()) refiningModels.push_back(modelInstance);
+                return modelInstance;
+            }
+            return std::make_shared<model>(deviceInstance, assetPackInstance->getMesh(MODEL_FILES[index]));
+        };
+        std::shared_ptr<model> modelInstance = loadModel(0);
 
         auto tree = entity::createEntity();
         tree.modelInstance = modelInstance;
         tree.transform.translation = { .0f, 1.0f, 0.f };
         tree.transform.scale = { .05f, .05f, .05f };
         tree.transform.rotation = { .0f, .0f, 3.14f };
+        tree.isStatic = true;
         gameEntities.emplace(tree.getId(), std::move(tree));
 
-        modelInstance = model::createModelFromFile(deviceInstance, "A:\\Dev\\Libraries\\models\\flat_vase.obj");
+        modelInstance = loadModel(1);
         
         auto vase = entity::createEntity();
         vase.modelInstance = modelInstance;
         vase.transform.translation = { .0f, 2.08f, 0.f };
         vase.transform.scale = { 3.f, 3.f, 3.f };
+        vase.isStatic = true;
         gameEntities.emplace(vase.getId(), std::move(vase));
 
-        modelInstance = model::createModelFromFile(deviceInstance, "A:\\Dev\\Libraries\\models\\quad.obj");
+        modelInstance = loadModel(2);
 
         auto floor = entity::createEntity();
         floor.modelInstance = modelInstance;
         floor.transform.translation = { .0f, 2.08f, 0.f };
         floor.transform.scale = { 5.f, 5.f, 5.f };
+        floor.isStatic = true;
         gameEntities.emplace(floor.getId(), std::move(floor));
+        pendingModels.clear();
     }
 }
\ No newline at end of file
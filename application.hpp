@@ -4,31 +4,72 @@
 #include "entity.hpp"
 #include "renderer.hpp"
 #include "descriptors.hpp"
+#include "rendersystem.hpp"
+#include "pointlightsystem.hpp"
+#include "telemetry.hpp"
+#include "framearena.hpp"
+#include "scenegenerator.hpp"
+#include "flythrough.hpp"
+#include "framecapture.hpp"
+#include "framereadback.hpp"
+#include "assetreader.hpp"
+#include "assetpack.hpp"
+#include "staticbatcher.hpp"
+#include <future>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 namespace engine {
+	// options for one run of the main loop
+	struct RunSettings {
+		uint64_t frameLimit = 0; // stop after this many frames, 0 runs until the window closes
+		std::optional<flythrough::Settings> flythroughSettings = {}; // follow a camera path instead of input and report per-segment frame times
+		std::string capturePath = {}; // record frames into this file for tools/capturereplay.cpp
+		uint64_t captureStart = 0; // first frame to capture
+		uint32_t captureFrames = 1; // frames to capture
+		std::string screenshotPath = {}; // write one frame to this .png or .ppm file
+		uint64_t screenshotFrame = 0; // frame to take the screenshot of
+		std::string recordPrefix = {}; // write every frame to <prefix><frame number>.ppm, e.g. for video
+	};
+
 	class application {
 	public:
 		static constexpr int WIDTH = 800; // window width
 		static constexpr int HEIGHT = 600; // window height
+		static constexpr const char* ASSET_PACK_FILE = "assets.pack"; // cooked by tools/assetcooker.cpp, loose files are loaded when it's missing
 
-		application(); // constructor
+		application(std::optional<SceneSettings> sceneSettings = std::nullopt); // constructor, a generated scene replaces the model files when settings are given
 		~application(); // destructor
 
 		// not copyable or movable
 		application(const application&) = delete;
 		application& operator = (const application&) = delete;
 
-		void run(); // main event loop function
+		void run(const RunSettings& settings = {}); // main event loop function
 
 	private:
+		std::vector<std::future<model::Builder>> startLoadingModels(); // start reading and parsing the model files or generating the scene meshes on worker threads
 		void loadEntities(); // load the entities
+		void refineModels(); // stream the next level of a progressive model, called between frames
 
 		window windowInstance{ WIDTH, HEIGHT, "VulkanGame" }; // a handle for the window instance
 		device deviceInstance{ windowInstance }; // a handle for the device instance
+		std::optional<SceneSettings> sceneSettings = {}; // set when running on a generated stress scene
+		assetReader assetReaderInstance = {}; // a handle for the asynchronous file reads, declared before the loads that use it
+		std::unique_ptr<assetPack> assetPackInstance = assetPack::mountIfPresent(ASSET_PACK_FILE); // the mapped asset pack, null when running from loose files
+		std::vector<std::future<model::Builder>> pendingModels = startLoadingModels(); // models parsed while the swap chain is created, left empty for packed models
 		entity::Map gameEntities; // a handle for the entity objects
-		std::unique_ptr<descriptorPool> globalPool = {}; // a handle for the descriptor pool
+		std::vector<SceneLight> sceneLights = {}; // lights of the generated scene, empty for the model files
+		std::vector<std::shared_ptr<model>> refiningModels = {}; // progressive models still drawn at a coarser level
+		staticBatcher staticBatcherInstance{ deviceInstance }; // static entities merged into world space chunks
+		std::unique_ptr<descriptorAllocator> descriptorAllocatorInstance = {}; // a handle for the growable descriptor pools
 		renderer rendererInstance{ windowInstance, deviceInstance }; // a handle for the renderer
+		std::unique_ptr<descriptorSetLayout> globalSetLayout = {}; // a handle for the global descriptor set layout
+		std::unique_ptr<rendersystem> renderSystem = {}; // a handle for the entity render system
+		std::unique_ptr<pointlightsystem> pointLightSystem = {}; // a handle for the point light render system
+		telemetry telemetryInstance = {}; // a handle for the shared memory statistics export
+		frameArena frameArenaInstance = {}; // a handle for the per-frame scratch allocators
 	};
 }
\ No newline at end of file
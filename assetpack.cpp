@@ -0,0 +1,375 @@
+#include "assetpack.hpp"
+#include "meshcodec.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine {
+	// the on-disk layout is the struct layout, so it must not change without a VERSION bump
+	static_assert(sizeof(assetPack::Header) == 32, "asset pack header layout changed");
+	static_assert(sizeof(assetPack::Entry) == 32, "asset pack entry layout changed");
+	static_assert(sizeof(assetPack::MeshHeader) == 16, "asset pack mesh header layout changed");
+	static_assert(sizeof(assetPack::EncodedMeshHeader) == 24, "asset pack encoded mesh header layout changed");
+	static_assert(sizeof(assetPack::ProgressiveMeshHeader) == 32 && sizeof(model::ProgressiveLevel) == 8, "asset pack progressive mesh layout changed");
+	static_assert(sizeof(model::Submesh) == 36 && alignof(model::Submesh) == 4, "asset pack submesh layout changed");
+
+	static std::atomic<const assetPack*> mountedPack{ nullptr };
+
+	static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// true if there is at least one submesh and every one lies within the indices
+	static bool validSubmeshes(const char* table, uint32_t submeshCount, uint32_t indexCount) {
+		if (submeshCount == 0) return false;
+		for (uint32_t i = 0; i < submeshCount; i++) {
+			model::Submesh submesh = {};
+			std::memcpy(&submesh, table + i * sizeof(submesh), sizeof(submesh));
+			if (static_cast<uint64_t>(submesh.firstIndex) + submesh.indexCount > indexCount) return false;
+		}
+		return true;
+	}
+
+	// a mesh's submesh table as stored ahead of its geometry
+	static void appendSubmeshes(std::vector<char>& bytes, const std::vector<model::Submesh>& submeshes) {
+		const char* table = reinterpret_cast<const char*>(submeshes.data());
+		bytes.insert(bytes.end(), table, table + submeshes.size() * sizeof(model::Submesh));
+	}
+
+	assetPack::assetPack(const std::string& filepath) : filepath{ filepath } {
+		void* memory = nullptr;
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error("failed to open asset pack " + filepath + "!");
+		}
+		LARGE_INTEGER fileSize = {};
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(Header))) {
+			CloseHandle(file);
+			throw std::runtime_error("failed to open asset pack " + filepath + ": file is too small!");
+		}
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		memory = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (memory == nullptr) {
+			if (mapping != nullptr) CloseHandle(mapping);
+			CloseHandle(file);
+			throw std::runtime_error("failed to map asset pack " + filepath + "!");
+		}
+		fileHandle = file;
+		mappingHandle = mapping;
+		size = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+		int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			throw std::runtime_error("failed to open asset pack " + filepath + "!");
+		}
+		struct stat status = {};
+		if (::fstat(fd, &status) != 0 || static_cast<uint64_t>(status.st_size) < sizeof(Header)) {
+			::close(fd);
+			throw std::runtime_error("failed to open asset pack " + filepath + ": file is too small!");
+		}
+		size = static_cast<uint64_t>(status.st_size);
+		memory = mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd); // the mapping keeps the file open
+		if (memory == MAP_FAILED) {
+			throw std::runtime_error("failed to map asset pack " + filepath + "!");
+		}
+		// assets are read soon after mounting, so start paging the file in now rather than one fault at a time
+		madvise(memory, static_cast<size_t>(size), MADV_WILLNEED);
+#endif
+		data = static_cast<const char*>(memory);
+
+		// everything is checked once here, so lookups can trust the offsets
+		auto fail = [this](const char* reason) {
+			unmap();
+			throw std::runtime_error("failed to open asset pack " + this->filepath + ": " + reason + "!");
+		};
+		header = reinterpret_cast<const Header*>(data);
+		if (header->magic != MAGIC) fail("not an asset pack");
+		if (header->version != VERSION) fail("unsupported version");
+		if (header->vertexSize != sizeof(model::Vertex)) fail("cooked for a different vertex layout");
+		if (header->tocOffset % alignof(Entry) != 0 || header->tocOffset > size || header->entryCount > (size - header->tocOffset) / sizeof(Entry)) fail("table of contents out of bounds");
+		if (header->namesOffset > size) fail("names out of bounds");
+
+		entries = reinterpret_cast<const Entry*>(data + header->tocOffset);
+		nameData = data + header->namesOffset;
+		uint64_t namesSize = size - header->namesOffset;
+		for (uint32_t i = 0; i < header->entryCount; i++) {
+			const Entry& entry = entries[i];
+			if (entry.offset % ALIGNMENT != 0 || entry.offset > size || entry.size > size - entry.offset) fail("asset out of bounds");
+			if (static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > namesSize) fail("asset name out of bounds");
+			if (i > 0 && std::string_view{ nameData + entries[i - 1].nameOffset, entries[i - 1].nameLength } >= std::string_view{ nameData + entry.nameOffset, entry.nameLength }) {
+				fail("table of contents not sorted");
+			}
+			if (entry.type == AssetType::MESH) {
+				MeshHeader mesh = {};
+				if (entry.size < sizeof(mesh)) fail("malformed mesh");
+				std::memcpy(&mesh, data + entry.offset, sizeof(mesh));
+				uint64_t submeshBytes = static_cast<uint64_t>(mesh.submeshCount) * sizeof(model::Submesh);
+				if (sizeof(mesh) + submeshBytes + static_cast<uint64_t>(mesh.vertexCount) * sizeof(model::Vertex) + static_cast<uint64_t>(mesh.indexCount) * sizeof(uint32_t) != entry.size) fail("malformed mesh");
+				if (!validSubmeshes(data + entry.offset + sizeof(mesh), mesh.submeshCount, mesh.indexCount)) fail("malformed submeshes");
+			}
+			if (entry.type == AssetType::ENCODED_MESH) {
+				EncodedMeshHeader mesh = {};
+				if (entry.size < sizeof(mesh)) fail("malformed mesh");
+				std::memcpy(&mesh, data + entry.offset, sizeof(mesh));
+				uint64_t submeshBytes = static_cast<uint64_t>(mesh.submeshCount) * sizeof(model::Submesh);
+				if (sizeof(mesh) + submeshBytes + mesh.vertexBytes + mesh.indexBytes != entry.size) fail("malformed mesh");
+				if (!validSubmeshes(data + entry.offset + sizeof(mesh), mesh.submeshCount, mesh.indexCount)) fail("malformed submeshes");
+			}
+			if (entry.type == AssetType::PROGRESSIVE_MESH) {
+				ProgressiveMeshHeader mesh = {};
+				if (entry.size < sizeof(mesh)) fail("malformed mesh");
+				std::memcpy(&mesh, data + entry.offset, sizeof(mesh));
+				if (mesh.levelCount == 0 || mesh.levelCount > (entry.size - sizeof(mesh)) / sizeof(model::ProgressiveLevel)) fail("malformed mesh");
+				uint64_t meshSize = sizeof(mesh) + static_cast<uint64_t>(mesh.levelCount) * sizeof(model::ProgressiveLevel);
+				for (uint32_t level = 0; level < mesh.levelCount; level++) {
+					model::ProgressiveLevel levelInstance = {};
+					std::memcpy(&levelInstance, data + entry.offset + sizeof(mesh) + level * sizeof(levelInstance), sizeof(levelInstance));
+					meshSize += static_cast<uint64_t>(levelInstance.vertexCount) * sizeof(model::Vertex) + static_cast<uint64_t>(levelInstance.indexCount) * sizeof(uint32_t);
+				}
+				if (meshSize != entry.size) fail("malformed mesh");
+			}
+		}
+	}
+
+	assetPack::~assetPack() {
+		const assetPack* self = this;
+		mountedPack.compare_exchange_strong(self, nullptr);
+		unmap();
+	}
+
+	void assetPack::unmap() {
+		if (data == nullptr) return;
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+		CloseHandle(static_cast<HANDLE>(mappingHandle));
+		CloseHandle(static_cast<HANDLE>(fileHandle));
+#else
+		munmap(const_cast<char*>(data), static_cast<size_t>(size));
+#endif
+		data = nullptr;
+	}
+
+	std::unique_ptr<assetPack> assetPack::mountIfPresent(const std::string& filepath) {
+		if (!std::ifstream{ filepath, std::ios::binary }.is_open()) return nullptr;
+
+		auto pack = std::make_unique<assetPack>(filepath);
+		mountedPack.store(pack.get());
+		return pack;
+	}
+
+	const assetPack* assetPack::mounted() {
+		return mountedPack.load();
+	}
+
+	std::optional<assetPack::Asset> assetPack::find(const std::string& name) const {
+		lookups.fetch_add(1, std::memory_order_relaxed);
+		auto nameOf = [this](const Entry& entry) { return std::string_view{ nameData + entry.nameOffset, entry.nameLength }; };
+
+		std::string_view key{ name };
+		const Entry* end = entries + header->entryCount;
+		const Entry* found = std::lower_bound(entries, end, key, [&nameOf](const Entry& entry, std::string_view value) { return nameOf(entry) < value; });
+		if (found == end || nameOf(*found) != key) {
+			misses.fetch_add(1, std::memory_order_relaxed);
+			return std::nullopt;
+		}
+		return Asset{ data + found->offset, found->size, found->type };
+	}
+
+	model::MeshView assetPack::getMesh(const std::string& name) const {
+		std::optional<Asset> asset = find(name);
+		if (!asset || asset->type != AssetType::MESH) {
+			throw std::runtime_error("asset pack " + filepath + " has no mesh " + name + "!");
+		}
+
+		// the constructor checked the sizes, the arrays follow the header back to back
+		MeshHeader mesh = {};
+		std::memcpy(&mesh, asset->data, sizeof(mesh));
+		const char* vertexData = asset->data + sizeof(mesh) + static_cast<size_t>(mesh.submeshCount) * sizeof(model::Submesh);
+		model::MeshView view = {};
+		view.vertices = reinterpret_cast<const model::Vertex*>(vertexData);
+		view.vertexCount = mesh.vertexCount;
+		view.indices = reinterpret_cast<const uint32_t*>(vertexData + static_cast<size_t>(mesh.vertexCount) * sizeof(model::Vertex));
+		view.indexCount = mesh.indexCount;
+		view.submeshes = reinterpret_cast<const model::Submesh*>(asset->data + sizeof(mesh));
+		view.submeshCount = mesh.submeshCount;
+		return view;
+	}
+
+	model::EncodedMeshView assetPack::getEncodedMesh(const std::string& name) const {
+		std::optional<Asset> asset = find(name);
+		if (!asset || asset->type != AssetType::ENCODED_MESH) {
+			throw std::runtime_error("asset pack " + filepath + " has no encoded mesh " + name + "!");
+		}
+
+		EncodedMeshHeader mesh = {};
+		std::memcpy(&mesh, asset->data, sizeof(mesh));
+		model::EncodedMeshView view = {};
+		view.vertexCount = mesh.vertexCount;
+		view.indexCount = mesh.indexCount;
+		view.vertexData = asset->data + sizeof(mesh) + static_cast<size_t>(mesh.submeshCount) * sizeof(model::Submesh);
+		view.vertexBytes = mesh.vertexBytes;
+		view.indexData = view.vertexData + mesh.vertexBytes;
+		view.indexBytes = mesh.indexBytes;
+		view.submeshes = reinterpret_cast<const model::Submesh*>(asset->data + sizeof(mesh));
+		view.submeshCount = mesh.submeshCount;
+		return view;
+	}
+
+	model::ProgressiveMeshView assetPack::getProgressiveMesh(const std::string& name) const {
+		std::optional<Asset> asset = find(name);
+		if (!asset || asset->type != AssetType::PROGRESSIVE_MESH) {
+			throw std::runtime_error("asset pack " + filepath + " has no progressive mesh " + name + "!");
+		}
+
+		// the levels are laid out coarse to fine, so the first pages of the asset are all the first draw touches
+		ProgressiveMeshHeader mesh = {};
+		std::memcpy(&mesh, asset->data, sizeof(mesh));
+		const char* levelData = asset->data + sizeof(mesh) + static_cast<size_t>(mesh.levelCount) * sizeof(model::ProgressiveLevel);
+		model::ProgressiveMeshView view = {};
+		view.bounds = mesh.bounds;
+		view.levels.resize(mesh.levelCount);
+		for (uint32_t level = 0; level < mesh.levelCount; level++) {
+			model::ProgressiveLevel levelInstance = {};
+			std::memcpy(&levelInstance, asset->data + sizeof(mesh) + level * sizeof(levelInstance), sizeof(levelInstance));
+			model::ProgressiveMeshView::Level& viewLevel = view.levels[level];
+			viewLevel.vertices = reinterpret_cast<const model::Vertex*>(levelData);
+			viewLevel.vertexCount = levelInstance.vertexCount;
+			levelData += static_cast<size_t>(levelInstance.vertexCount) * sizeof(model::Vertex);
+			viewLevel.indices = reinterpret_cast<const uint32_t*>(levelData);
+			viewLevel.indexCount = levelInstance.indexCount;
+			levelData += static_cast<size_t>(levelInstance.indexCount) * sizeof(uint32_t);
+		}
+		return view;
+	}
+
+	std::vector<std::string> assetPack::names() const {
+		std::vector<std::string> result = {};
+		for (uint32_t i = 0; i < header->entryCount; i++) {
+			result.emplace_back(nameData + entries[i].nameOffset, entries[i].nameLength);
+		}
+		return result;
+	}
+
+	void assetPack::report(std::ostream& out) const {
+		out << "asset pack " << filepath << ": " << header->entryCount << " asset(s), " << size << " bytes mapped, "
+			<< lookups.load(std::memory_order_relaxed) << " lookup(s), " << misses.load(std::memory_order_relaxed) << " miss(es)" << std::endl;
+	}
+
+	std::vector<char> assetPack::cookMesh(const model::Builder& mesh) {
+		std::vector<model::Submesh> submeshes = mesh.getSubmeshes();
+		MeshHeader meshHeader = { static_cast<uint32_t>(mesh.vertices.size()), static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(submeshes.size()), 0 };
+		const char* vertexData = reinterpret_cast<const char*>(mesh.vertices.data());
+		const char* indexData = reinterpret_cast<const char*>(mesh.indices.data());
+
+		std::vector<char> bytes(sizeof(meshHeader));
+		std::memcpy(bytes.data(), &meshHeader, sizeof(meshHeader));
+		appendSubmeshes(bytes, submeshes);
+		bytes.insert(bytes.end(), vertexData, vertexData + mesh.vertices.size() * sizeof(model::Vertex));
+		bytes.insert(bytes.end(), indexData, indexData + mesh.indices.size() * sizeof(uint32_t));
+		return bytes;
+	}
+
+	std::vector<char> assetPack::cookEncodedMesh(const model::Builder& mesh) {
+		std::vector<char> vertices = meshCodec::encodeVertices(mesh.vertices.data(), static_cast<uint32_t>(mesh.vertices.size()), sizeof(model::Vertex));
+		std::vector<char> indices = meshCodec::encodeIndices(mesh.indices.data(), static_cast<uint32_t>(mesh.indices.size()));
+		std::vector<model::Submesh> submeshes = mesh.getSubmeshes();
+		EncodedMeshHeader meshHeader = { static_cast<uint32_t>(mesh.vertices.size()), static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(submeshes.size()), 0 };
+
+		std::vector<char> bytes(sizeof(meshHeader));
+		std::memcpy(bytes.data(), &meshHeader, sizeof(meshHeader));
+		appendSubmeshes(bytes, submeshes);
+		bytes.insert(bytes.end(), vertices.begin(), vertices.end());
+		bytes.insert(bytes.end(), indices.begin(), indices.end());
+		return bytes;
+	}
+
+	std::vector<char> assetPack::cookProgressiveMesh(model::Builder mesh, uint32_t levelCount) {
+		std::vector<model::ProgressiveLevel> levels = mesh.makeProgressive(levelCount);
+		ProgressiveMeshHeader meshHeader = { static_cast<uint32_t>(levels.size()), 0, mesh.getBounds() };
+
+		std::vector<char> bytes(sizeof(meshHeader) + levels.size() * sizeof(model::ProgressiveLevel));
+		std::memcpy(bytes.data(), &meshHeader, sizeof(meshHeader));
+		std::memcpy(bytes.data() + sizeof(meshHeader), levels.data(), levels.size() * sizeof(model::ProgressiveLevel));
+
+		// each level's new vertices next to its indices, so a level is one contiguous read
+		const char* vertexData = reinterpret_cast<const char*>(mesh.vertices.data());
+		const char* indexData = reinterpret_cast<const char*>(mesh.indices.data());
+		for (const auto& level : levels) {
+			size_t vertexBytes = static_cast<size_t>(level.vertexCount) * sizeof(model::Vertex);
+			size_t indexBytes = static_cast<size_t>(level.indexCount) * sizeof(uint32_t);
+			bytes.insert(bytes.end(), vertexData, vertexData + vertexBytes);
+			bytes.insert(bytes.end(), indexData, indexData + indexBytes);
+			vertexData += vertexBytes;
+			indexData += indexBytes;
+		}
+		return bytes;
+	}
+
+	void assetPack::write(const std::string& filepath, std::vector<Source> sources) {
+		// the table of contents is sorted so lookups can binary search it
+		std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.name < b.name; });
+		for (size_t i = 1; i < sources.size(); i++) {
+			if (sources[i].name == sources[i - 1].name) {
+				throw std::runtime_error("failed to write asset pack " + filepath + ": two assets are named " + sources[i].name + "!");
+			}
+		}
+
+		Header packHeader = {};
+		packHeader.magic = MAGIC;
+		packHeader.version = VERSION;
+		packHeader.entryCount = static_cast<uint32_t>(sources.size());
+		packHeader.vertexSize = sizeof(model::Vertex);
+		packHeader.tocOffset = sizeof(Header);
+		packHeader.namesOffset = packHeader.tocOffset + sources.size() * sizeof(Entry);
+
+		std::string names = {};
+		std::vector<Entry> packEntries(sources.size());
+		for (size_t i = 0; i < sources.size(); i++) {
+			packEntries[i].nameOffset = static_cast<uint32_t>(names.size());
+			packEntries[i].nameLength = static_cast<uint32_t>(sources[i].name.size());
+			packEntries[i].type = sources[i].type;
+			names += sources[i].name;
+		}
+		uint64_t offset = alignUp(packHeader.namesOffset + names.size(), ALIGNMENT);
+		for (size_t i = 0; i < sources.size(); i++) {
+			packEntries[i].offset = offset;
+			packEntries[i].size = sources[i].data.size();
+			offset = alignUp(offset + sources[i].data.size(), ALIGNMENT);
+		}
+
+		std::ofstream file{ filepath, std::ios::binary | std::ios::trunc };
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to create asset pack " + filepath + "!");
+		}
+		file.write(reinterpret_cast<const char*>(&packHeader), sizeof(packHeader));
+		file.write(reinterpret_cast<const char*>(packEntries.data()), static_cast<std::streamsize>(packEntries.size() * sizeof(Entry)));
+		file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+		// zero padding up to each asset's aligned offset
+		static const char padding[ALIGNMENT] = {};
+		uint64_t written = packHeader.namesOffset + names.size();
+		for (size_t i = 0; i < sources.size(); i++) {
+			file.write(padding, static_cast<std::streamsize>(packEntries[i].offset - written));
+			file.write(sources[i].data.data(), static_cast<std::streamsize>(sources[i].data.size()));
+			written = packEntries[i].offset + sources[i].data.size();
+		}
+		if (!file) {
+			throw std::runtime_error("failed to write asset pack " + filepath + "!");
+		}
+	}
+}
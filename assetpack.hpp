@@ -0,0 +1,122 @@
+#pragma once
+#include "model.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace engine {
+	// a read-only archive of cooked assets, written by tools/assetcooker.cpp
+	// the file is a header, a table of contents sorted by name, the names, then every asset starting on an ALIGNMENT
+	// boundary. It's mapped once when opened and assets are handed out as pointers into the mapping, so a lookup is a
+	// binary search with no reads or copies; SPIR-V goes to vkCreateShaderModule and meshes to the upload as they are
+	// the layout is native-endian and meant to be cooked on the architecture that loads it, like captures
+	class assetPack {
+	public:
+		static constexpr uint32_t MAGIC = 0x4b415045; // "EPAK"
+		static constexpr uint32_t VERSION = 2; // 2 added the submesh tables and progressive bounds
+		static constexpr uint64_t ALIGNMENT = 64; // every asset starts on a cache line, more than SPIR-V words or vertex floats need
+
+		enum class AssetType : uint32_t {
+			RAW = 0, // bytes as they were on disk, e.g. SPIR-V
+			MESH = 1, // a MeshHeader, its model::Submesh table, its model::Vertex array, then its uint32_t indices
+			ENCODED_MESH = 2, // an EncodedMeshHeader, its model::Submesh table, then the vertices and indices as compressed by meshCodec
+			PROGRESSIVE_MESH = 3, // a ProgressiveMeshHeader, its model::ProgressiveLevel table, then each level's new vertices and its indices, coarsest first
+		};
+
+		struct Header {
+			uint32_t magic;
+			uint32_t version;
+			uint32_t entryCount;
+			uint32_t vertexSize; // sizeof(model::Vertex) when cooked, a pack from a different vertex layout is refused
+			uint64_t tocOffset; // entryCount Entry structs, sorted by name
+			uint64_t namesOffset; // entry names, not null terminated
+		};
+
+		struct Entry {
+			uint64_t offset; // from the start of the file, a multiple of ALIGNMENT
+			uint64_t size;
+			uint32_t nameOffset; // from namesOffset
+			uint32_t nameLength;
+			AssetType type;
+			uint32_t reserved;
+		};
+
+		struct MeshHeader {
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			uint32_t submeshCount; // at least one, each within the indices
+			uint32_t reserved;
+		};
+
+		struct EncodedMeshHeader {
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			uint32_t vertexBytes; // size of the encoded vertex stream, the index stream follows it
+			uint32_t indexBytes;
+			uint32_t submeshCount; // at least one, each within the indices
+			uint32_t reserved;
+		};
+
+		struct ProgressiveMeshHeader {
+			uint32_t levelCount;
+			uint32_t reserved;
+			model::Bounds bounds; // of the full mesh; progressive meshes are drawn whole, so they have no submeshes
+		};
+
+		// one asset's bytes inside the mapping, valid as long as the pack
+		struct Asset {
+			const char* data = nullptr;
+			uint64_t size = 0;
+			AssetType type = AssetType::RAW;
+		};
+
+		// an asset for write(), named the way the engine asks for it, e.g. "simple_shader.vert.spv"
+		struct Source {
+			std::string name;
+			AssetType type = AssetType::RAW;
+			std::vector<char> data = {};
+		};
+
+		assetPack(const std::string& filepath); // constructor, maps the file; throws if it can't be opened or isn't a valid pack
+		~assetPack(); // destructor, unmounts the pack if it's mounted and unmaps it
+
+		// not copyable or movable
+		assetPack(const assetPack&) = delete;
+		assetPack& operator = (const assetPack&) = delete;
+
+		// opens the pack at filepath and mounts it, or returns null when there's no such file so loose files are used instead
+		static std::unique_ptr<assetPack> mountIfPresent(const std::string& filepath);
+		static const assetPack* mounted(); // the pack pipelines load shaders from, null when running from loose files
+
+		std::optional<Asset> find(const std::string& name) const; // safe to call from several threads
+		model::MeshView getMesh(const std::string& name) const; // throws if the asset is missing or not a mesh
+		model::EncodedMeshView getEncodedMesh(const std::string& name) const; // throws if the asset is missing or not an encoded mesh
+		model::ProgressiveMeshView getProgressiveMesh(const std::string& name) const; // throws if the asset is missing or not a progressive mesh
+		std::vector<std::string> names() const; // every asset name, in table of contents order
+
+		void report(std::ostream& out) const; // file, assets, mapped bytes and lookups served
+
+		static std::vector<char> cookMesh(const model::Builder& mesh); // the bytes of a MESH asset
+		static std::vector<char> cookEncodedMesh(const model::Builder& mesh); // the bytes of an ENCODED_MESH asset
+		static std::vector<char> cookProgressiveMesh(model::Builder mesh, uint32_t levelCount); // the bytes of a PROGRESSIVE_MESH asset
+		static void write(const std::string& filepath, std::vector<Source> sources); // throws on duplicate names or write failures
+
+	private:
+		void unmap();
+
+		std::string filepath;
+		const char* data = nullptr; // the whole file, mapped read-only
+		uint64_t size = 0;
+		const Header* header = nullptr;
+		const Entry* entries = nullptr;
+		const char* nameData = nullptr;
+		void* fileHandle = nullptr; // platform specific handles for the mapping
+		void* mappingHandle = nullptr;
+		mutable std::atomic<uint64_t> lookups{ 0 };
+		mutable std::atomic<uint64_t> misses{ 0 };
+	};
+}
@@ -0,0 +1,477 @@
+#include "assetreader.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ENGINE_ASSET_PREAD
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#define ENGINE_ASSET_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace engine {
+	// open for reading, returning the descriptor and size, or -1 with errno set; the descriptor is unused without pread
+	static int openFile(const std::string& filepath, uint64_t& size) {
+#ifdef ENGINE_ASSET_PREAD
+		int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) return -1;
+		struct stat status = {};
+		if (::fstat(fd, &status) != 0) {
+			int error = errno;
+			::close(fd);
+			errno = error;
+			return -1;
+		}
+		size = static_cast<uint64_t>(status.st_size);
+		return fd;
+#else
+		std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
+		if (!file.is_open()) {
+			errno = ENOENT;
+			return -1;
+		}
+		size = static_cast<uint64_t>(file.tellg());
+		return 0;
+#endif
+	}
+
+	static void closeFile(int fd) {
+#ifdef ENGINE_ASSET_PREAD
+		if (fd >= 0) ::close(fd);
+#else
+		(void)fd;
+#endif
+	}
+
+	// read until size bytes arrived, the file ended or an error; returns the bytes read and sets error to an errno value
+	static uint64_t readAt(int fd, const std::string& filepath, char* destination, uint64_t size, uint64_t offset, int& error) {
+		error = 0;
+#ifdef ENGINE_ASSET_PREAD
+		(void)filepath;
+		uint64_t done = 0;
+		while (done < size) {
+			ssize_t result = ::pread(fd, destination + done, static_cast<size_t>(size - done), static_cast<off_t>(offset + done));
+			if (result < 0) {
+				if (errno == EINTR) continue;
+				error = errno;
+				break;
+			}
+			if (result == 0) break;
+			done += static_cast<uint64_t>(result);
+		}
+		return done;
+#else
+		// no positioned reads, every chunk opens its own stream so workers don't share a file position
+		(void)fd;
+		std::ifstream file{ filepath, std::ios::binary };
+		file.seekg(static_cast<std::streamoff>(offset));
+		file.read(destination, static_cast<std::streamsize>(size));
+		if (file.bad()) error = EIO;
+		return static_cast<uint64_t>(file.gcount());
+#endif
+	}
+
+#ifdef ENGINE_ASSET_IO_URING
+	// the rings shared with the kernel, mapped as described by io_uring_setup(2); there is no liburing dependency
+	struct assetReader::Ring {
+		int fd = -1;
+		void* submissionMemory = MAP_FAILED;
+		size_t submissionMemorySize = 0;
+		void* completionMemory = MAP_FAILED;
+		size_t completionMemorySize = 0;
+		io_uring_sqe* entries = static_cast<io_uring_sqe*>(MAP_FAILED);
+		size_t entriesSize = 0;
+
+		unsigned* submissionTail = nullptr;
+		unsigned* submissionMask = nullptr;
+		unsigned* submissionArray = nullptr;
+		unsigned* completionHead = nullptr;
+		unsigned* completionTail = nullptr;
+		unsigned* completionMask = nullptr;
+		io_uring_cqe* completions = nullptr;
+
+		std::vector<Chunk> slots = {}; // chunks in flight, indexed by the user data of their entry
+		std::vector<iovec> vectors = {}; // one per slot, read by the kernel until the chunk completes
+		std::vector<uint32_t> freeSlots = {};
+
+		bool create(uint32_t depth) {
+			io_uring_params params = {};
+			fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+			if (fd < 0) return false;
+
+			submissionMemorySize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			completionMemorySize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (singleMapping) {
+				submissionMemorySize = completionMemorySize = std::max(submissionMemorySize, completionMemorySize);
+			}
+
+			submissionMemory = mmap(nullptr, submissionMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+			if (submissionMemory == MAP_FAILED) return false;
+			completionMemory = singleMapping ? submissionMemory : mmap(nullptr, completionMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+			if (completionMemory == MAP_FAILED) return false;
+			entriesSize = params.sq_entries * sizeof(io_uring_sqe);
+			entries = static_cast<io_uring_sqe*>(mmap(nullptr, entriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+			if (entries == MAP_FAILED) return false;
+
+			char* submission = static_cast<char*>(submissionMemory);
+			char* completion = static_cast<char*>(completionMemory);
+			submissionTail = reinterpret_cast<unsigned*>(submission + params.sq_off.tail);
+			submissionMask = reinterpret_cast<unsigned*>(submission + params.sq_off.ring_mask);
+			submissionArray = reinterpret_cast<unsigned*>(submission + params.sq_off.array);
+			completionHead = reinterpret_cast<unsigned*>(completion + params.cq_off.head);
+			completionTail = reinterpret_cast<unsigned*>(completion + params.cq_off.tail);
+			completionMask = reinterpret_cast<unsigned*>(completion + params.cq_off.ring_mask);
+			completions = reinterpret_cast<io_uring_cqe*>(completion + params.cq_off.cqes);
+
+			// never more chunks in flight than submission entries, so the completion ring (twice as large) can't overflow
+			slots.resize(params.sq_entries);
+			vectors.resize(params.sq_entries);
+			for (uint32_t i = params.sq_entries; i > 0; i--) {
+				freeSlots.push_back(i - 1);
+			}
+			return true;
+		}
+
+		~Ring() {
+			if (entries != MAP_FAILED) munmap(entries, entriesSize);
+			if (completionMemory != MAP_FAILED && completionMemory != submissionMemory) munmap(completionMemory, completionMemorySize);
+			if (submissionMemory != MAP_FAILED) munmap(submissionMemory, submissionMemorySize);
+			if (fd >= 0) ::close(fd);
+		}
+	};
+#else
+	struct assetReader::Ring {};
+#endif
+
+	assetReader::assetReader(uint32_t queueDepth, uint32_t threadCount, Backend preferred) : queueDepth{ std::max(queueDepth, 1u) }, threadCount{ std::max(threadCount, 1u) } {
+#ifdef ENGINE_ASSET_IO_URING
+		if (preferred == Backend::IO_URING) {
+			ring = std::make_unique<Ring>();
+			if (ring->create(this->queueDepth)) {
+				backend = Backend::IO_URING;
+				threads.emplace_back(&assetReader::ringLoop, this);
+				return;
+			}
+			ring.reset();
+		}
+#else
+		(void)preferred;
+#endif
+		for (uint32_t i = 0; i < this->threadCount; i++) {
+			threads.emplace_back(&assetReader::poolLoop, this);
+		}
+	}
+
+	assetReader::~assetReader() {
+		wait();
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+		}
+		workAvailable.notify_all();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	void assetReader::read(const std::string& filepath, void* destination, uint64_t size, uint64_t offset, Callback callback) {
+		uint64_t fileBytes = 0;
+		int fd = openFile(filepath, fileBytes);
+		if (fd < 0) {
+			callback(errno, 0);
+			return;
+		}
+
+		auto request = std::make_shared<Request>();
+		request->filepath = filepath;
+		request->fd = fd;
+		request->callback = std::move(callback);
+		submit(std::move(request), static_cast<char*>(destination), size, offset);
+	}
+
+	std::future<std::vector<char>> assetReader::readFile(const std::string& filepath) {
+		auto promise = std::make_shared<std::promise<std::vector<char>>>();
+		std::future<std::vector<char>> result = promise->get_future();
+
+		uint64_t size = 0;
+		int fd = openFile(filepath, size);
+		if (fd < 0) {
+			promise->set_exception(std::make_exception_ptr(std::runtime_error("failed to open file: " + filepath)));
+			return result;
+		}
+
+		// the vector is filled in place and moved into the future once complete
+		auto data = std::make_shared<std::vector<char>>(size);
+		auto request = std::make_shared<Request>();
+		request->filepath = filepath;
+		request->fd = fd;
+		request->callback = [promise, data, filepath](int error, uint64_t bytes) {
+			if (error != 0) {
+				promise->set_exception(std::make_exception_ptr(std::runtime_error("failed to read file: " + filepath + ": " + std::strerror(error))));
+				return;
+			}
+			data->resize(bytes);
+			promise->set_value(std::move(*data));
+		};
+		submit(std::move(request), data->data(), size, 0);
+		return result;
+	}
+
+	void assetReader::submit(std::shared_ptr<Request> request, char* destination, uint64_t size, uint64_t offset) {
+		uint32_t chunkCount = static_cast<uint32_t>((size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+		if (chunkCount == 0) {
+			closeFile(request->fd);
+			request->callback(0, 0);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			request->chunksLeft = chunkCount;
+			for (uint64_t chunkOffset = 0; chunkOffset < size; chunkOffset += CHUNK_SIZE) {
+				pending.push_back({ request, destination + chunkOffset, std::min(CHUNK_SIZE, size - chunkOffset), offset + chunkOffset });
+			}
+			outstanding++;
+		}
+		workAvailable.notify_all();
+	}
+
+	void assetReader::finishChunk(const Chunk& chunk, uint64_t chunkBytes, int error) {
+		std::shared_ptr<Request> request = chunk.request;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			chunksCompleted++;
+			bytesRead += chunkBytes;
+			request->bytesRead += chunkBytes;
+			if (error != 0 && request->error == 0) request->error = error;
+			if (--request->chunksLeft > 0) return;
+		}
+
+		// the last chunk: the callback runs outside the lock so it may submit more reads
+		closeFile(request->fd);
+		request->callback(request->error, request->bytesRead);
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			requestsCompleted++;
+			if (request->error != 0) requestsFailed++;
+			outstanding--;
+		}
+		allDone.notify_all();
+	}
+
+	void assetReader::wait() {
+		std::unique_lock<std::mutex> lock{ mutex };
+		allDone.wait(lock, [this]() { return outstanding == 0; });
+	}
+
+	// *************** Backends *********************
+
+	void assetReader::poolLoop() {
+		while (true) {
+			Chunk chunk = {};
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				workAvailable.wait(lock, [this]() { return stopping || !pending.empty(); });
+				if (pending.empty()) return; // stopping with nothing left
+				chunk = std::move(pending.front());
+				pending.pop_front();
+				inFlight++;
+				peakInFlight = std::max(peakInFlight, inFlight);
+			}
+
+			int error = 0;
+			uint64_t chunkBytes = readAt(chunk.request->fd, chunk.request->filepath, chunk.destination, chunk.size, chunk.offset, error);
+			if (error == 0 && chunkBytes < chunk.size) error = EIO; // the file is shorter than requested
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				inFlight--;
+			}
+			finishChunk(chunk, chunkBytes, error);
+		}
+	}
+
+	void assetReader::ringLoop() {
+#ifdef ENGINE_ASSET_IO_URING
+		unsigned unsubmitted = 0; // entries the kernel didn't take last time, still in the submission ring
+		while (true) {
+			// move queued chunks into free slots and submission entries; this thread is the only one touching the rings
+			unsigned toSubmit = unsubmitted;
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				workAvailable.wait(lock, [this]() { return stopping || !pending.empty() || inFlight > 0; });
+				if (stopping && pending.empty() && inFlight == 0) return;
+
+				unsigned tail = *ring->submissionTail;
+				while (!pending.empty() && !ring->freeSlots.empty()) {
+					uint32_t slot = ring->freeSlots.back();
+					ring->freeSlots.pop_back();
+					Chunk& chunk = ring->slots[slot];
+					chunk = std::move(pending.front());
+					pending.pop_front();
+
+					// readv rather than read, it's been available since io_uring itself (5.1)
+					ring->vectors[slot] = { chunk.destination, static_cast<size_t>(chunk.size) };
+					unsigned index = tail & *ring->submissionMask;
+					io_uring_sqe& entry = ring->entries[index];
+					std::memset(&entry, 0, sizeof(entry));
+					entry.opcode = IORING_OP_READV;
+					entry.fd = chunk.request->fd;
+					entry.addr = reinterpret_cast<uint64_t>(&ring->vectors[slot]);
+					entry.len = 1;
+					entry.off = chunk.offset;
+					entry.user_data = slot;
+					ring->submissionArray[index] = index;
+					tail++;
+					toSubmit++;
+					inFlight++;
+				}
+				peakInFlight = std::max(peakInFlight, inFlight);
+				__atomic_store_n(ring->submissionTail, tail, __ATOMIC_RELEASE);
+			}
+
+			// submit and wait for at least one completion in the same call; a full completion queue (EAGAIN, EBUSY) is drained first
+			int error = 0;
+			while (true) {
+				long result = syscall(__NR_io_uring_enter, ring->fd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+				if (result >= 0) {
+					unsubmitted = toSubmit - std::min(toSubmit, static_cast<unsigned>(result));
+					break;
+				}
+				if (errno == EINTR) continue;
+				if (errno != EAGAIN && errno != EBUSY) {
+					error = errno;
+					break;
+				}
+				if (reapCompletions() == 0) std::this_thread::yield();
+			}
+			if (error != 0) {
+				abandonRing(error);
+				return;
+			}
+			reapCompletions();
+		}
+#endif
+	}
+
+#ifdef ENGINE_ASSET_IO_URING
+	unsigned assetReader::reapCompletions() {
+		unsigned head = *ring->completionHead;
+		unsigned tail = __atomic_load_n(ring->completionTail, __ATOMIC_ACQUIRE);
+		unsigned reaped = tail - head;
+		while (head != tail) {
+			const io_uring_cqe& completion = ring->completions[head & *ring->completionMask];
+			uint32_t slot = static_cast<uint32_t>(completion.user_data);
+			int result = completion.res;
+			head++;
+
+			Chunk chunk = std::move(ring->slots[slot]);
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				ring->freeSlots.push_back(slot);
+				inFlight--;
+
+				// a short read of a regular file, queue the remainder ahead of everything else
+				if (result > 0 && static_cast<uint64_t>(result) < chunk.size) {
+					shortReads++;
+					chunksCompleted--; // finishChunk below counts the chunk once, when the rest arrives
+					Chunk rest = chunk;
+					rest.destination += result;
+					rest.size -= static_cast<uint64_t>(result);
+					rest.offset += static_cast<uint64_t>(result);
+					rest.request->chunksLeft++;
+					pending.push_front(std::move(rest));
+				}
+			}
+
+			if (result < 0) finishChunk(chunk, 0, -result);
+			else if (result == 0) finishChunk(chunk, 0, EIO); // the file is shorter than requested
+			else finishChunk(chunk, std::min(static_cast<uint64_t>(result), chunk.size), 0);
+		}
+		__atomic_store_n(ring->completionHead, head, __ATOMIC_RELEASE);
+		return reaped;
+	}
+
+	void assetReader::abandonRing(int error) {
+		std::cerr << "io_uring_enter failed, falling back to the thread pool: " << std::strerror(error) << std::endl;
+
+		// every chunk given to the ring or waiting for it fails; the pool takes over from the next read on
+		std::vector<Chunk> failed = {};
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			std::vector<bool> freeSlot(ring->slots.size());
+			for (uint32_t slot : ring->freeSlots) {
+				freeSlot[slot] = true;
+			}
+			for (uint32_t slot = 0; slot < ring->slots.size(); slot++) {
+				if (!freeSlot[slot]) failed.push_back(std::move(ring->slots[slot]));
+			}
+			inFlight = 0;
+			for (auto& chunk : pending) {
+				failed.push_back(std::move(chunk));
+			}
+			pending.clear();
+
+			// the failed chunks keep their requests outstanding, so the destructor is still in wait() and not walking threads
+			backend = Backend::THREAD_POOL;
+			for (uint32_t i = 0; i < threadCount; i++) {
+				threads.emplace_back(&assetReader::poolLoop, this);
+			}
+		}
+
+		// closing the ring cancels what the kernel still holds before the callbacks can release the destinations
+		ring.reset();
+		for (const auto& chunk : failed) {
+			finishChunk(chunk, 0, error);
+		}
+	}
+#endif
+
+	// *************** Utilities *********************
+
+	uint64_t assetReader::fileSize(const std::string& filepath) {
+		uint64_t size = 0;
+		int fd = openFile(filepath, size);
+		if (fd < 0) {
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+		closeFile(fd);
+		return size;
+	}
+
+	std::vector<char> assetReader::readFileBlocking(const std::string& filepath) {
+		uint64_t size = 0;
+		int fd = openFile(filepath, size);
+		if (fd < 0) {
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+
+		std::vector<char> data(size);
+		int error = 0;
+		uint64_t bytes = readAt(fd, filepath, data.data(), size, 0, error);
+		closeFile(fd);
+		if (error != 0 || bytes != size) {
+			throw std::runtime_error("failed to read file: " + filepath);
+		}
+		return data;
+	}
+
+	void assetReader::report(std::ostream& out) const {
+		std::lock_guard<std::mutex> lock{ mutex };
+		out << "asset reader (" << (backend == Backend::IO_URING ? "io_uring" : "thread pool") << "): " << requestsCompleted << " read(s), " << requestsFailed << " failed, "
+			<< bytesRead / (1024 * 1024) << " MiB in " << chunksCompleted << " chunk(s), " << shortReads << " short read(s), peak " << peakInFlight << " in flight" << std::endl;
+	}
+}
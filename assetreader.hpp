@@ -0,0 +1,93 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace engine {
+	// asynchronous file reads for asset loading, built to keep many large reads in flight at once
+	// on Linux the reads go through an io_uring driven by one thread; where io_uring is missing or blocked (old kernels,
+	// seccomp) and on other platforms, a pool of threads issues plain positioned reads instead
+	// callers hand in the destination, e.g. a mapped staging buffer, so data lands where it's used without an extra copy
+	class assetReader {
+	public:
+		static constexpr uint64_t CHUNK_SIZE = 1024 * 1024; // large reads are split so they spread over the queue and short reads retry cheaply
+
+		enum class Backend { IO_URING, THREAD_POOL };
+
+		// runs on a reader thread once every byte has arrived or the read failed; error is 0 or an errno value
+		// keep it short, e.g. hand the data to a parse task, since it holds up the completions behind it
+		using Callback = std::function<void(int error, uint64_t bytesRead)>;
+
+		assetReader(uint32_t queueDepth = 64, uint32_t threadCount = 4, Backend preferred = Backend::IO_URING); // constructor, starts the reader threads
+		~assetReader(); // destructor, finishes every outstanding read
+
+		// not copyable or movable
+		assetReader(const assetReader&) = delete;
+		assetReader& operator = (const assetReader&) = delete;
+
+		void read(const std::string& filepath, void* destination, uint64_t size, uint64_t offset, Callback callback); // size bytes at offset into destination
+		std::future<std::vector<char>> readFile(const std::string& filepath); // a whole file into owned memory, failures are stored in the future
+		void wait(); // until every read submitted so far has completed
+
+		Backend getBackend() const { return backend; }
+		void report(std::ostream& out) const; // backend, reads, bytes and peak queue occupancy
+
+		static uint64_t fileSize(const std::string& filepath); // throws if the file can't be opened
+		static std::vector<char> readFileBlocking(const std::string& filepath); // one unbuffered read on the calling thread, throws on failure
+
+	private:
+		struct Ring; // io_uring state, kept out of the header with the Linux includes
+
+		struct Request {
+			std::string filepath;
+			int fd = -1;
+			Callback callback;
+			uint64_t bytesRead = 0; // guarded by the reader mutex, like the rest of the request
+			uint32_t chunksLeft = 0;
+			int error = 0;
+		};
+
+		struct Chunk {
+			std::shared_ptr<Request> request;
+			char* destination;
+			uint64_t size;
+			uint64_t offset;
+		};
+
+		void submit(std::shared_ptr<Request> request, char* destination, uint64_t size, uint64_t offset); // split into chunks and queue them
+		void finishChunk(const Chunk& chunk, uint64_t bytesRead, int error); // account a chunk, completing its request after the last one
+		void ringLoop(); // the io_uring submission and completion thread
+		void poolLoop(); // a thread pool worker
+		unsigned reapCompletions(); // finish every chunk the kernel completed, returns how many
+		void abandonRing(int error); // fail everything queued or in flight and hand later reads to a thread pool
+
+		Backend backend = Backend::THREAD_POOL;
+		uint32_t queueDepth;
+		uint32_t threadCount; // pool workers, started instead of the ring or after giving it up
+		std::unique_ptr<Ring> ring;
+		std::vector<std::thread> threads = {};
+
+		mutable std::mutex mutex; // guards the queue, the requests and the statistics
+		std::condition_variable workAvailable; // signaled when chunks are queued or on shutdown
+		std::condition_variable allDone; // signaled when the last outstanding request completes
+		std::deque<Chunk> pending = {}; // chunks waiting for a queue slot or a worker
+		uint64_t outstanding = 0; // requests submitted but not completed
+		uint32_t inFlight = 0; // chunks handed to the kernel or a worker
+		bool stopping = false;
+
+		uint64_t requestsCompleted = 0;
+		uint64_t requestsFailed = 0;
+		uint64_t chunksCompleted = 0;
+		uint64_t shortReads = 0; // chunks the kernel returned partially, resubmitted for the rest
+		uint64_t bytesRead = 0;
+		uint32_t peakInFlight = 0;
+	};
+}
@@ -0,0 +1,380 @@
+#include "benchmark.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace engine {
+	static double percentile(const std::vector<double>& sorted, double fraction) {
+		if (sorted.empty()) return 0.0;
+		double position = fraction * static_cast<double>(sorted.size() - 1);
+		size_t lower = static_cast<size_t>(position);
+		size_t upper = std::min(lower + 1, sorted.size() - 1);
+		double weight = position - static_cast<double>(lower);
+		return sorted[lower] * (1.0 - weight) + sorted[upper] * weight;
+	}
+
+	static std::string escapeJson(const std::string& text) {
+		std::string escaped = {};
+		for (char c : text) {
+			switch (c) {
+			case '"': escaped += "\\\""; break;
+			case '\\': escaped += "\\\\"; break;
+			case '\n': escaped += "\\n"; break;
+			case '\t': escaped += "\\t"; break;
+			default: escaped += c; break;
+			}
+		}
+		return escaped;
+	}
+
+	// minimal JSON reader, just enough for the files writeJson produces and hand-edited variants of them
+	struct JsonValue {
+		enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+		Type type = Type::NUL;
+		double number = 0.0;
+		std::string text = {};
+		std::vector<JsonValue> items = {};
+		std::vector<std::pair<std::string, JsonValue>> members = {};
+
+		const JsonValue* find(const std::string& key) const {
+			for (const auto& member : members) {
+				if (member.first == key) return &member.second;
+			}
+			return nullptr;
+		}
+	};
+
+	class jsonParser {
+	public:
+		jsonParser(const std::string& text, const std::string& source) : text{ text }, source{ source } {}
+
+		JsonValue parseDocument() {
+			JsonValue value = parseValue();
+			skipWhitespace();
+			if (position != text.size()) fail("trailing characters");
+			return value;
+		}
+
+	private:
+		[[noreturn]] void fail(const std::string& what) const {
+			throw std::runtime_error("failed to parse benchmark file " + source + ": " + what + " at offset " + std::to_string(position));
+		}
+
+		void skipWhitespace() {
+			while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position]))) position++;
+		}
+
+		void expect(char c) {
+			skipWhitespace();
+			if (position >= text.size() || text[position] != c) fail(std::string{ "expected '" } + c + "'");
+			position++;
+		}
+
+		bool consume(const char* literal) {
+			size_t length = std::char_traits<char>::length(literal);
+			if (text.compare(position, length, literal) != 0) return false;
+			position += length;
+			return true;
+		}
+
+		JsonValue parseValue() {
+			skipWhitespace();
+			if (position >= text.size()) fail("unexpected end of file");
+
+			JsonValue value = {};
+			char c = text[position];
+			if (c == '{') {
+				value.type = JsonValue::Type::OBJECT;
+				position++;
+				skipWhitespace();
+				if (position < text.size() && text[position] == '}') {
+					position++;
+					return value;
+				}
+				do {
+					skipWhitespace();
+					std::string key = parseString();
+					expect(':');
+					value.members.emplace_back(std::move(key), parseValue());
+					skipWhitespace();
+				} while (position < text.size() && text[position] == ',' && ++position);
+				expect('}');
+			}
+			else if (c == '[') {
+				value.type = JsonValue::Type::ARRAY;
+				position++;
+				skipWhitespace();
+				if (position < text.size() && text[position] == ']') {
+					position++;
+					return value;
+				}
+				do {
+					value.items.push_back(parseValue());
+					skipWhitespace();
+				} while (position < text.size() && text[position] == ',' && ++position);
+				expect(']');
+			}
+			else if (c == '"') {
+				value.type = JsonValue::Type::STRING;
+				value.text = parseString();
+			}
+			else if (consume("true")) {
+				value.type = JsonValue::Type::BOOLEAN;
+				value.number = 1.0;
+			}
+			else if (consume("false")) {
+				value.type = JsonValue::Type::BOOLEAN;
+			}
+			else if (consume("null")) {
+				value.type = JsonValue::Type::NUL;
+			}
+			else {
+				const char* start = text.c_str() + position;
+				char* end = nullptr;
+				value.type = JsonValue::Type::NUMBER;
+				value.number = std::strtod(start, &end);
+				if (end == start) fail("unexpected character");
+				position += static_cast<size_t>(end - start);
+			}
+			return value;
+		}
+
+		std::string parseString() {
+			if (position >= text.size() || text[position] != '"') fail("expected a string");
+			position++;
+			std::string result = {};
+			while (position < text.size() && text[position] != '"') {
+				char c = text[position++];
+				if (c != '\\') {
+					result += c;
+					continue;
+				}
+				if (position >= text.size()) break;
+				char escaped = text[position++];
+				switch (escaped) {
+				case 'n': result += '\n'; break;
+				case 't': result += '\t'; break;
+				case 'r': result += '\r'; break;
+				case 'b': result += '\b'; break;
+				case 'f': result += '\f'; break;
+				case 'u': {
+					// names and context are ASCII in practice, anything wider is kept as a placeholder
+					if (position + 4 > text.size()) fail("truncated escape");
+					unsigned long code = std::strtoul(text.substr(position, 4).c_str(), nullptr, 16);
+					result += code < 0x80 ? static_cast<char>(code) : '?';
+					position += 4;
+					break;
+				}
+				default: result += escaped; break;
+				}
+			}
+			if (position >= text.size()) fail("unterminated string");
+			position++;
+			return result;
+		}
+
+		const std::string& text;
+		const std::string& source; // file name for error messages
+		size_t position = 0;
+	};
+
+	// two-sided p-value of the Mann-Whitney U test, with the normal approximation corrected for ties
+	static double mannWhitneyPValue(const std::vector<double>& first, const std::vector<double>& second) {
+		std::vector<std::pair<double, bool>> combined = {};
+		combined.reserve(first.size() + second.size());
+		for (double sample : first) combined.emplace_back(sample, true);
+		for (double sample : second) combined.emplace_back(sample, false);
+		std::sort(combined.begin(), combined.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+		double n1 = static_cast<double>(first.size());
+		double n2 = static_cast<double>(second.size());
+		double n = n1 + n2;
+		double firstRankSum = 0.0;
+		double tieTerm = 0.0;
+		for (size_t i = 0; i < combined.size();) {
+			size_t j = i;
+			while (j < combined.size() && combined[j].first == combined[i].first) j++;
+			double averageRank = 0.5 * static_cast<double>(i + 1 + j); // ranks i+1 .. j share their mean
+			for (size_t k = i; k < j; k++) {
+				if (combined[k].second) firstRankSum += averageRank;
+			}
+			double ties = static_cast<double>(j - i);
+			tieTerm += ties * ties * ties - ties;
+			i = j;
+		}
+
+		double u = firstRankSum - n1 * (n1 + 1.0) / 2.0;
+		double mean = n1 * n2 / 2.0;
+		double variance = n1 * n2 / 12.0 * ((n + 1.0) - tieTerm / (n * (n - 1.0)));
+		if (variance <= 0.0) return 1.0; // every sample identical
+		double z = (std::abs(u - mean) - 0.5) / std::sqrt(variance); // with continuity correction
+		return z <= 0.0 ? 1.0 : std::erfc(z / std::sqrt(2.0));
+	}
+
+	BenchmarkComparison BenchmarkComparison::compare(const BenchmarkResult& baseline, const BenchmarkResult& candidate, double threshold, double alpha) {
+		BenchmarkComparison comparison = {};
+		comparison.baselineMedian = BenchmarkStats::compute(baseline.samples).median;
+		comparison.candidateMedian = BenchmarkStats::compute(candidate.samples).median;
+		comparison.change = comparison.baselineMedian > 0.0 ? comparison.candidateMedian / comparison.baselineMedian - 1.0 : 0.0;
+
+		bool testable = baseline.samples.size() >= 3 && candidate.samples.size() >= 3;
+		comparison.pValue = testable ? mannWhitneyPValue(baseline.samples, candidate.samples) : std::nan("");
+		bool significant = !testable || comparison.pValue < alpha;
+
+		if (significant && comparison.change > threshold) comparison.verdict = Verdict::REGRESSION;
+		else if (significant && comparison.change < -threshold) comparison.verdict = Verdict::IMPROVEMENT;
+		return comparison;
+	}
+
+	BenchmarkStats BenchmarkStats::compute(std::vector<double> samples) {
+		BenchmarkStats stats = {};
+		if (samples.empty()) return stats;
+
+		std::sort(samples.begin(), samples.end());
+		stats.min = samples.front();
+		stats.max = samples.back();
+		stats.median = percentile(samples, 0.5);
+		stats.p95 = percentile(samples, 0.95);
+		stats.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+
+		double variance = 0.0;
+		for (double sample : samples) {
+			variance += (sample - stats.mean) * (sample - stats.mean);
+		}
+		stats.stddev = samples.size() > 1 ? std::sqrt(variance / static_cast<double>(samples.size() - 1)) : 0.0;
+
+		std::vector<double> deviations = {};
+		deviations.reserve(samples.size());
+		for (double sample : samples) {
+			deviations.push_back(std::abs(sample - stats.median));
+		}
+		std::sort(deviations.begin(), deviations.end());
+		stats.mad = percentile(deviations, 0.5);
+
+		return stats;
+	}
+
+	// *************** Benchmark Suite *********************
+
+	benchmarkSuite::benchmarkSuite(std::string suiteName) : benchmarkSuite{ std::move(suiteName), Options{} } {}
+
+	benchmarkSuite::benchmarkSuite(std::string suiteName, Options options) : suiteName{ std::move(suiteName) }, options{ options } {}
+
+	void benchmarkSuite::addResult(BenchmarkResult result) {
+		results.push_back(std::move(result));
+	}
+
+	void benchmarkSuite::setContext(const std::string& key, const std::string& value) {
+		for (auto& entry : context) {
+			if (entry.first == key) {
+				entry.second = value;
+				return;
+			}
+		}
+		context.emplace_back(key, value);
+	}
+
+	void benchmarkSuite::printSummary(std::ostream& out) const {
+		out << std::left << std::setw(40) << suiteName << std::right
+			<< std::setw(12) << "median" << std::setw(12) << "mad" << std::setw(12) << "min" << std::setw(12) << "p95" << "  unit" << std::endl;
+		for (const auto& result : results) {
+			BenchmarkStats stats = BenchmarkStats::compute(result.samples);
+			out << std::left << std::setw(40) << result.name << std::right << std::fixed << std::setprecision(3)
+				<< std::setw(12) << stats.median << std::setw(12) << stats.mad << std::setw(12) << stats.min << std::setw(12) << stats.p95
+				<< "  " << result.unit << std::endl;
+		}
+	}
+
+	void benchmarkSuite::writeJson(std::ostream& out) const {
+		out << std::setprecision(9);
+		out << "{\n  \"suite\": \"" << escapeJson(suiteName) << "\",\n  \"context\": {";
+		for (size_t i = 0; i < context.size(); i++) {
+			out << (i == 0 ? "\n" : ",\n") << "    \"" << escapeJson(context[i].first) << "\": \"" << escapeJson(context[i].second) << "\"";
+		}
+		out << (context.empty() ? "},\n" : "\n  },\n");
+
+		out << "  \"results\": [";
+		for (size_t i = 0; i < results.size(); i++) {
+			const auto& result = results[i];
+			BenchmarkStats stats = BenchmarkStats::compute(result.samples);
+			out << (i == 0 ? "\n" : ",\n")
+				<< "    {\n"
+				<< "      \"name\": \"" << escapeJson(result.name) << "\",\n"
+				<< "      \"unit\": \"" << escapeJson(result.unit) << "\",\n"
+				<< "      \"items_per_sample\": " << result.itemsPerSample << ",\n"
+				<< "      \"median\": " << stats.median << ",\n"
+				<< "      \"mean\": " << stats.mean << ",\n"
+				<< "      \"stddev\": " << stats.stddev << ",\n"
+				<< "      \"mad\": " << stats.mad << ",\n"
+				<< "      \"min\": " << stats.min << ",\n"
+				<< "      \"max\": " << stats.max << ",\n"
+				<< "      \"p95\": " << stats.p95 << ",\n"
+				<< "      \"samples\": [";
+			for (size_t j = 0; j < result.samples.size(); j++) {
+				out << (j == 0 ? "" : ", ") << result.samples[j];
+			}
+			out << "]\n    }";
+		}
+		out << (results.empty() ? "]\n}\n" : "\n  ]\n}\n");
+	}
+
+	void benchmarkSuite::writeJson(const std::string& filepath) const {
+		std::ofstream file{ filepath };
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open benchmark output file: " + filepath);
+		}
+		writeJson(file);
+	}
+
+	benchmarkSuite benchmarkSuite::readJson(const std::string& filepath) {
+		std::ifstream file{ filepath };
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open benchmark file: " + filepath);
+		}
+		std::stringstream contents = {};
+		contents << file.rdbuf();
+		std::string text = contents.str();
+		JsonValue document = jsonParser{ text, filepath }.parseDocument();
+
+		const JsonValue* name = document.find("suite");
+		const JsonValue* results = document.find("results");
+		if (name == nullptr || name->type != JsonValue::Type::STRING || results == nullptr || results->type != JsonValue::Type::ARRAY) {
+			throw std::runtime_error("failed to read benchmark file " + filepath + ": missing suite name or results!");
+		}
+
+		benchmarkSuite suite{ name->text };
+		if (const JsonValue* context = document.find("context")) {
+			for (const auto& entry : context->members) {
+				suite.setContext(entry.first, entry.second.text);
+			}
+		}
+
+		for (const auto& item : results->items) {
+			const JsonValue* resultName = item.find("name");
+			if (resultName == nullptr || resultName->type != JsonValue::Type::STRING) {
+				throw std::runtime_error("failed to read benchmark file " + filepath + ": result without a name!");
+			}
+
+			BenchmarkResult result = {};
+			result.name = resultName->text;
+			if (const JsonValue* unit = item.find("unit")) result.unit = unit->text;
+			if (const JsonValue* items = item.find("items_per_sample")) result.itemsPerSample = static_cast<uint64_t>(items->number);
+			if (const JsonValue* samples = item.find("samples"); samples != nullptr && !samples->items.empty()) {
+				for (const auto& sample : samples->items) {
+					result.samples.push_back(sample.number);
+				}
+			}
+			else if (const JsonValue* median = item.find("median")) {
+				result.samples.push_back(median->number); // summary only, compared without a significance test
+			}
+			suite.addResult(std::move(result));
+		}
+		return suite;
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace engine {
+	// summary statistics over a set of samples
+	struct BenchmarkStats {
+		double median = 0.0;
+		double mean = 0.0;
+		double stddev = 0.0;
+		double min = 0.0;
+		double max = 0.0;
+		double mad = 0.0; // median absolute deviation, robust against scheduler noise
+		double p95 = 0.0;
+
+		static BenchmarkStats compute(std::vector<double> samples);
+	};
+
+	// one measured quantity; samples are kept so results can be compared statistically later
+	struct BenchmarkResult {
+		std::string name = {};
+		std::string unit = "ns"; // unit of every sample
+		uint64_t itemsPerSample = 1; // work items each sample was divided by
+		std::vector<double> samples = {};
+	};
+
+	// change of one result between a baseline and a candidate run; every unit is a time, so lower is better
+	struct BenchmarkComparison {
+		enum class Verdict { UNCHANGED, REGRESSION, IMPROVEMENT };
+
+		double baselineMedian = 0.0;
+		double candidateMedian = 0.0;
+		double change = 0.0; // relative change of the median, positive means slower
+		double pValue = 1.0; // two-sided Mann-Whitney U test on the samples, NaN with fewer than 3 samples on either side
+		Verdict verdict = Verdict::UNCHANGED;
+
+		// a change counts when it is larger than threshold (0.05 is 5%) and significant at alpha, or only larger when there are too few samples to test
+		static BenchmarkComparison compare(const BenchmarkResult& baseline, const BenchmarkResult& candidate, double threshold, double alpha);
+	};
+
+	// collects results and writes them in the JSON layout read by tools/perfcompare.cpp
+	class benchmarkSuite {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		struct Options {
+			int sampleCount = 30; // samples collected per benchmark
+			double minSampleSeconds = 0.01; // iterations are calibrated so one sample takes at least this long
+			double warmupSeconds = 0.05; // time spent running the body before sampling
+		};
+
+		benchmarkSuite(std::string suiteName); // constructor
+		benchmarkSuite(std::string suiteName, Options options); // constructor with explicit options
+
+		// time body(), which processes itemsPerCall items, and record nanoseconds per item
+		template <typename Body>
+		void run(const std::string& name, uint64_t itemsPerCall, Body&& body) {
+			// warm caches, branch predictors and clocks, then calibrate how many calls fit in one sample
+			uint64_t iterations = 1;
+			double warmup = 0.0;
+			while (warmup < options.warmupSeconds) {
+				auto start = clock::now();
+				for (uint64_t i = 0; i < iterations; i++) body();
+				double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+				warmup += elapsed;
+				if (elapsed < options.minSampleSeconds) iterations *= 2;
+			}
+
+			BenchmarkResult result = {};
+			result.name = name;
+			result.itemsPerSample = itemsPerCall;
+			result.samples.reserve(options.sampleCount);
+			for (int sample = 0; sample < options.sampleCount; sample++) {
+				auto start = clock::now();
+				for (uint64_t i = 0; i < iterations; i++) body();
+				double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+				result.samples.push_back(elapsed / static_cast<double>(iterations * itemsPerCall));
+			}
+			addResult(std::move(result));
+		}
+
+		void addResult(BenchmarkResult result); // record a result measured elsewhere (frame times, load times, ...)
+		void setContext(const std::string& key, const std::string& value); // describe the run (scene, driver, ...)
+		const std::vector<BenchmarkResult>& getResults() const { return results; }
+		const std::vector<std::pair<std::string, std::string>>& getContext() const { return context; }
+		const std::string& getName() const { return suiteName; }
+
+		void printSummary(std::ostream& out) const; // human readable table
+		void writeJson(std::ostream& out) const; // machine readable results including raw samples
+		void writeJson(const std::string& filepath) const;
+		static benchmarkSuite readJson(const std::string& filepath); // load results written by writeJson, throws on malformed files
+
+	private:
+		std::string suiteName; // name of the suite, used to match result sets when comparing
+		Options options; // sampling options
+		std::vector<std::pair<std::string, std::string>> context = {}; // key/value description of the run
+		std::vector<BenchmarkResult> results = {}; // results in the order they were measured
+	};
+
+	// keep the optimizer from discarding a value that is only computed for timing
+	template <typename T>
+	inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+}
@@ -0,0 +1,497 @@
+#include "cpurasterizer.hpp"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define ENGINE_CPU_RASTER_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace engine {
+	static constexpr uint32_t VERTEX_JOB_SIZE = 4096; // vertices per vertex stage job
+	static constexpr uint32_t TRIANGLE_JOB_SIZE = 2048; // triangles per binning job
+	static constexpr int SUBPIXEL_BITS = 8; // screen positions are snapped to 1/256 of a pixel, like GPUs do
+	static constexpr float GUARD_BAND_PIXELS = 1 << 20; // keeps snapped coordinates, and products of them, well inside 64 bits
+
+	// a pixel's center on the subpixel grid
+	static int64_t pixelCenter(int pixel) {
+		return static_cast<int64_t>(pixel) * (1 << SUBPIXEL_BITS) + (1 << (SUBPIXEL_BITS - 1));
+	}
+
+	// float to 8-bit unorm as the GPU converts on store; NaN ends up as 0
+	static uint8_t toUnorm(float value) {
+		float clamped = value > 0.f ? (value < 1.f ? value : 1.f) : 0.f;
+		return static_cast<uint8_t>(clamped * 255.f + 0.5f);
+	}
+
+	cpuRasterizer::cpuRasterizer(uint32_t width, uint32_t height, uint32_t threadCount) : width{ width }, height{ height } {
+		assert(width > 0 && height > 0 && "cpu rasterizer needs a non-empty target");
+		tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+		tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+		guardBand = 2.f * GUARD_BAND_PIXELS / static_cast<float>(std::max(width, height));
+		color.resize(static_cast<size_t>(width) * height * 4);
+		depth.resize(static_cast<size_t>(width) * height);
+
+		if (threadCount == 0) threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		threadCount = std::min(threadCount, MAX_THREADS);
+		triangles.resize(threadCount);
+		bins.resize(threadCount, std::vector<std::vector<uint32_t>>(tilesX * tilesY));
+		for (uint32_t i = 1; i < threadCount; i++) {
+			workers.emplace_back(&cpuRasterizer::workerLoop, this, i);
+		}
+	}
+
+	cpuRasterizer::~cpuRasterizer() {
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+		}
+		workAvailable.notify_all();
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	uint32_t cpuRasterizer::addMesh(const model::Builder& geometry, const model* modelInstance) {
+		uint32_t meshIndex = static_cast<uint32_t>(meshes.size());
+		meshes.push_back(geometry);
+		if (modelInstance != nullptr) meshIndices[modelInstance] = meshIndex;
+		return meshIndex;
+	}
+
+	uint32_t cpuRasterizer::render(const GlobalUbo& ubo, entity::Map& gameEntities) {
+		entityDraws.clear();
+		for (auto& kv : gameEntities) {
+			if (kv.second.modelInstance == nullptr) continue;
+			auto found = meshIndices.find(kv.second.modelInstance.get());
+			if (found == meshIndices.end()) continue;
+
+			Draw drawInstance = {};
+			drawInstance.mesh = found->second;
+			drawInstance.modelMatrix = kv.second.transform.mat4();
+			drawInstance.normalMatrix = kv.second.transform.normalMatrix();
+			entityDraws.push_back(drawInstance);
+		}
+
+		render(ubo, entityDraws);
+		return static_cast<uint32_t>(entityDraws.size());
+	}
+
+	void cpuRasterizer::render(const GlobalUbo& ubo, const std::vector<Draw>& draws) {
+		using clock = std::chrono::steady_clock;
+		auto start = clock::now();
+
+		// lay out every draw's transformed vertices back to back and cut the draws into jobs
+		vertexOffsets.resize(draws.size());
+		vertexJobs.clear();
+		triangleJobs.clear();
+		sequenceBases.clear();
+		size_t vertexTotal = 0;
+		uint64_t triangleTotal = 0;
+		for (uint32_t i = 0; i < draws.size(); i++) {
+			assert(draws[i].mesh < meshes.size() && "draw refers to a missing mesh");
+			const model::Builder& mesh = meshes[draws[i].mesh];
+			uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+			uint32_t triangleCount = static_cast<uint32_t>((mesh.indices.empty() ? mesh.vertices.size() : mesh.indices.size()) / 3);
+
+			vertexOffsets[i] = vertexTotal;
+			for (uint32_t first = 0; first < vertexCount; first += VERTEX_JOB_SIZE) {
+				vertexJobs.push_back({ i, first, std::min(VERTEX_JOB_SIZE, vertexCount - first) });
+			}
+			for (uint32_t first = 0; first < triangleCount; first += TRIANGLE_JOB_SIZE) {
+				triangleJobs.push_back({ i, first, std::min(TRIANGLE_JOB_SIZE, triangleCount - first) });
+				sequenceBases.push_back(triangleTotal + first);
+			}
+			vertexTotal += vertexCount;
+			triangleTotal += triangleCount;
+		}
+		transformed.resize(vertexTotal);
+
+		glm::mat4 viewProjection = ubo.projection * ubo.view;
+		parallelFor(vertexJobs.size(), [&](size_t item, uint32_t) {
+			transformVertices(vertexJobs[item], draws[vertexJobs[item].draw], viewProjection);
+		});
+		auto vertexEnd = clock::now();
+
+		for (auto& threadTriangles : triangles) {
+			threadTriangles.clear();
+		}
+		parallelFor(triangleJobs.size(), [&](size_t item, uint32_t thread) {
+			const Job& job = triangleJobs[item];
+			setupTriangles(job, meshes[draws[job.draw].mesh], transformed.data() + vertexOffsets[job.draw], sequenceBases[item], thread);
+		});
+		auto binEnd = clock::now();
+
+		parallelFor(static_cast<size_t>(tilesX) * tilesY, [&](size_t item, uint32_t) {
+			rasterizeTile(static_cast<uint32_t>(item), ubo);
+		});
+		auto rasterEnd = clock::now();
+
+		stats.vertexMilliseconds = std::chrono::duration<double, std::milli>(vertexEnd - start).count();
+		stats.binMilliseconds = std::chrono::duration<double, std::milli>(binEnd - vertexEnd).count();
+		stats.rasterMilliseconds = std::chrono::duration<double, std::milli>(rasterEnd - binEnd).count();
+		stats.trianglesBinned = 0;
+		for (const auto& threadTriangles : triangles) {
+			stats.trianglesBinned += threadTriangles.size();
+		}
+	}
+
+	// *************** Threads *********************
+
+	void cpuRasterizer::parallelFor(size_t count, const std::function<void(size_t item, uint32_t thread)>& body) {
+		if (count == 0) return;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			currentBody = &body;
+			itemCount = count;
+			nextItem.store(0);
+			busyWorkers = static_cast<uint32_t>(workers.size());
+			generation++;
+		}
+		workAvailable.notify_all();
+
+		for (size_t item = nextItem.fetch_add(1); item < count; item = nextItem.fetch_add(1)) {
+			body(item, 0);
+		}
+
+		// every worker has to check in, even one that found no items left, before body goes out of scope
+		std::unique_lock<std::mutex> lock{ mutex };
+		workDone.wait(lock, [this]() { return busyWorkers == 0; });
+		currentBody = nullptr;
+	}
+
+	void cpuRasterizer::workerLoop(uint32_t thread) {
+		uint64_t seenGeneration = 0;
+		while (true) {
+			const std::function<void(size_t, uint32_t)>* body = nullptr;
+			size_t count = 0;
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				workAvailable.wait(lock, [this, seenGeneration]() { return stopping || generation != seenGeneration; });
+				if (stopping) return;
+				seenGeneration = generation;
+				body = currentBody;
+				count = itemCount;
+			}
+
+			for (size_t item = nextItem.fetch_add(1); item < count; item = nextItem.fetch_add(1)) {
+				(*body)(item, thread);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				busyWorkers--;
+			}
+			workDone.notify_one();
+		}
+	}
+
+	// *************** Vertex stage *********************
+
+	void cpuRasterizer::transformVertices(const Job& job, const Draw& drawInstance, const glm::mat4& viewProjection) {
+		const model::Vertex* in = meshes[drawInstance.mesh].vertices.data() + job.first;
+		ClipVertex* out = transformed.data() + vertexOffsets[job.draw] + job.first;
+		const glm::mat4 modelViewProjection = viewProjection * drawInstance.modelMatrix;
+		const glm::mat4& modelMatrix = drawInstance.modelMatrix;
+		const glm::mat4& normalMatrix = drawInstance.normalMatrix;
+
+		uint32_t i = 0;
+#ifdef ENGINE_CPU_RASTER_SSE
+		// four vertices per iteration, one per lane; the matrices are broadcast a column entry at a time
+		for (; i + 4 <= job.count; i += 4) {
+			const model::Vertex* v = in + i;
+			__m128 x = _mm_setr_ps(v[0].position.x, v[1].position.x, v[2].position.x, v[3].position.x);
+			__m128 y = _mm_setr_ps(v[0].position.y, v[1].position.y, v[2].position.y, v[3].position.y);
+			__m128 z = _mm_setr_ps(v[0].position.z, v[1].position.z, v[2].position.z, v[3].position.z);
+			__m128 nx = _mm_setr_ps(v[0].normal.x, v[1].normal.x, v[2].normal.x, v[3].normal.x);
+			__m128 ny = _mm_setr_ps(v[0].normal.y, v[1].normal.y, v[2].normal.y, v[3].normal.y);
+			__m128 nz = _mm_setr_ps(v[0].normal.z, v[1].normal.z, v[2].normal.z, v[3].normal.z);
+
+			// row r of m * (x, y, z, 1), or of m * (x, y, z, 0) for directions
+			auto point = [&x, &y, &z](const glm::mat4& m, int r) {
+				return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0][r]), x), _mm_mul_ps(_mm_set1_ps(m[1][r]), y)), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[2][r]), z), _mm_set1_ps(m[3][r])));
+			};
+			auto direction = [&nx, &ny, &nz](const glm::mat4& m, int r) {
+				return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0][r]), nx), _mm_mul_ps(_mm_set1_ps(m[1][r]), ny)), _mm_mul_ps(_mm_set1_ps(m[2][r]), nz));
+			};
+
+			alignas(16) float lanes[10][4];
+			for (int r = 0; r < 4; r++) {
+				_mm_store_ps(lanes[r], point(modelViewProjection, r));
+			}
+			for (int r = 0; r < 3; r++) {
+				_mm_store_ps(lanes[4 + r], point(modelMatrix, r));
+			}
+
+			// normalize like the vertex shader, leaving zero length normals at zero
+			__m128 wx = direction(normalMatrix, 0);
+			__m128 wy = direction(normalMatrix, 1);
+			__m128 wz = direction(normalMatrix, 2);
+			__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wx, wx), _mm_mul_ps(wy, wy)), _mm_mul_ps(wz, wz));
+			__m128 nonZero = _mm_cmpgt_ps(lengthSquared, _mm_setzero_ps());
+			__m128 inverseLength = _mm_and_ps(nonZero, _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(lengthSquared)));
+			_mm_store_ps(lanes[7], _mm_mul_ps(wx, inverseLength));
+			_mm_store_ps(lanes[8], _mm_mul_ps(wy, inverseLength));
+			_mm_store_ps(lanes[9], _mm_mul_ps(wz, inverseLength));
+
+			for (int lane = 0; lane < 4; lane++) {
+				ClipVertex& result = out[i + lane];
+				result.clip = { lanes[0][lane], lanes[1][lane], lanes[2][lane], lanes[3][lane] };
+				result.world = { lanes[4][lane], lanes[5][lane], lanes[6][lane] };
+				result.normal = { lanes[7][lane], lanes[8][lane], lanes[9][lane] };
+				result.color = v[lane].color;
+			}
+		}
+#endif
+		// the remainder, or everything without SSE
+		for (; i < job.count; i++) {
+			const model::Vertex& v = in[i];
+			glm::vec4 positionWorld = modelMatrix * glm::vec4{ v.position, 1.f };
+			glm::vec3 normalWorld = glm::mat3{ normalMatrix } * v.normal;
+			float lengthSquared = glm::dot(normalWorld, normalWorld);
+
+			ClipVertex& result = out[i];
+			result.clip = modelViewProjection * glm::vec4{ v.position, 1.f };
+			result.world = glm::vec3{ positionWorld };
+			result.normal = lengthSquared > 0.f ? normalWorld / std::sqrt(lengthSquared) : glm::vec3{ 0.f };
+			result.color = v.color;
+		}
+	}
+
+	// *************** Binning *********************
+
+	void cpuRasterizer::setupTriangles(const Job& job, const model::Builder& mesh, const ClipVertex* vertices, uint64_t sequenceBase, uint32_t thread) {
+		const std::vector<uint32_t>& indices = mesh.indices;
+		for (uint32_t i = 0; i < job.count; i++) {
+			uint32_t triangle = job.first + i;
+			if (indices.empty()) {
+				clipTriangle(vertices[3 * triangle], vertices[3 * triangle + 1], vertices[3 * triangle + 2], sequenceBase + i, thread);
+			}
+			else {
+				clipTriangle(vertices[indices[3 * triangle]], vertices[indices[3 * triangle + 1]], vertices[indices[3 * triangle + 2]], sequenceBase + i, thread);
+			}
+		}
+	}
+
+	void cpuRasterizer::clipTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, uint64_t sequence, uint32_t thread) {
+		// entirely beyond one side plane
+		if ((v0.clip.x > v0.clip.w && v1.clip.x > v1.clip.w && v2.clip.x > v2.clip.w) || (v0.clip.x < -v0.clip.w && v1.clip.x < -v1.clip.w && v2.clip.x < -v2.clip.w)) return;
+		if ((v0.clip.y > v0.clip.w && v1.clip.y > v1.clip.w && v2.clip.y > v2.clip.w) || (v0.clip.y < -v0.clip.w && v1.clip.y < -v1.clip.w && v2.clip.y < -v2.clip.w)) return;
+
+		// Vulkan keeps 0 <= z <= w, so the near plane needs real clipping; the sides only need a guard band far outside the
+		// viewport that keeps screen coordinates small enough for exact edge functions, and the far plane is the per pixel depth range check
+		float guard = guardBand;
+		auto distance = [guard](const ClipVertex& v, int plane) {
+			switch (plane) {
+			case 0: return v.clip.z;
+			case 1: return guard * v.clip.w - v.clip.x;
+			case 2: return guard * v.clip.w + v.clip.x;
+			case 3: return guard * v.clip.w - v.clip.y;
+			default: return guard * v.clip.w + v.clip.y;
+			}
+		};
+		constexpr int PLANE_COUNT = 5;
+
+		bool inside = true;
+		for (int plane = 0; plane < PLANE_COUNT && inside; plane++) {
+			inside = distance(v0, plane) >= 0.f && distance(v1, plane) >= 0.f && distance(v2, plane) >= 0.f;
+		}
+		if (inside) {
+			binTriangle(v0, v1, v2, sequence, thread);
+			return;
+		}
+
+		// every plane can add at most one vertex; clip space is linear so the varyings are interpolated along with the position
+		auto lerp = [](const ClipVertex& a, const ClipVertex& b, float t) {
+			return ClipVertex{ a.clip + (b.clip - a.clip) * t, a.world + (b.world - a.world) * t, a.normal + (b.normal - a.normal) * t, a.color + (b.color - a.color) * t };
+		};
+		ClipVertex polygons[2][3 + PLANE_COUNT] = { { v0, v1, v2 } };
+		int polygonSize = 3;
+		int current = 0;
+		for (int plane = 0; plane < PLANE_COUNT && polygonSize >= 3; plane++) {
+			const ClipVertex* input = polygons[current];
+			ClipVertex* output = polygons[current ^ 1];
+			int outputSize = 0;
+			for (int i = 0; i < polygonSize; i++) {
+				const ClipVertex& a = input[i];
+				const ClipVertex& b = input[(i + 1) % polygonSize];
+				float distanceA = distance(a, plane);
+				float distanceB = distance(b, plane);
+				if (distanceA >= 0.f) output[outputSize++] = a;
+				if ((distanceA >= 0.f) != (distanceB >= 0.f)) {
+					output[outputSize++] = lerp(a, b, distanceA / (distanceA - distanceB));
+				}
+			}
+			polygonSize = outputSize;
+			current ^= 1;
+		}
+
+		// the clipped polygon is convex, draw it as a fan
+		for (int i = 1; i + 1 < polygonSize; i++) {
+			binTriangle(polygons[current][0], polygons[current][i], polygons[current][i + 1], sequence, thread);
+		}
+	}
+
+	void cpuRasterizer::binTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, uint64_t sequence, uint32_t thread) {
+		const ClipVertex* vertices[3] = { &v0, &v1, &v2 };
+		Triangle triangle = {};
+		triangle.sequence = sequence;
+
+		// viewport transform, NDC y = -1 is the top row as in Vulkan, then snap to the subpixel grid
+		constexpr float SUBPIXELS = static_cast<float>(1 << SUBPIXEL_BITS);
+		int64_t x[3], y[3];
+		for (int i = 0; i < 3; i++) {
+			float inverseW = 1.f / vertices[i]->clip.w;
+			x[i] = std::llround((vertices[i]->clip.x * inverseW * 0.5f + 0.5f) * static_cast<float>(width) * SUBPIXELS);
+			y[i] = std::llround((vertices[i]->clip.y * inverseW * 0.5f + 0.5f) * static_cast<float>(height) * SUBPIXELS);
+			triangle.depth[i] = vertices[i]->clip.z * inverseW;
+			triangle.inverseW[i] = inverseW;
+			triangle.world[i] = vertices[i]->world * inverseW;
+			triangle.normal[i] = vertices[i]->normal * inverseW;
+			triangle.color[i] = vertices[i]->color * inverseW;
+		}
+
+		// no culling, as in the pipeline; the edges are flipped for clockwise triangles so the inside is always positive
+		int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if (area == 0) return;
+		int64_t orientation = area > 0 ? 1 : -1;
+		triangle.inverseArea = 1.f / static_cast<float>(area * orientation);
+		for (int i = 0; i < 3; i++) {
+			int j = (i + 1) % 3;
+			int k = (i + 2) % 3;
+			triangle.edgeA[i] = (y[j] - y[k]) * orientation;
+			triangle.edgeB[i] = (x[k] - x[j]) * orientation;
+			triangle.edgeC[i] = (x[j] * y[k] - x[k] * y[j]) * orientation;
+
+			// fill rule: a pixel center exactly on an edge shared by two triangles belongs to exactly one of them,
+			// because the neighbor walks the edge the other way and sees negated coefficients
+			bool ownsEdge = triangle.edgeA[i] > 0 || (triangle.edgeA[i] == 0 && triangle.edgeB[i] > 0);
+			if (!ownsEdge) triangle.edgeC[i] -= 1;
+		}
+
+		// pixels whose centers can be covered
+		auto firstPixel = [](int64_t coordinate) { return static_cast<int>(std::ceil(static_cast<double>(coordinate) / SUBPIXELS - 0.5)); };
+		auto lastPixel = [](int64_t coordinate) { return static_cast<int>(std::floor(static_cast<double>(coordinate) / SUBPIXELS - 0.5)); };
+		triangle.minX = std::max(firstPixel(std::min({ x[0], x[1], x[2] })), 0);
+		triangle.minY = std::max(firstPixel(std::min({ y[0], y[1], y[2] })), 0);
+		triangle.maxX = std::min(lastPixel(std::max({ x[0], x[1], x[2] })), static_cast<int>(width) - 1);
+		triangle.maxY = std::min(lastPixel(std::max({ y[0], y[1], y[2] })), static_cast<int>(height) - 1);
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) return;
+
+		std::vector<Triangle>& threadTriangles = triangles[thread];
+		uint32_t triangleIndex = static_cast<uint32_t>(threadTriangles.size());
+		bool binned = false;
+		for (uint32_t tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; tileY++) {
+			for (uint32_t tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; tileX++) {
+				// skip tiles entirely outside one edge, testing the pixel center where the edge function is largest
+				int64_t left = pixelCenter(static_cast<int>(tileX * TILE_SIZE));
+				int64_t top = pixelCenter(static_cast<int>(tileY * TILE_SIZE));
+				int64_t right = pixelCenter(static_cast<int>(tileX * TILE_SIZE + TILE_SIZE - 1));
+				int64_t bottom = pixelCenter(static_cast<int>(tileY * TILE_SIZE + TILE_SIZE - 1));
+				bool outside = false;
+				for (int i = 0; i < 3 && !outside; i++) {
+					int64_t bestX = triangle.edgeA[i] > 0 ? right : left;
+					int64_t bestY = triangle.edgeB[i] > 0 ? bottom : top;
+					outside = triangle.edgeA[i] * bestX + triangle.edgeB[i] * bestY + triangle.edgeC[i] < 0;
+				}
+				if (outside) continue;
+
+				bins[thread][tileY * tilesX + tileX].push_back(triangleIndex);
+				binned = true;
+			}
+		}
+		if (binned) threadTriangles.push_back(triangle);
+	}
+
+	// *************** Rasterization *********************
+
+	void cpuRasterizer::rasterizeTile(uint32_t tile, const GlobalUbo& ubo) {
+		int tileLeft = static_cast<int>((tile % tilesX) * TILE_SIZE);
+		int tileTop = static_cast<int>((tile / tilesX) * TILE_SIZE);
+		int tileRight = std::min(tileLeft + static_cast<int>(TILE_SIZE), static_cast<int>(width)) - 1;
+		int tileBottom = std::min(tileTop + static_cast<int>(TILE_SIZE), static_cast<int>(height)) - 1;
+
+		// same clear values as the render passes
+		static const uint8_t CLEAR_COLOR[4] = { toUnorm(0.01f), toUnorm(0.1f), toUnorm(0.1f), toUnorm(1.f) };
+		for (int y = tileTop; y <= tileBottom; y++) {
+			size_t row = static_cast<size_t>(y) * width;
+			std::fill(depth.begin() + row + tileLeft, depth.begin() + row + tileRight + 1, 1.f);
+			for (int x = tileLeft; x <= tileRight; x++) {
+				std::copy(CLEAR_COLOR, CLEAR_COLOR + 4, color.begin() + (row + x) * 4);
+			}
+		}
+
+		glm::vec3 ambientLight = glm::vec3{ ubo.ambientLightColor } * ubo.ambientLightColor.w;
+		glm::vec3 lightColor = glm::vec3{ ubo.lightColor } * ubo.lightColor.w;
+
+		// merge the per thread bins, each already in submission order, so overlapping triangles resolve like on the GPU
+		uint32_t threadCount = getThreadCount();
+		size_t cursors[MAX_THREADS] = {};
+		while (true) {
+			uint32_t source = MAX_THREADS;
+			uint64_t lowest = UINT64_MAX;
+			for (uint32_t t = 0; t < threadCount; t++) {
+				const auto& bin = bins[t][tile];
+				if (cursors[t] < bin.size() && triangles[t][bin[cursors[t]]].sequence < lowest) {
+					lowest = triangles[t][bin[cursors[t]]].sequence;
+					source = t;
+				}
+			}
+			if (source == MAX_THREADS) break;
+			const Triangle& triangle = triangles[source][bins[source][tile][cursors[source]++]];
+
+			int minX = std::max(triangle.minX, tileLeft);
+			int maxX = std::min(triangle.maxX, tileRight);
+			int minY = std::max(triangle.minY, tileTop);
+			int maxY = std::min(triangle.maxY, tileBottom);
+			for (int y = minY; y <= maxY; y++) {
+				// edge functions stepped exactly along the row, the barycentric weights are derived from them
+				int64_t edges[3];
+				for (int i = 0; i < 3; i++) {
+					edges[i] = triangle.edgeA[i] * pixelCenter(minX) + triangle.edgeB[i] * pixelCenter(y) + triangle.edgeC[i];
+				}
+				size_t row = static_cast<size_t>(y) * width;
+				for (int x = minX; x <= maxX; x++) {
+					bool covered = (edges[0] | edges[1] | edges[2]) >= 0;
+					glm::vec3 weights{ static_cast<float>(edges[0]), static_cast<float>(edges[1]), static_cast<float>(edges[2]) };
+					for (int i = 0; i < 3; i++) {
+						edges[i] += triangle.edgeA[i] * (1 << SUBPIXEL_BITS);
+					}
+					if (!covered) continue;
+					weights = weights * triangle.inverseArea;
+
+					float z = glm::dot(weights, triangle.depth);
+					size_t pixel = row + x;
+					if (z < 0.f || z > 1.f || !(z < depth[pixel])) continue; // VK_COMPARE_OP_LESS
+					depth[pixel] = z;
+
+					float w = 1.f / glm::dot(weights, triangle.inverseW);
+					glm::vec3 world = (weights.x * triangle.world[0] + weights.y * triangle.world[1] + weights.z * triangle.world[2]) * w;
+					glm::vec3 normal = (weights.x * triangle.normal[0] + weights.y * triangle.normal[1] + weights.z * triangle.normal[2]) * w;
+					glm::vec3 fragColor = (weights.x * triangle.color[0] + weights.y * triangle.color[1] + weights.z * triangle.color[2]) * w;
+
+					// simple_shader.frag
+					glm::vec3 directionToLight = ubo.lightPosition - world;
+					float distanceSquared = glm::dot(directionToLight, directionToLight);
+					float normalLength = glm::length(normal);
+					float cosine = normalLength > 0.f && distanceSquared > 0.f ? glm::dot(normal, directionToLight) / (normalLength * std::sqrt(distanceSquared)) : 0.f;
+					glm::vec3 diffuseLight = lightColor / distanceSquared * std::max(0.f, cosine);
+					glm::vec3 shaded = (diffuseLight + ambientLight) * fragColor;
+
+					uint8_t* target = color.data() + pixel * 4;
+					target[0] = toUnorm(shaded.r);
+					target[1] = toUnorm(shaded.g);
+					target[2] = toUnorm(shaded.b);
+					target[3] = 255;
+				}
+			}
+		}
+
+		// the bins are done with; clearing them here spreads the work over the raster threads
+		for (uint32_t t = 0; t < threadCount; t++) {
+			bins[t][tile].clear();
+		}
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include "entity.hpp"
+#include "frameinfo.hpp"
+#include "model.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+	// renders the same entities, meshes and camera as rendersystem, but on the CPU, for machines without a GPU or Vulkan driver
+	// a frame runs in three parallel passes: vertices are transformed four at a time with SSE, triangles are clipped and binned
+	// into screen tiles, then every tile is rasterized by one thread with depth testing and the lighting of simple_shader.frag
+	// the output matches an offscreenRenderer image: RGBA8, top row first, same clear color and depth convention
+	class cpuRasterizer {
+	public:
+		static constexpr uint32_t TILE_SIZE = 32; // pixels along each side of a screen tile
+		static constexpr uint32_t MAX_THREADS = 64;
+
+		// one mesh instance to draw, the CPU equivalent of rendersystem's push constants
+		struct Draw {
+			uint32_t mesh = 0; // index returned by addMesh
+			glm::mat4 modelMatrix{ 1.f };
+			glm::mat4 normalMatrix{ 1.f };
+		};
+
+		// time spent in each pass of the last frame
+		struct Stats {
+			double vertexMilliseconds = 0.0;
+			double binMilliseconds = 0.0;
+			double rasterMilliseconds = 0.0;
+			uint64_t trianglesBinned = 0; // triangles that survived clipping and culling, after near plane splits
+		};
+
+		cpuRasterizer(uint32_t width, uint32_t height, uint32_t threadCount = 0); // constructor, 0 threads uses every hardware thread
+		~cpuRasterizer(); // destructor, stops the workers
+
+		// not copyable or movable
+		cpuRasterizer(const cpuRasterizer&) = delete;
+		cpuRasterizer& operator = (const cpuRasterizer&) = delete;
+
+		// keep a copy of the geometry; modelInstance is the GPU model entities refer to, so render(entity::Map) can find it
+		uint32_t addMesh(const model::Builder& geometry, const model* modelInstance = nullptr);
+
+		void render(const GlobalUbo& ubo, const std::vector<Draw>& draws); // draw in order, like consecutive draw calls
+		uint32_t render(const GlobalUbo& ubo, entity::Map& gameEntities); // draw every entity with a registered model, returns the draw count
+
+		const std::vector<uint8_t>& getColor() const { return color; } // the last frame
+		uint32_t getWidth() const { return width; }
+		uint32_t getHeight() const { return height; }
+		uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()) + 1; }
+		const Stats& getStats() const { return stats; }
+
+	private:
+		// a vertex after the vertex stage: clip position plus the varyings of simple_shader.vert
+		struct ClipVertex {
+			glm::vec4 clip;
+			glm::vec3 world;
+			glm::vec3 normal;
+			glm::vec3 color;
+		};
+
+		// a screen space triangle ready for rasterization
+		struct Triangle {
+			uint64_t sequence; // submission order; triangles are rasterized in this order within a tile, as on the GPU
+			int64_t edgeA[3], edgeB[3], edgeC[3]; // edge function i at subpixel (x, y) is edgeA[i] * x + edgeB[i] * y + edgeC[i], positive inside
+			float inverseArea; // turns edge functions into barycentric weights
+			glm::vec3 depth; // z / w of each vertex, interpolated linearly in screen space
+			glm::vec3 inverseW; // for perspective correct varyings
+			glm::vec3 world[3], normal[3], color[3]; // varyings divided by w
+			int minX, minY, maxX, maxY; // pixel bounds, inclusive and clamped to the target
+		};
+
+		// a slice of the frame's work for one parallel job
+		struct Job {
+			uint32_t draw;
+			uint32_t first; // first vertex, or first triangle for triangle jobs
+			uint32_t count;
+		};
+
+		void parallelFor(size_t count, const std::function<void(size_t item, uint32_t thread)>& body); // run body over [0, count) on every thread
+		void workerLoop(uint32_t thread);
+
+		void transformVertices(const Job& job, const Draw& drawInstance, const glm::mat4& viewProjection); // vertex stage
+		void setupTriangles(const Job& job, const model::Builder& mesh, const ClipVertex* vertices, uint64_t sequenceBase, uint32_t thread); // assemble a slice of a draw's triangles
+		void clipTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, uint64_t sequence, uint32_t thread); // against the near plane
+		void binTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, uint64_t sequence, uint32_t thread); // set up and add to the tiles it touches
+		void rasterizeTile(uint32_t tile, const GlobalUbo& ubo); // clear, then draw the tile's bins in submission order
+
+		uint32_t width;
+		uint32_t height;
+		uint32_t tilesX;
+		uint32_t tilesY;
+		float guardBand; // clip space x and y limit, in multiples of w, beyond which triangles are clipped
+		std::vector<uint8_t> color; // RGBA8
+		std::vector<float> depth;
+
+		std::vector<model::Builder> meshes = {};
+		std::unordered_map<const model*, uint32_t> meshIndices = {}; // GPU model to mesh, for entity rendering
+		std::vector<Draw> entityDraws = {}; // reused by render(entity::Map)
+
+		// per frame working memory, cleared but never shrunk so a steady scene stops allocating
+		std::vector<size_t> vertexOffsets = {}; // first transformed vertex of each draw
+		std::vector<ClipVertex> transformed = {};
+		std::vector<Job> vertexJobs = {};
+		std::vector<Job> triangleJobs = {};
+		std::vector<uint64_t> sequenceBases = {}; // first sequence number of each triangle job
+		std::vector<std::vector<Triangle>> triangles = {}; // per thread
+		std::vector<std::vector<std::vector<uint32_t>>> bins = {}; // per thread, per tile: indices into that thread's triangles
+		Stats stats = {};
+
+		// persistent workers; the calling thread takes part as thread 0
+		std::vector<std::thread> workers = {};
+		std::mutex mutex;
+		std::condition_variable workAvailable;
+		std::condition_variable workDone;
+		const std::function<void(size_t, uint32_t)>* currentBody = nullptr;
+		size_t itemCount = 0;
+		std::atomic<size_t> nextItem{ 0 };
+		uint64_t generation = 0; // bumped for every parallelFor so workers see new work
+		uint32_t busyWorkers = 0;
+		bool stopping = false;
+	};
+}
@@ -1,9 +1,19 @@
 #include "descriptors.hpp"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <stdexcept>
+#include <string>
 
 namespace engine {
 
+    // what a descriptor buffer is created with, and has to be bound with
+    static constexpr VkBufferUsageFlags DESCRIPTOR_BUFFER_USAGE = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
+    static VkDeviceSize alignUp(VkDeviceSize size, VkDeviceSize alignment) {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
     // *************** Descriptor Set Layout Builder *********************
 
     descriptorSetLayout::Builder& descriptorSetLayout::Builder::addBinding(uint32_t binding, VkDescriptorType descriptorType, VkShaderStageFlags stageFlags, uint32_t count) {
@@ -17,30 +27,95 @@ namespace engine {
         return *this;
     }
 
+    descriptorSetLayout::Builder& descriptorSetLayout::Builder::setPushDescriptor(bool enabled) {
+        pushDescriptor = enabled;
+        return *this;
+    }
+
+    descriptorSetLayout::Builder& descriptorSetLayout::Builder::setDescriptorBuffer(bool enabled) {
+        descriptorBuffer = enabled;
+        return *this;
+    }
+
     std::unique_ptr<descriptorSetLayout> descriptorSetLayout::Builder::build() const {
-        return std::make_unique<descriptorSetLayout>(deviceInstance, bindings);
+        return std::make_unique<descriptorSetLayout>(deviceInstance, bindings, pushDescriptor, descriptorBuffer);
     }
 
     // *************** Descriptor Set Layout *********************
 
-    descriptorSetLayout::descriptorSetLayout(device& deviceInstance, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings) : deviceInstance{ deviceInstance }, bindings{ bindings } {
+    descriptorSetLayout::descriptorSetLayout(device& deviceInstance, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings, bool pushDescriptor, bool descriptorBuffer) : deviceInstance{ deviceInstance }, bindings{ bindings } {
+        assert(!(pushDescriptor && descriptorBuffer) && "A layout is either pushed or kept in a descriptor buffer");
         std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = {};
         for (auto kv : bindings) {
             setLayoutBindings.push_back(kv.second);
         }
 
-        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo = {};
-        descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
-        descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
+        std::sort(setLayoutBindings.begin(), setLayoutBindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+        for (const auto& binding : setLayoutBindings) {
+            descriptorOffsets[binding.binding] = descriptorCount;
+            descriptorCount += binding.descriptorCount;
+        }
+
+        // without the extension, or with too many descriptors to push, this becomes a regular layout and push() allocates
+        this->pushDescriptor = pushDescriptor && deviceInstance.supportsPushDescriptors() && descriptorCount <= MAX_PUSH_DESCRIPTORS;
+        this->descriptorBuffer = descriptorBuffer && deviceInstance.supportsDescriptorBuffers();
+        VkDescriptorSetLayoutCreateFlags flags = this->pushDescriptor ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0;
+        if (this->descriptorBuffer) flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+
+        // builders with the same bindings share one Vulkan layout, owned by the device's cache
+        descriptorSetLayoutInstance = deviceInstance.getLayoutCache().getDescriptorSetLayout(setLayoutBindings, flags);
+
+        // the driver decides how big a set is in a descriptor buffer and where each binding goes
+        if (this->descriptorBuffer) {
+            const DescriptorBufferFunctions& functions = deviceInstance.descriptorBufferFunctions;
+            functions.getLayoutSize(deviceInstance.getDevice(), descriptorSetLayoutInstance, &descriptorBufferSize);
+            for (const auto& binding : setLayoutBindings) {
+                functions.getLayoutBindingOffset(deviceInstance.getDevice(), descriptorSetLayoutInstance, binding.binding, &descriptorBufferOffsets[binding.binding]);
+            }
+        }
 
-        if (vkCreateDescriptorSetLayout(deviceInstance.getDevice(), &descriptorSetLayoutInfo, nullptr, &descriptorSetLayoutInstance) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create descriptor set layout!");
+        // set templates can't target push descriptor layouts, and there are no sets to update in a descriptor buffer
+        if (deviceInstance.supportsUpdateTemplates() && descriptorCount > 0 && !this->pushDescriptor && !this->descriptorBuffer) {
+            createUpdateTemplate();
         }
     }
 
     descriptorSetLayout::~descriptorSetLayout() {
-        vkDestroyDescriptorSetLayout(deviceInstance.getDevice(), descriptorSetLayoutInstance, nullptr);
+        if (updateTemplate != VK_NULL_HANDLE) {
+            vkDestroyDescriptorUpdateTemplate(deviceInstance.getDevice(), updateTemplate, nullptr);
+        }
+    }
+
+    void descriptorSetLayout::createUpdateTemplate() {
+        // one entry per binding, each reading its descriptors from consecutive DescriptorInfo elements
+        std::vector<VkDescriptorUpdateTemplateEntry> entries = {};
+        for (const auto& kv : descriptorOffsets) {
+            const VkDescriptorSetLayoutBinding& binding = bindings.at(kv.first);
+            VkDescriptorUpdateTemplateEntry entry = {};
+            entry.dstBinding = binding.binding;
+            entry.dstArrayElement = 0;
+            entry.descriptorCount = binding.descriptorCount;
+            entry.descriptorType = binding.descriptorType;
+            entry.offset = kv.second * sizeof(DescriptorInfo);
+            entry.stride = sizeof(DescriptorInfo);
+            entries.push_back(entry);
+        }
+
+        VkDescriptorUpdateTemplateCreateInfo templateInfo = {};
+        templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+        templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+        templateInfo.pDescriptorUpdateEntries = entries.data();
+        templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+        templateInfo.descriptorSetLayout = descriptorSetLayoutInstance;
+
+        if (vkCreateDescriptorUpdateTemplate(deviceInstance.getDevice(), &templateInfo, nullptr, &updateTemplate) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor update template!");
+        }
+    }
+
+    void descriptorSetLayout::updateWithTemplate(VkDescriptorSet set, const DescriptorInfo* descriptors) const {
+        assert(updateTemplate != VK_NULL_HANDLE && "Layout has no update template");
+        vkUpdateDescriptorSetWithTemplate(deviceInstance.getDevice(), set, updateTemplate, descriptors);
     }
 
     // *************** Descriptor Pool Builder *********************
@@ -90,8 +165,7 @@ namespace engine {
         allocInfo.pSetLayouts = &descriptorSetLayoutInstance;
         allocInfo.descriptorSetCount = 1;
 
-        // Might want to create a "DescriptorPoolManager" class that handles this case, and builds
-        // a new pool whenever an old pool fills up. But this is beyond our current scope
+        // a full pool fails here; descriptorAllocator moves on to a new pool instead
         if (vkAllocateDescriptorSets(deviceInstance.getDevice(), &allocInfo, &descriptor) != VK_SUCCESS) {
             return false;
         }
@@ -106,14 +180,265 @@ namespace engine {
         vkResetDescriptorPool(deviceInstance.getDevice(), descriptorPoolInstance, 0);
     }
 
+    // *************** Descriptor Allocator Builder *********************
+
+    descriptorAllocator::Builder& descriptorAllocator::Builder::addPoolRatio(VkDescriptorType descriptorType, float descriptorsPerSet) {
+        poolRatios.push_back({ descriptorType, descriptorsPerSet });
+        return *this;
+    }
+
+    descriptorAllocator::Builder& descriptorAllocator::Builder::setSetsPerPool(uint32_t count) {
+        setsPerPool = count;
+        return *this;
+    }
+
+    descriptorAllocator::Builder& descriptorAllocator::Builder::setFrameCount(uint32_t count) {
+        frameCount = count;
+        return *this;
+    }
+
+    std::unique_ptr<descriptorAllocator> descriptorAllocator::Builder::build() const {
+        return std::make_unique<descriptorAllocator>(deviceInstance, setsPerPool, poolRatios, frameCount);
+    }
+
+    // *************** Descriptor Allocator *********************
+
+    descriptorAllocator::descriptorAllocator(device& deviceInstance, uint32_t setsPerPool, const std::vector<std::pair<VkDescriptorType, float>>& poolRatios, uint32_t frameCount)
+        : deviceInstance{ deviceInstance }, setsPerPool{ std::clamp(setsPerPool, 1u, MAX_SETS_PER_POOL) }, poolRatios{ poolRatios }, frames(frameCount) {
+        assert(!poolRatios.empty() && "Descriptor allocator needs at least one pool ratio");
+    }
+
+    descriptorAllocator::~descriptorAllocator() {
+        for (VkDescriptorPool pool : persistent.pools) {
+            vkDestroyDescriptorPool(deviceInstance.getDevice(), pool, nullptr);
+        }
+        for (auto& frame : frames) {
+            for (VkDescriptorPool pool : frame.pools) {
+                vkDestroyDescriptorPool(deviceInstance.getDevice(), pool, nullptr);
+            }
+        }
+    }
+
+    VkDescriptorSet descriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+        return allocateFrom(persistent, layout);
+    }
+
+    VkDescriptorSet descriptorAllocator::allocateFrame(uint32_t frameIndex, VkDescriptorSetLayout layout) {
+        assert(frameIndex < frames.size() && "Frame index out of range of the allocator's frame count");
+        return allocateFrom(frames[frameIndex], layout);
+    }
+
+    void descriptorAllocator::resetFrame(uint32_t frameIndex) {
+        assert(frameIndex < frames.size() && "Frame index out of range of the allocator's frame count");
+        PoolList& list = frames[frameIndex];
+        if (list.setsAllocated == 0) return;
+
+        // only pools that were reached hold sets, the ones past current are still empty from the last reset
+        for (size_t i = 0; i <= list.current && i < list.pools.size(); i++) {
+            vkResetDescriptorPool(deviceInstance.getDevice(), list.pools[i], 0);
+        }
+        list.current = 0;
+        list.setsAllocated = 0;
+        list.resets++;
+    }
+
+    VkDescriptorSet descriptorAllocator::allocateFrom(PoolList& list, VkDescriptorSetLayout layout) {
+        bool freshPool = list.pools.empty(); // the pool about to be tried was created for this allocation and holds nothing yet
+        if (freshPool) addPool(list);
+
+        VkDescriptorSetAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.pSetLayouts = &layout;
+        allocInfo.descriptorSetCount = 1;
+
+        while (true) {
+            allocInfo.descriptorPool = list.pools[list.current];
+            VkDescriptorSet set = VK_NULL_HANDLE;
+            VkResult result = vkAllocateDescriptorSets(deviceInstance.getDevice(), &allocInfo, &set);
+            if (result == VK_SUCCESS) {
+                list.setsAllocated++;
+                list.peakSets = std::max(list.peakSets, list.setsAllocated);
+                return set;
+            }
+            // a set that doesn't fit an empty pool never will, e.g. a descriptor type without a pool ratio, so another pool won't help
+            if ((result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) || freshPool) {
+                throw std::runtime_error("failed to allocate descriptor set!");
+            }
+
+            // this pool is full, move on to the next one, creating it the first time the list gets this far
+            poolsExhausted++;
+            freshPool = list.current + 1 == list.pools.size();
+            if (freshPool) addPool(list);
+            list.current++;
+        }
+    }
+
+    void descriptorAllocator::addPool(PoolList& list) {
+        uint32_t maxSets = list.poolSets.empty() ? setsPerPool : std::min(list.poolSets.back() * 2, MAX_SETS_PER_POOL);
+
+        std::vector<VkDescriptorPoolSize> poolSizes = {};
+        for (const auto& ratio : poolRatios) {
+            poolSizes.push_back({ ratio.first, std::max(1u, static_cast<uint32_t>(std::ceil(ratio.second * static_cast<float>(maxSets)))) });
+        }
+
+        // no FREE_DESCRIPTOR_SET flag: sets are only released by resetting the whole pool, which lets drivers allocate linearly
+        VkDescriptorPoolCreateInfo descriptorPoolInfo = {};
+        descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        descriptorPoolInfo.pPoolSizes = poolSizes.data();
+        descriptorPoolInfo.maxSets = maxSets;
+
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        if (vkCreateDescriptorPool(deviceInstance.getDevice(), &descriptorPoolInfo, nullptr, &pool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+        list.pools.push_back(pool);
+        list.poolSets.push_back(maxSets);
+    }
+
+    void descriptorAllocator::report(std::ostream& out) const {
+        out << "descriptor allocator: " << poolsExhausted << " allocation(s) moved on to another pool" << std::endl;
+        reportList(out, "persistent", persistent);
+        for (size_t i = 0; i < frames.size(); i++) {
+            reportList(out, ("frame " + std::to_string(i)).c_str(), frames[i]);
+        }
+    }
+
+    void descriptorAllocator::reportList(std::ostream& out, const char* name, const PoolList& list) const {
+        uint64_t capacity = 0;
+        for (uint32_t sets : list.poolSets) {
+            capacity += sets;
+        }
+        out << "  " << name << ": " << list.pools.size() << " pool(s), " << list.setsAllocated << " of " << capacity << " set(s) in use, peak " << list.peakSets;
+        if (list.resets > 0) out << ", " << list.resets << " reset(s)";
+        out << std::endl;
+    }
+
+    // *************** Descriptor Buffer Builder *********************
+
+    descriptorBuffer::Builder& descriptorBuffer::Builder::setPersistentSize(VkDeviceSize bytes) {
+        persistentSize = bytes;
+        return *this;
+    }
+
+    descriptorBuffer::Builder& descriptorBuffer::Builder::setFrameSize(VkDeviceSize bytes) {
+        frameSize = bytes;
+        return *this;
+    }
+
+    descriptorBuffer::Builder& descriptorBuffer::Builder::setFrameCount(uint32_t count) {
+        frameCount = count;
+        return *this;
+    }
+
+    std::unique_ptr<descriptorBuffer> descriptorBuffer::Builder::build() const {
+        return std::make_unique<descriptorBuffer>(deviceInstance, persistentSize, frameSize, frameCount);
+    }
+
+    // *************** Descriptor Buffer *********************
+
+    descriptorBuffer::descriptorBuffer(device& deviceInstance, VkDeviceSize persistentSize, VkDeviceSize frameSize, uint32_t frameCount)
+        : deviceInstance{ deviceInstance }, alignment{ std::max<VkDeviceSize>(1, deviceInstance.descriptorBufferProperties.descriptorBufferOffsetAlignment) }, regions(frameCount + 1) {
+        if (!deviceInstance.supportsDescriptorBuffers()) {
+            throw std::runtime_error("descriptor buffers are not supported by the device!");
+        }
+
+        // regions start aligned and every set is rounded up to the alignment, so every offset handed out is aligned too
+        VkDeviceSize totalSize = 0;
+        for (size_t i = 0; i < regions.size(); i++) {
+            regions[i].begin = totalSize;
+            regions[i].size = alignUp(i == 0 ? persistentSize : frameSize, alignment);
+            totalSize += regions[i].size;
+        }
+        assert(totalSize > 0 && "Descriptor buffer has no space for sets");
+
+        // the buffer holds combined image samplers, so it's bound as a sampler buffer as well and both ranges apply
+        const VkPhysicalDeviceDescriptorBufferPropertiesEXT& properties = deviceInstance.descriptorBufferProperties;
+        if (totalSize > std::min(properties.maxResourceDescriptorBufferRange, properties.maxSamplerDescriptorBufferRange)) {
+            throw std::runtime_error("descriptor buffer is larger than the device can address!");
+        }
+
+        deviceInstance.createBuffer(totalSize, DESCRIPTOR_BUFFER_USAGE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, bufferInstance, memory);
+        void* data = nullptr;
+        if (vkMapMemory(deviceInstance.getDevice(), memory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS) {
+            throw std::runtime_error("failed to map descriptor buffer memory!");
+        }
+        mapped = static_cast<char*>(data);
+        address = deviceInstance.getBufferAddress(bufferInstance);
+    }
+
+    descriptorBuffer::~descriptorBuffer() {
+        vkUnmapMemory(deviceInstance.getDevice(), memory);
+        vkDestroyBuffer(deviceInstance.getDevice(), bufferInstance, nullptr);
+        vkFreeMemory(deviceInstance.getDevice(), memory, nullptr);
+    }
+
+    VkDeviceSize descriptorBuffer::allocate(const descriptorSetLayout& layout) {
+        return allocateFrom(regions[0], layout);
+    }
+
+    VkDeviceSize descriptorBuffer::allocateFrame(uint32_t frameIndex, const descriptorSetLayout& layout) {
+        assert(frameIndex + 1 < regions.size() && "Frame index out of range of the descriptor buffer's frame count");
+        return allocateFrom(regions[frameIndex + 1], layout);
+    }
+
+    void descriptorBuffer::resetFrame(uint32_t frameIndex) {
+        assert(frameIndex + 1 < regions.size() && "Frame index out of range of the descriptor buffer's frame count");
+        Region& region = regions[frameIndex + 1];
+        VkDeviceSize used = region.used.load(std::memory_order_relaxed);
+        if (used == 0) return;
+
+        region.peak = std::max(region.peak, std::min(used, region.size));
+        region.used.store(0, std::memory_order_relaxed);
+        region.resets++;
+    }
+
+    VkDeviceSize descriptorBuffer::allocateFrom(Region& region, const descriptorSetLayout& layout) {
+        assert(layout.isDescriptorBuffer() && "Layout was not created for descriptor buffers");
+        VkDeviceSize size = alignUp(layout.getDescriptorBufferSize(), alignment);
+        VkDeviceSize offset = region.used.fetch_add(size, std::memory_order_relaxed);
+        if (offset + size > region.size) {
+            throw std::runtime_error("descriptor buffer region is full!");
+        }
+        return region.begin + offset;
+    }
+
+    void descriptorBuffer::bind(VkCommandBuffer commandBuffer) const {
+        VkDescriptorBufferBindingInfoEXT bindingInfo = {};
+        bindingInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
+        bindingInfo.address = address;
+        bindingInfo.usage = DESCRIPTOR_BUFFER_USAGE;
+        deviceInstance.descriptorBufferFunctions.cmdBindBuffers(commandBuffer, 1, &bindingInfo);
+    }
+
+    void descriptorBuffer::setOffset(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t set, VkDeviceSize offset) const {
+        uint32_t bufferIndex = 0; // the only buffer bind() binds
+        deviceInstance.descriptorBufferFunctions.cmdSetOffsets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, set, 1, &bufferIndex, &offset);
+    }
+
+    void descriptorBuffer::report(std::ostream& out) const {
+        out << "descriptor buffer: " << regions.back().begin + regions.back().size << " bytes, sets aligned to " << alignment << " bytes" << std::endl;
+        for (size_t i = 0; i < regions.size(); i++) {
+            const Region& region = regions[i];
+            VkDeviceSize used = std::min(region.used.load(std::memory_order_relaxed), region.size);
+            out << "  " << (i == 0 ? std::string{ "persistent" } : "frame " + std::to_string(i - 1)) << ": " << used << " of " << region.size << " bytes in use, peak " << std::max(region.peak, used);
+            if (region.resets > 0) out << ", " << region.resets << " reset(s)";
+            out << std::endl;
+        }
+    }
+
     // *************** Descriptor Writer *********************
 
-    descriptorWriter::descriptorWriter(descriptorSetLayout& setLayout, descriptorPool& pool) : setLayout{ setLayout }, pool{ pool } {}
+    descriptorWriter::descriptorWriter(descriptorSetLayout& setLayout, descriptorPool& pool) : setLayout{ setLayout }, pool{ &pool }, descriptors(setLayout.getDescriptorCount()), written(setLayout.getDescriptorCount()) {}
+
+    descriptorWriter::descriptorWriter(descriptorSetLayout& setLayout, descriptorAllocator& allocator) : setLayout{ setLayout }, allocator{ &allocator }, descriptors(setLayout.getDescriptorCount()), written(setLayout.getDescriptorCount()) {}
+
+    descriptorWriter::descriptorWriter(descriptorSetLayout& setLayout) : setLayout{ setLayout }, descriptors(setLayout.getDescriptorCount()), written(setLayout.getDescriptorCount()) {}
 
     descriptorWriter& descriptorWriter::writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo) {
         assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
 
-        auto& bindingDescription = setLayout.bindings[binding];
+        const auto& bindingDescription = setLayout.bindings.at(binding); // at() rather than [], writers may run on several threads
 
         assert(bindingDescription.descriptorCount == 1 && "Binding single descriptor info, but binding expects multiple");
 
@@ -125,6 +450,12 @@ namespace engine {
         write.descriptorCount = 1;
 
         writes.push_back(write);
+        uint32_t offset = setLayout.getDescriptorOffset(binding);
+        descriptors[offset].buffer = *bufferInfo;
+        if (!written[offset]) {
+            written[offset] = true;
+            descriptorsWritten++;
+        }
         return *this;
     }
 
@@ -132,7 +463,7 @@ namespace engine {
         uint32_t binding, VkDescriptorImageInfo* imageInfo) {
         assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
 
-        auto& bindingDescription = setLayout.bindings[binding];
+        const auto& bindingDescription = setLayout.bindings.at(binding);
 
         assert(bindingDescription.descriptorCount == 1 && "Binding single descriptor info, but binding expects multiple");
 
@@ -144,22 +475,109 @@ namespace engine {
         write.descriptorCount = 1;
 
         writes.push_back(write);
+        uint32_t offset = setLayout.getDescriptorOffset(binding);
+        descriptors[offset].image = *imageInfo;
+        if (!written[offset]) {
+            written[offset] = true;
+            descriptorsWritten++;
+        }
         return *this;
     }
 
     bool descriptorWriter::build(VkDescriptorSet& set) {
-        bool success = pool.allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
-        if (!success) {
+        if (allocator) {
+            set = allocator->allocate(setLayout.getDescriptorSetLayout());
+        }
+        else if (!pool->allocateDescriptor(setLayout.getDescriptorSetLayout(), set)) {
             return false;
         }
         overwrite(set);
         return true;
     }
 
+    descriptorWriter& descriptorWriter::useUpdateTemplate(bool enabled) {
+        templateEnabled = enabled;
+        return *this;
+    }
+
+    void descriptorWriter::push(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t set, uint32_t frameIndex) {
+        if (setLayout.isPushDescriptor()) {
+            // dstSet is ignored for pushed writes
+            setLayout.deviceInstance.cmdPushDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, set, static_cast<uint32_t>(writes.size()), writes.data());
+            return;
+        }
+
+        assert(allocator != nullptr && "Pushing without push descriptor support needs a writer built on a descriptorAllocator");
+        VkDescriptorSet descriptorSet = allocator->allocateFrame(frameIndex, setLayout.getDescriptorSetLayout());
+        overwrite(descriptorSet);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, set, 1, &descriptorSet, 0, nullptr);
+    }
+
+    void descriptorWriter::write(descriptorBuffer& buffer, VkDeviceSize offset) {
+        assert(setLayout.isDescriptorBuffer() && "Layout was not created for descriptor buffers");
+        device& deviceInstance = setLayout.deviceInstance;
+        const VkPhysicalDeviceDescriptorBufferPropertiesEXT& properties = deviceInstance.descriptorBufferProperties;
+
+        // each descriptor is encoded by the driver straight into mapped memory, nothing is recorded or submitted
+        for (const auto& write : writes) {
+            VkDescriptorAddressInfoEXT addressInfo = {};
+            addressInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT;
+            if (write.pBufferInfo != nullptr) {
+                assert(write.pBufferInfo->range != VK_WHOLE_SIZE && "Descriptor buffers need an explicit buffer range");
+                addressInfo.address = deviceInstance.getBufferAddress(write.pBufferInfo->buffer) + write.pBufferInfo->offset;
+                addressInfo.range = write.pBufferInfo->range;
+            }
+
+            VkDescriptorGetInfoEXT getInfo = {};
+            getInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+            getInfo.type = write.descriptorType;
+            size_t size = 0;
+            switch (write.descriptorType) {
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+                getInfo.data.pUniformBuffer = &addressInfo;
+                size = properties.uniformBufferDescriptorSize;
+                break;
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+                getInfo.data.pStorageBuffer = &addressInfo;
+                size = properties.storageBufferDescriptorSize;
+                break;
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                getInfo.data.pCombinedImageSampler = write.pImageInfo;
+                size = properties.combinedImageSamplerDescriptorSize;
+                break;
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+                getInfo.data.pSampledImage = write.pImageInfo;
+                size = properties.sampledImageDescriptorSize;
+                break;
+            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+                getInfo.data.pStorageImage = write.pImageInfo;
+                size = properties.storageImageDescriptorSize;
+                break;
+            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                getInfo.data.pInputAttachmentImage = write.pImageInfo;
+                size = properties.inputAttachmentDescriptorSize;
+                break;
+            case VK_DESCRIPTOR_TYPE_SAMPLER:
+                getInfo.data.pSampler = &write.pImageInfo->sampler;
+                size = properties.samplerDescriptorSize;
+                break;
+            default:
+                throw std::runtime_error("descriptor type is not supported in descriptor buffers!");
+            }
+            deviceInstance.descriptorBufferFunctions.getDescriptor(deviceInstance.getDevice(), &getInfo, size, buffer.mapped + offset + setLayout.getDescriptorBufferOffset(write.dstBinding));
+        }
+    }
+
     void descriptorWriter::overwrite(VkDescriptorSet& set) {
+        // a template rewrites every descriptor of the set, so it only stands in for the writes when they cover the layout
+        if (templateEnabled && setLayout.hasUpdateTemplate() && descriptorsWritten == setLayout.getDescriptorCount()) {
+            setLayout.updateWithTemplate(set, descriptors.data());
+            return;
+        }
+
         for (auto& write : writes) {
             write.dstSet = set;
         }
-        vkUpdateDescriptorSets(pool.deviceInstance.getDevice(), writes.size(), writes.data(), 0, nullptr);
+        vkUpdateDescriptorSets(setLayout.deviceInstance.getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
     }
 }
\ No newline at end of file
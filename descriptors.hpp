@@ -1,24 +1,39 @@
 #pragma once
 #include "device.hpp"
+#include <atomic>
 #include <memory>
+#include <ostream>
 #include <unordered_map>
 #include <vector>
 
 namespace engine {
+    // one descriptor of a template update; every kind of info fits, so the entries of a packed update share one stride
+    union DescriptorInfo {
+        VkDescriptorBufferInfo buffer;
+        VkDescriptorImageInfo image;
+        VkBufferView texelBuffer;
+    };
+
     class descriptorSetLayout {
     public:
         class Builder {
         public:
             Builder(device& deviceInstance) : deviceInstance{ deviceInstance } {}
             Builder& addBinding(uint32_t binding, VkDescriptorType descriptorType, VkShaderStageFlags stageFlags, uint32_t count = 1);
+            Builder& setPushDescriptor(bool enabled = true); // for descriptorWriter::push, ignored where push descriptors are unsupported
+            Builder& setDescriptorBuffer(bool enabled = true); // sets live in a descriptorBuffer, ignored where descriptor buffers are unsupported
             std::unique_ptr<descriptorSetLayout> build() const;
 
         private:
             device& deviceInstance;
             std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings = {};
+            bool pushDescriptor = false;
+            bool descriptorBuffer = false;
         };
 
-        descriptorSetLayout(device& deviceInstance, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+        static constexpr uint32_t MAX_PUSH_DESCRIPTORS = 32; // the lowest maxPushDescriptors VK_KHR_push_descriptor allows
+
+        descriptorSetLayout(device& deviceInstance, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings, bool pushDescriptor = false, bool descriptorBuffer = false);
         ~descriptorSetLayout();
 
         descriptorSetLayout(const descriptorSetLayout&) = delete;
@@ -26,10 +41,30 @@ namespace engine {
 
         VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayoutInstance; }
 
+        // descriptor update templates (Vulkan 1.1) write a whole set from one packed array of DescriptorInfo,
+        // ordered by binding number with getDescriptorOffset(binding) as the first element of each binding
+        bool hasUpdateTemplate() const { return updateTemplate != VK_NULL_HANDLE; }
+        bool isPushDescriptor() const { return pushDescriptor; } // created with the push descriptor flag, sets are never allocated from it
+        bool isDescriptorBuffer() const { return descriptorBuffer; } // created with the descriptor buffer flag, pipelines using it need VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT
+        VkDeviceSize getDescriptorBufferSize() const { return descriptorBufferSize; } // bytes one set takes in a descriptor buffer
+        VkDeviceSize getDescriptorBufferOffset(uint32_t binding) const { return descriptorBufferOffsets.at(binding); } // where the binding starts within a set
+        uint32_t getDescriptorOffset(uint32_t binding) const { return descriptorOffsets.at(binding); }
+        uint32_t getDescriptorCount() const { return descriptorCount; } // elements in the packed array
+        void updateWithTemplate(VkDescriptorSet set, const DescriptorInfo* descriptors) const; // every descriptor of the set in one call
+
     private:
+        void createUpdateTemplate();
+
         device& deviceInstance;
         VkDescriptorSetLayout descriptorSetLayoutInstance;
         std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings;
+        std::unordered_map<uint32_t, uint32_t> descriptorOffsets = {};
+        uint32_t descriptorCount = 0;
+        bool pushDescriptor = false;
+        bool descriptorBuffer = false;
+        VkDeviceSize descriptorBufferSize = 0;
+        std::unordered_map<uint32_t, VkDeviceSize> descriptorBufferOffsets = {};
+        VkDescriptorUpdateTemplate updateTemplate = VK_NULL_HANDLE; // owned here, the layout itself belongs to the cache
 
         friend class descriptorWriter;
     };
@@ -72,19 +107,151 @@ namespace engine {
         friend class descriptorWriter;
     };
 
+    // hands out descriptor sets from a growing list of pools, so allocation only fails on real device errors
+    // persistent sets come from pools that live as long as the allocator; per-frame sets come from pools owned by one frame
+    // slot, which are reset in bulk once that slot's fence has signaled, so each set is a bump of the driver's pool pointer
+    class descriptorAllocator {
+    public:
+        static constexpr uint32_t MAX_SETS_PER_POOL = 4096; // cap on pool growth
+
+        class Builder {
+        public:
+            Builder(device& deviceInstance) : deviceInstance{ deviceInstance } {}
+
+            Builder& addPoolRatio(VkDescriptorType descriptorType, float descriptorsPerSet); // pool sizes relative to the set count
+            Builder& setSetsPerPool(uint32_t count); // size of the first pool of each list, later ones double
+            Builder& setFrameCount(uint32_t count); // frame slots with their own pools, usually MAX_FRAMES_IN_FLIGHT
+            std::unique_ptr<descriptorAllocator> build() const;
+
+        private:
+            device& deviceInstance;
+            std::vector<std::pair<VkDescriptorType, float>> poolRatios = {};
+            uint32_t setsPerPool = 64;
+            uint32_t frameCount = 0;
+        };
+
+        descriptorAllocator(device& deviceInstance, uint32_t setsPerPool, const std::vector<std::pair<VkDescriptorType, float>>& poolRatios, uint32_t frameCount);
+        ~descriptorAllocator();
+
+        descriptorAllocator(const descriptorAllocator&) = delete;
+        descriptorAllocator& operator=(const descriptorAllocator&) = delete;
+
+        VkDescriptorSet allocate(VkDescriptorSetLayout layout); // lives until the allocator is destroyed
+        VkDescriptorSet allocateFrame(uint32_t frameIndex, VkDescriptorSetLayout layout); // lives until resetFrame(frameIndex)
+        void resetFrame(uint32_t frameIndex); // call once the frame slot's fence has signaled; keeps the pools for reuse
+
+        void report(std::ostream& out) const; // pools and sets of the persistent and per-frame lists
+
+    private:
+        // pools are filled in order; a reset moves back to the first one instead of destroying them
+        struct PoolList {
+            std::vector<VkDescriptorPool> pools = {};
+            std::vector<uint32_t> poolSets = {}; // max sets of each pool
+            size_t current = 0;
+            uint64_t setsAllocated = 0; // since the last reset
+            uint64_t peakSets = 0;
+            uint64_t resets = 0;
+        };
+
+        VkDescriptorSet allocateFrom(PoolList& list, VkDescriptorSetLayout layout);
+        void addPool(PoolList& list); // the next pool, twice the size of the last
+        void reportList(std::ostream& out, const char* name, const PoolList& list) const;
+
+        device& deviceInstance;
+        uint32_t setsPerPool;
+        std::vector<std::pair<VkDescriptorType, float>> poolRatios;
+        PoolList persistent = {};
+        std::vector<PoolList> frames = {};
+        uint64_t poolsExhausted = 0; // allocations that had to move on to another pool
+    };
+
+    // descriptors written straight into a host-visible buffer with VK_EXT_descriptor_buffer instead of into sets from a pool;
+    // a set is an aligned range of the buffer, bound by its offset. Persistent sets are taken from the front, per-frame sets
+    // from a region per frame slot that resetFrame rewinds. Taking a range is one atomic add, so worker threads can allocate
+    // and write sets at the same time. The size is fixed when it's built, growing would move the buffer and need a rebind
+    class descriptorBuffer {
+    public:
+        class Builder {
+        public:
+            Builder(device& deviceInstance) : deviceInstance{ deviceInstance } {}
+
+            Builder& setPersistentSize(VkDeviceSize bytes);
+            Builder& setFrameSize(VkDeviceSize bytes); // per frame slot
+            Builder& setFrameCount(uint32_t count); // frame slots with their own region, usually MAX_FRAMES_IN_FLIGHT
+            std::unique_ptr<descriptorBuffer> build() const;
+
+        private:
+            device& deviceInstance;
+            VkDeviceSize persistentSize = 64 * 1024;
+            VkDeviceSize frameSize = 256 * 1024;
+            uint32_t frameCount = 0;
+        };
+
+        descriptorBuffer(device& deviceInstance, VkDeviceSize persistentSize, VkDeviceSize frameSize, uint32_t frameCount);
+        ~descriptorBuffer();
+
+        descriptorBuffer(const descriptorBuffer&) = delete;
+        descriptorBuffer& operator=(const descriptorBuffer&) = delete;
+
+        VkDeviceSize allocate(const descriptorSetLayout& layout); // offset of a set that lives as long as the buffer
+        VkDeviceSize allocateFrame(uint32_t frameIndex, const descriptorSetLayout& layout); // lives until resetFrame(frameIndex)
+        void resetFrame(uint32_t frameIndex); // call once the frame slot's fence has signaled
+
+        void bind(VkCommandBuffer commandBuffer) const; // once per command buffer, before any offsets are set
+        void setOffset(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t set, VkDeviceSize offset) const; // binds the set at offset
+
+        void report(std::ostream& out) const; // bytes in use of the persistent and per-frame regions
+
+    private:
+        struct Region {
+            VkDeviceSize begin = 0;
+            VkDeviceSize size = 0;
+            std::atomic<VkDeviceSize> used{ 0 };
+            VkDeviceSize peak = 0; // updated on reset, allocation only touches used
+            uint64_t resets = 0;
+        };
+
+        VkDeviceSize allocateFrom(Region& region, const descriptorSetLayout& layout);
+
+        device& deviceInstance;
+        VkDeviceSize alignment;
+        VkBuffer bufferInstance = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        char* mapped = nullptr;
+        VkDeviceAddress address = 0;
+        std::vector<Region> regions; // the persistent region, then one per frame slot
+
+        friend class descriptorWriter;
+    };
+
     class descriptorWriter {
     public:
         descriptorWriter(descriptorSetLayout& setLayout, descriptorPool& pool);
+        descriptorWriter(descriptorSetLayout& setLayout, descriptorAllocator& allocator); // build allocates a persistent set
+        descriptorWriter(descriptorSetLayout& setLayout); // for write(descriptorBuffer&, offset) only, nothing is allocated
 
         descriptorWriter& writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo);
         descriptorWriter& writeImage(uint32_t binding, VkDescriptorImageInfo* imageInfo);
+        descriptorWriter& useUpdateTemplate(bool enabled); // on by default, off forces vkUpdateDescriptorSets
 
         bool build(VkDescriptorSet& set);
-        void overwrite(VkDescriptorSet& set);
+        void overwrite(VkDescriptorSet& set); // one template update when every descriptor of the layout was written
+
+        // per-draw resources: recorded straight into the command buffer for push descriptor layouts, otherwise written to a
+        // set from the allocator's pools for frameIndex and bound; either way the writes are consumed at record time
+        void push(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t set, uint32_t frameIndex);
+
+        // encodes the writes into the set at offset of a descriptor buffer; buffer ranges must be explicit, not VK_WHOLE_SIZE
+        void write(descriptorBuffer& buffer, VkDeviceSize offset);
 
     private:
         descriptorSetLayout& setLayout;
-        descriptorPool& pool;
+        descriptorPool* pool = nullptr;
+        descriptorAllocator* allocator = nullptr;
         std::vector<VkWriteDescriptorSet> writes;
+        std::vector<DescriptorInfo> descriptors; // the same writes packed for the layout's update template
+        std::vector<bool> written; // per element of descriptors, so writing a binding twice doesn't count as covering another
+        uint32_t descriptorsWritten = 0; // distinct elements written
+        bool templateEnabled = true;
     };
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "device.hpp"
+#include "startupprofiler.hpp"
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -37,16 +38,30 @@ namespace engine {
 		}
 	}
 
-	device::device(window& windowInstance) : windowInstance{ windowInstance } {
+	device::device(window& windowInstance) : windowInstance{ &windowInstance } {
+		startupProfiler::phase phase{ "device" };
 		createInstance();
 		setupDebugMessenger();
 		createSurface();
 		pickPhysicalDevice();
 		createLogicalDevice();
 		createCommandPool();
+		layoutCacheInstance = std::make_unique<layoutCache>(device_);
+	}
+
+	device::device() {
+		startupProfiler::phase phase{ "device" };
+		deviceExtensions.clear(); // nothing is presented, so the swap chain extension isn't needed
+		createInstance();
+		setupDebugMessenger();
+		pickPhysicalDevice();
+		createLogicalDevice();
+		createCommandPool();
+		layoutCacheInstance = std::make_unique<layoutCache>(device_);
 	}
 
 	device::~device() {
+		layoutCacheInstance.reset();
 		vkDestroyCommandPool(device_, commandPool, nullptr);
 		vkDestroyDevice(device_, nullptr);
 
@@ -54,7 +69,9 @@ namespace engine {
 			DestroyDebugUtilsMessengerEXT(vulkanInstance, debugMessenger, nullptr);
 		}
 
-		vkDestroySurfaceKHR(vulkanInstance, surface_, nullptr);
+		if (surface_ != VK_NULL_HANDLE) {
+			vkDestroySurfaceKHR(vulkanInstance, surface_, nullptr);
+		}
 		vkDestroyInstance(vulkanInstance, nullptr);
 	}
 
@@ -70,7 +87,7 @@ namespace engine {
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "No Engine";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		appInfo.apiVersion = VK_API_VERSION_1_1; // for descriptor update templates, devices that only support 1.0 still work
 
 		// specify global extensions and validation layers to Vulkan driver
 		VkInstanceCreateInfo createInfo = {};
@@ -152,14 +169,66 @@ namespace engine {
 		VkPhysicalDeviceFeatures deviceFeatures = {};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+		// optional extensions are enabled when the device has them, the features built on them fall back otherwise
+		uint32_t extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+		std::unordered_set<std::string> availableNames = {};
+		for (const auto& extension : availableExtensions) {
+			availableNames.insert(extension.extensionName);
+		}
+		std::vector<const char*> enabledExtensions = deviceExtensions;
+		bool pushDescriptorAvailable = availableNames.count(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) > 0;
+		if (pushDescriptorAvailable) enabledExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+
+		// descriptor buffers come with their dependencies, and the features have to be queried through the 1.1 entry point
+		const char* descriptorBufferExtensions[] = { VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME, VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME };
+		bool descriptorBufferAvailable = deviceProperties.apiVersion >= VK_API_VERSION_1_1;
+		for (const char* name : descriptorBufferExtensions) {
+			if (availableNames.count(name) == 0) descriptorBufferAvailable = false;
+		}
+		VkPhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddressFeatures = {};
+		bufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+		VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures = {};
+		descriptorBufferFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+		descriptorBufferFeatures.pNext = &bufferDeviceAddressFeatures;
+		VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
+		deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		deviceFeatures2.pNext = &descriptorBufferFeatures;
+		if (descriptorBufferAvailable) {
+			vkGetPhysicalDeviceFeatures2(physicalDevice, &deviceFeatures2);
+			descriptorBufferAvailable = descriptorBufferFeatures.descriptorBuffer && bufferDeviceAddressFeatures.bufferDeviceAddress;
+		}
+		if (descriptorBufferAvailable) {
+			enabledExtensions.insert(enabledExtensions.end(), std::begin(descriptorBufferExtensions), std::end(descriptorBufferExtensions));
+
+			// enable only what's used, the query above filled in every feature the device has
+			VkPhysicalDeviceBufferDeviceAddressFeatures enabledAddressFeatures = {};
+			enabledAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+			enabledAddressFeatures.bufferDeviceAddress = VK_TRUE;
+			bufferDeviceAddressFeatures = enabledAddressFeatures;
+			VkPhysicalDeviceDescriptorBufferFeaturesEXT enabledBufferFeatures = {};
+			enabledBufferFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+			enabledBufferFeatures.pNext = &bufferDeviceAddressFeatures;
+			enabledBufferFeatures.descriptorBuffer = VK_TRUE;
+			descriptorBufferFeatures = enabledBufferFeatures;
+			deviceFeatures2.features = deviceFeatures;
+		}
+
 		// create the logical device
 		VkDeviceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
-		createInfo.pEnabledFeatures = &deviceFeatures;
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		if (descriptorBufferAvailable) {
+			createInfo.pNext = &deviceFeatures2; // the extension features are chained, so the core ones travel with them
+		}
+		else {
+			createInfo.pEnabledFeatures = &deviceFeatures;
+		}
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+		createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 		
 		// enabledLayerCount and ppEnabledLayerNames fields of VkDeviceCreateInfo are ignored by up-to-date implementations
 		// but it's a good idea to set them up anyway to be compatible with older implementations
@@ -179,6 +248,33 @@ namespace engine {
 		// retrieve queue handles for each queue family
 		vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
 		vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+		// extension commands aren't exported by the loader, so they're fetched from the device
+		if (pushDescriptorAvailable) {
+			cmdPushDescriptorSet = (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(device_, "vkCmdPushDescriptorSetKHR");
+		}
+		if (descriptorBufferAvailable) {
+			descriptorBufferFunctions.getLayoutSize = (PFN_vkGetDescriptorSetLayoutSizeEXT)vkGetDeviceProcAddr(device_, "vkGetDescriptorSetLayoutSizeEXT");
+			descriptorBufferFunctions.getLayoutBindingOffset = (PFN_vkGetDescriptorSetLayoutBindingOffsetEXT)vkGetDeviceProcAddr(device_, "vkGetDescriptorSetLayoutBindingOffsetEXT");
+			descriptorBufferFunctions.getDescriptor = (PFN_vkGetDescriptorEXT)vkGetDeviceProcAddr(device_, "vkGetDescriptorEXT");
+			descriptorBufferFunctions.cmdBindBuffers = (PFN_vkCmdBindDescriptorBuffersEXT)vkGetDeviceProcAddr(device_, "vkCmdBindDescriptorBuffersEXT");
+			descriptorBufferFunctions.cmdSetOffsets = (PFN_vkCmdSetDescriptorBufferOffsetsEXT)vkGetDeviceProcAddr(device_, "vkCmdSetDescriptorBufferOffsetsEXT");
+			descriptorBufferFunctions.getBufferAddress = (PFN_vkGetBufferDeviceAddressKHR)vkGetDeviceProcAddr(device_, "vkGetBufferDeviceAddressKHR");
+
+			// descriptor sizes and offset alignment are device specific
+			descriptorBufferProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT;
+			VkPhysicalDeviceProperties2 deviceProperties2 = {};
+			deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			deviceProperties2.pNext = &descriptorBufferProperties;
+			vkGetPhysicalDeviceProperties2(physicalDevice, &deviceProperties2);
+		}
+
+		// remember whether the graphics queue can be timed with timestamp queries
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+		timestampValidBits = deviceProperties.limits.timestampComputeAndGraphics ? queueFamilies[indices.graphicsFamily].timestampValidBits : 0;
 	}
 
 	void device::createCommandPool() {
@@ -195,15 +291,15 @@ namespace engine {
 		}
 	}
 
-	void device::createSurface() { windowInstance.createWindowSurface(vulkanInstance, &surface_); }
+	void device::createSurface() { windowInstance->createWindowSurface(vulkanInstance, &surface_); }
 
 	bool device::isDeviceSuitable(VkPhysicalDevice deviceInstance) {
 		QueueFamilyIndices indices = findQueueFamilies(deviceInstance);
 
 		bool extensionsSupported = checkDeviceExtensionSupport(deviceInstance);
 
-		bool swapchainAdequate = false;
-		if (extensionsSupported) {
+		bool swapchainAdequate = isHeadless(); // without a surface there is no swap chain to support
+		if (extensionsSupported && !isHeadless()) {
 			SwapChainSupportDetails swapchainSupport = querySwapchainSupport(deviceInstance);
 			swapchainAdequate = !swapchainSupport.formats.empty() && !swapchainSupport.presentModes.empty();
 		}
@@ -261,10 +357,21 @@ namespace engine {
 	}
 
 	std::vector<const char*> device::getRequiredExtensions() {
-		uint32_t glfwExtensionCount = 0;
-		const char** glfwExtensions;
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount); // GLFW's handy built-in function to return extensions
-		std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		std::vector<const char*> extensions = {};
+#ifdef ENGINE_NULL_VULKAN
+		// GLFW can't report extensions without a real loader; the window's stand-in surface needs these instead
+		if (!isHeadless()) {
+			extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+			extensions.push_back(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+		}
+#else
+		if (!isHeadless()) {
+			uint32_t glfwExtensionCount = 0;
+			const char** glfwExtensions;
+			glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount); // GLFW's handy built-in function to return extensions
+			extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		}
+#endif
 
 		if (enableValidationLayers) { extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME); }
 
@@ -328,8 +435,14 @@ namespace engine {
 			}
 
 			// look for a queue family that has the capability of presenting to the window surface
+			// when headless nothing is presented, so the graphics queue doubles as the present queue
 			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(deviceInstance, i, surface_, &presentSupport);
+			if (surface_ != VK_NULL_HANDLE) {
+				vkGetPhysicalDeviceSurfaceSupportKHR(deviceInstance, i, surface_, &presentSupport);
+			}
+			else {
+				presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+			}
 			if (queueFamily.queueCount > 0 && presentSupport) {
 				indices.presentFamily = i;
 				indices.presentFamilyHasValue = true;
@@ -401,6 +514,13 @@ namespace engine {
 		throw std::runtime_error("failed to find suitable memory type!");
 	}
 
+	VkDeviceAddress device::getBufferAddress(VkBuffer buffer) {
+		VkBufferDeviceAddressInfo addressInfo = {};
+		addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+		addressInfo.buffer = buffer;
+		return descriptorBufferFunctions.getBufferAddress(device_, &addressInfo);
+	}
+
 	void device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
 		VkBufferCreateInfo bufferInfo = {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -408,6 +528,12 @@ namespace engine {
 		bufferInfo.usage = usage;
 		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+		// descriptor buffers reference buffers by address, so any buffer a descriptor can point at needs one
+		const VkBufferUsageFlags descriptorUsage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+		if (supportsDescriptorBuffers() && (usage & descriptorUsage) != 0) {
+			bufferInfo.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+		}
+
 		if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create vertex buffer!");
 		}
@@ -420,6 +546,12 @@ namespace engine {
 		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 		allocInfo.allocationSize = memRequirements.size;
 		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+		VkMemoryAllocateFlagsInfo allocFlagsInfo = {};
+		allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+		allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+		if ((bufferInfo.usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) != 0) {
+			allocInfo.pNext = &allocFlagsInfo;
+		}
 
 		if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
 			throw std::runtime_error("failed to allocate vertex buffer memory!");
@@ -463,13 +595,13 @@ namespace engine {
 		vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
 	}
 
-	void device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+	void device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) {
 		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
 		// transfer the contents of buffers with the vkCmdCopyBuffer command
 		VkBufferCopy copyRegion = {};
-		copyRegion.srcOffset = 0; // optional
-		copyRegion.dstOffset = 0; // optional
+		copyRegion.srcOffset = srcOffset;
+		copyRegion.dstOffset = dstOffset;
 		copyRegion.size = size;
 		vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
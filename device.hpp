@@ -1,5 +1,7 @@
 #pragma once
 #include "window.hpp"
+#include "layoutcache.hpp"
+#include <memory>
 #include <string>
 #include <vector>
 #include <optional>
@@ -21,6 +23,16 @@ namespace engine {
 		bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
 	};
 
+	// VK_EXT_descriptor_buffer commands, fetched from the device; all null when the extension isn't enabled
+	struct DescriptorBufferFunctions {
+		PFN_vkGetDescriptorSetLayoutSizeEXT getLayoutSize = nullptr;
+		PFN_vkGetDescriptorSetLayoutBindingOffsetEXT getLayoutBindingOffset = nullptr;
+		PFN_vkGetDescriptorEXT getDescriptor = nullptr;
+		PFN_vkCmdBindDescriptorBuffersEXT cmdBindBuffers = nullptr;
+		PFN_vkCmdSetDescriptorBufferOffsetsEXT cmdSetOffsets = nullptr;
+		PFN_vkGetBufferDeviceAddressKHR getBufferAddress = nullptr;
+	};
+
 	class device {
 	public:
 #ifdef NDEBUG // not to be compiled in debug mode
@@ -29,6 +41,7 @@ namespace engine {
 		const bool enableValidationLayers = true;
 #endif
 		device(window& windowInstance); // constructor
+		device(); // constructor without a window or surface, for offscreen rendering and benchmarks
 		~device(); // destructor
 
 		// not copyable or movable
@@ -43,19 +56,31 @@ namespace engine {
 		VkSurfaceKHR getSurface() { return surface_; }
 		VkQueue getGraphicsQueue() { return graphicsQueue_; }
 		VkQueue getPresentQueue() { return presentQueue_; }
+		layoutCache& getLayoutCache() { return *layoutCacheInstance; } // shared descriptor set and pipeline layouts
+		bool isHeadless() const { return windowInstance == nullptr; } // true when there is no surface to present to
+		bool supportsUpdateTemplates() const { return deviceProperties.apiVersion >= VK_API_VERSION_1_1; } // descriptor update templates are core in 1.1
+		bool supportsPushDescriptors() const { return cmdPushDescriptorSet != nullptr; } // VK_KHR_push_descriptor was found and enabled
+		bool supportsDescriptorBuffers() const { return descriptorBufferFunctions.getDescriptor != nullptr; } // VK_EXT_descriptor_buffer and buffer device addresses were enabled
+		bool supportsTimestamps() const { return timestampValidBits > 0; } // whether the graphics queue can write timestamp queries
+		uint32_t getTimestampValidBits() const { return timestampValidBits; }
+		float getTimestampPeriod() const { return deviceProperties.limits.timestampPeriod; } // nanoseconds per timestamp tick
 
 		SwapChainSupportDetails getSwapchainSupport() { return querySwapchainSupport(physicalDevice); } // get swap chain support details for the physical device
 		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties); // find the right type of memory to use based on the vertex buffer and our own app requirements
 		QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); } // look for all the queue families we need
 		VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
+		VkDeviceAddress getBufferAddress(VkBuffer buffer); // needs descriptor buffer support, which gives buffers a device address
 		void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory); // initialize and return a buffer
 		VkCommandBuffer beginSingleTimeCommands();
 		void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
 		void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 		void createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
 		VkPhysicalDeviceProperties deviceProperties;
+		PFN_vkCmdPushDescriptorSetKHR cmdPushDescriptorSet = nullptr; // null without VK_KHR_push_descriptor
+		DescriptorBufferFunctions descriptorBufferFunctions = {};
+		VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties = {}; // descriptor sizes and alignment, zero without the extension
 
 	private:
 		void createInstance(); // initialize the Vulkan library
@@ -77,15 +102,17 @@ namespace engine {
 		VkInstance vulkanInstance; // data member to handle Vulkan instance
 		VkDebugUtilsMessengerEXT debugMessenger; // a handle to tell Vulkan about the callback function, needs to be created and destroyed
 		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE; // a handle to store the graphics card that will be implicitly destroyed when VkInstance is destroyed
-		window& windowInstance; // a handle to store the window instance
+		window* windowInstance = nullptr; // a handle to store the window instance, null when headless
 		VkCommandPool commandPool; // a handle to store the command pool to manage buffer/command buffer memory
 		
 		VkDevice device_;
-		VkSurfaceKHR surface_; // a handle to store the surface to present rendered images to
+		VkSurfaceKHR surface_ = VK_NULL_HANDLE; // a handle to store the surface to present rendered images to
 		VkQueue graphicsQueue_; // a handle to store the graphics queue
 		VkQueue presentQueue_; // a handle to store the presentation queue
+		uint32_t timestampValidBits = 0; // valid bits in graphics queue timestamps, 0 if unsupported
+		std::unique_ptr<layoutCache> layoutCacheInstance = {}; // a handle for the layout cache, destroyed before the logical device
 
 		const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" }; // standard validation is bundled into this layer included in the SDK
-		const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME }; // list of required device extensions
+		std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME }; // list of required device extensions, empty when headless
 	};
 }
\ No newline at end of file
@@ -40,6 +40,7 @@ namespace engine {
 		std::shared_ptr<model> modelInstance = {};
 		glm::vec3 color = {};
 		TransformComponent transform = {};
+		bool isStatic = false; // rarely moves, so staticBatcher may merge it into a world space chunk
 
 	private:
 		entity(id_t entityId) : id{entityId} {} // constructor
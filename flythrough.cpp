@@ -0,0 +1,155 @@
+#include "flythrough.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace engine {
+	// *************** Camera path *********************
+
+	cameraPath cameraPath::load(const std::string& filepath) {
+		std::ifstream file{ filepath };
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open camera path: " + filepath);
+		}
+
+		cameraPath pathInstance = {};
+		std::string line = {};
+		uint32_t lineNumber = 0;
+		while (std::getline(file, line)) {
+			lineNumber++;
+			std::istringstream stream{ line };
+			std::string command = {};
+			if (!(stream >> command) || command[0] == '#') continue;
+
+			if (command == "segment") {
+				std::string name = {};
+				if (!(stream >> name)) {
+					throw std::runtime_error("failed to parse camera path " + filepath + " line " + std::to_string(lineNumber) + ": segment needs a name!");
+				}
+				pathInstance.segmentNames.push_back(name);
+			}
+			else if (command == "key") {
+				Key key = {};
+				if (!(stream >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.rotation.x >> key.rotation.y >> key.rotation.z)) {
+					throw std::runtime_error("failed to parse camera path " + filepath + " line " + std::to_string(lineNumber) + ": key needs a time, position and rotation!");
+				}
+				if (!pathInstance.keys.empty() && key.time <= pathInstance.keys.back().time) {
+					throw std::runtime_error("failed to parse camera path " + filepath + " line " + std::to_string(lineNumber) + ": key times must increase!");
+				}
+				if (pathInstance.segmentNames.empty()) {
+					pathInstance.segmentNames.push_back("path"); // keys before the first segment line
+				}
+				key.segment = static_cast<uint32_t>(pathInstance.segmentNames.size() - 1);
+				pathInstance.keys.push_back(key);
+			}
+			else {
+				throw std::runtime_error("failed to parse camera path " + filepath + " line " + std::to_string(lineNumber) + ": unknown command " + command + "!");
+			}
+		}
+
+		if (pathInstance.keys.size() < 2) {
+			throw std::runtime_error("failed to load camera path " + filepath + ": at least two keys are needed!");
+		}
+		return pathInstance;
+	}
+
+	// uniform Catmull-Rom between p1 and p2
+	static glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float u) {
+		float u2 = u * u;
+		float u3 = u2 * u;
+		return 0.5f * (2.f * p1 + (p2 - p0) * u + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * u2 + (3.f * p1 - p0 - 3.f * p2 + p3) * u3);
+	}
+
+	// index of the key that starts the interval holding time
+	static size_t intervalAt(const std::vector<cameraPath::Key>& keys, float time) {
+		auto next = std::upper_bound(keys.begin(), keys.end(), time, [](float t, const cameraPath::Key& key) { return t < key.time; });
+		size_t index = next == keys.begin() ? 0 : static_cast<size_t>(next - keys.begin()) - 1;
+		return std::min(index, keys.size() - 2);
+	}
+
+	void cameraPath::sample(float time, glm::vec3& position, glm::vec3& rotation) const {
+		time = std::clamp(time, keys.front().time, keys.back().time);
+		size_t i = intervalAt(keys, time);
+		const Key& k0 = keys[i > 0 ? i - 1 : 0];
+		const Key& k1 = keys[i];
+		const Key& k2 = keys[i + 1];
+		const Key& k3 = keys[std::min(i + 2, keys.size() - 1)];
+
+		float u = (time - k1.time) / (k2.time - k1.time);
+		position = catmullRom(k0.position, k1.position, k2.position, k3.position, u);
+		rotation = catmullRom(k0.rotation, k1.rotation, k2.rotation, k3.rotation, u);
+	}
+
+	uint32_t cameraPath::segmentAt(float time) const {
+		return keys[intervalAt(keys, time)].segment;
+	}
+
+	std::vector<float> cameraPath::getSegmentDurations() const {
+		std::vector<float> durations(segmentNames.size(), 0.f);
+		for (size_t i = 0; i + 1 < keys.size(); i++) {
+			durations[keys[i].segment] += keys[i + 1].time - keys[i].time;
+		}
+		return durations;
+	}
+
+	// *************** Flythrough *********************
+
+	flythrough::flythrough(Settings settings) : settings{ std::move(settings) }, path{ cameraPath::load(this->settings.pathFile) } {
+		// size the sample lists up front so recording doesn't allocate mid-run; fixed timing knows its frame count, measured
+		// timing guesses at most MAX_MEASURED_FPS and only a faster run grows the lists
+		std::vector<float> segmentDurations = path.getSegmentDurations();
+		float framesPerSecond = this->settings.fixedFrameTime > 0.f ? 1.f / this->settings.fixedFrameTime : MAX_MEASURED_FPS;
+		segmentFrameTimes.resize(segmentDurations.size());
+		for (size_t i = 0; i < segmentDurations.size(); i++) {
+			double frames = std::ceil(static_cast<double>(segmentDurations[i]) * framesPerSecond) + 2.0;
+			segmentFrameTimes[i].reserve(static_cast<size_t>(std::min(frames, static_cast<double>(MAX_RESERVED_SAMPLES))));
+		}
+	}
+
+	float flythrough::beginFrame(float measuredFrameTime, entity& viewerEntity) {
+		frameTime = settings.fixedFrameTime > 0.f ? settings.fixedFrameTime : measuredFrameTime;
+		path.sample(pathTime, viewerEntity.transform.translation, viewerEntity.transform.rotation);
+		frameStart = clock::now();
+		return frameTime;
+	}
+
+	void flythrough::endFrame() {
+		// only frames that were drawn move along the path, a frame the renderer skipped (e.g. while the swapchain is
+		// recreated) leaves its part of the path for the next one
+		if (framesDrawn++ < settings.warmupFrames) return;
+		double frameMs = std::chrono::duration<double, std::milli>(clock::now() - frameStart).count();
+		segmentFrameTimes[path.segmentAt(pathTime)].push_back(frameMs);
+		pathTime += frameTime; // the first timed frame is drawn at the start of the path
+	}
+
+	void flythrough::report(std::ostream& out, const std::string& deviceName, uint64_t entityCount) const {
+		benchmarkSuite suite{ "flythrough" };
+		suite.setContext("path", settings.pathFile);
+		suite.setContext("timing", settings.fixedFrameTime > 0.f ? "fixed " + std::to_string(settings.fixedFrameTime) + " s" : "measured");
+		suite.setContext("device", deviceName);
+		suite.setContext("entities", std::to_string(entityCount));
+		suite.setContext("warmup_frames", std::to_string(settings.warmupFrames));
+
+		// from the top of a frame to its submission, which includes waiting on the fence of the frame slot being reused
+		BenchmarkResult totalResult = {};
+		totalResult.name = "path.total";
+		totalResult.unit = "ms";
+		for (size_t i = 0; i < segmentFrameTimes.size(); i++) {
+			if (segmentFrameTimes[i].empty()) continue;
+			BenchmarkResult segmentResult = {};
+			segmentResult.name = "segment." + path.getSegmentNames()[i];
+			segmentResult.unit = "ms";
+			segmentResult.samples = segmentFrameTimes[i];
+			totalResult.samples.insert(totalResult.samples.end(), segmentFrameTimes[i].begin(), segmentFrameTimes[i].end());
+			suite.addResult(std::move(segmentResult));
+		}
+		suite.addResult(std::move(totalResult));
+
+		suite.printSummary(out);
+		if (!settings.jsonPath.empty()) {
+			suite.writeJson(settings.jsonPath);
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "benchmark.hpp"
+#include "entity.hpp"
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace engine {
+	// camera path through a scene, read from a text file with one entry per line:
+	//   # comment
+	//   segment <name>                        names the keys that follow, up to the next segment line
+	//   key <time> <x> <y> <z> <rx> <ry> <rz>  camera position and setViewYXZ rotation at a time in seconds
+	// keys must be in increasing time order; positions and rotations follow a Catmull-Rom spline through them,
+	// so write yaw continuously (e.g. 6.5 rather than 0.2) to turn through a full circle
+	class cameraPath {
+	public:
+		struct Key {
+			float time = 0.f;
+			glm::vec3 position = {};
+			glm::vec3 rotation = {};
+			uint32_t segment = 0; // index into the segment names
+		};
+
+		static cameraPath load(const std::string& filepath); // parse a path file, throws on malformed input
+
+		void sample(float time, glm::vec3& position, glm::vec3& rotation) const; // camera pose at a time, clamped to the path
+		uint32_t segmentAt(float time) const; // segment the camera is in at a time
+		std::vector<float> getSegmentDurations() const; // seconds spent in each segment
+
+		float getDuration() const { return keys.empty() ? 0.f : keys.back().time; }
+		const std::vector<std::string>& getSegmentNames() const { return segmentNames; }
+
+	private:
+		std::vector<Key> keys = {}; // at least two, in time order
+		std::vector<std::string> segmentNames = {};
+	};
+
+	// benchmark mode that moves the viewer along a camera path instead of following input and reports frame times per segment
+	class flythrough {
+	public:
+		using clock = std::chrono::steady_clock;
+		static constexpr float MAX_MEASURED_FPS = 10000.f; // frame rate the sample lists are sized for with measured timing
+		static constexpr size_t MAX_RESERVED_SAMPLES = 1 << 20; // per segment, so a long path doesn't reserve gigabytes up front
+
+		struct Settings {
+			std::string pathFile = {};
+			float fixedFrameTime = 0.f; // seconds the path advances per frame, 0 advances it by the measured frame time
+			uint32_t warmupFrames = 30; // frames held at the first key before timing starts
+			std::string jsonPath = {}; // optional results file in the benchmark JSON layout
+		};
+
+		flythrough(Settings settings); // constructor, loads the path
+
+		// not copyable or movable
+		flythrough(const flythrough&) = delete;
+		flythrough& operator = (const flythrough&) = delete;
+
+		float beginFrame(float measuredFrameTime, entity& viewerEntity); // move the viewer for this frame and return the frame time to simulate with
+		void endFrame(); // after a frame was drawn, attribute the time since beginFrame to its segment and advance the path
+		bool isFinished() const { return pathTime > path.getDuration(); }
+
+		void report(std::ostream& out, const std::string& deviceName, uint64_t entityCount) const; // print per-segment statistics and write the JSON file if one was requested
+
+	private:
+		Settings settings;
+		cameraPath path;
+		float pathTime = 0.f; // seconds along the path of the current frame
+		float frameTime = 0.f; // what the current frame simulates, added to pathTime once it's drawn
+		uint32_t framesDrawn = 0;
+		clock::time_point frameStart = {};
+		std::vector<std::vector<double>> segmentFrameTimes = {}; // milliseconds per frame, one list per segment
+	};
+}
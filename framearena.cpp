@@ -0,0 +1,144 @@
+#include "framearena.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+namespace engine {
+	static constexpr size_t BLOCK_ALIGNMENT = 64; // keep each arena on its own cache lines
+
+	// *************** Linear Arena *********************
+
+	linearArena::linearArena(size_t capacity, std::pmr::memory_resource* upstream) : upstream{ upstream }, capacity{ capacity } {
+		if (capacity > 0) {
+			block = static_cast<std::byte*>(upstream->allocate(capacity, BLOCK_ALIGNMENT));
+		}
+	}
+
+	linearArena::~linearArena() {
+		releaseOverflow();
+		if (block != nullptr) {
+			upstream->deallocate(block, capacity, BLOCK_ALIGNMENT);
+		}
+	}
+
+	void linearArena::reset() {
+		highWaterMark = std::max(highWaterMark, getUsed());
+
+		// if the last frame spilled, grow the block so the same workload fits next time
+		bool spilled = overflowBlocks != nullptr;
+		releaseOverflow();
+		if (spilled && highWaterMark > capacity) {
+			size_t newCapacity = std::max(highWaterMark, capacity * 2);
+			std::byte* newBlock = static_cast<std::byte*>(upstream->allocate(newCapacity, BLOCK_ALIGNMENT));
+			if (block != nullptr) {
+				upstream->deallocate(block, capacity, BLOCK_ALIGNMENT);
+			}
+			block = newBlock;
+			capacity = newCapacity;
+		}
+
+		used = 0;
+	}
+
+	void* linearArena::do_allocate(size_t bytes, size_t alignment) {
+		// align the absolute address, not the offset, since alignment can exceed the block alignment
+		uintptr_t base = reinterpret_cast<uintptr_t>(block);
+		uintptr_t aligned = (base + used + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+		size_t newUsed = static_cast<size_t>(aligned - base) + bytes;
+
+		if (block == nullptr || newUsed > capacity) {
+			return allocateOverflow(bytes, alignment);
+		}
+
+		used = newUsed;
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	void* linearArena::allocateOverflow(size_t bytes, size_t alignment) {
+		// the list node sits in front of the payload, padded so the payload keeps its alignment
+		size_t blockAlignment = std::max(alignment, alignof(OverflowBlock));
+		size_t headerSize = (sizeof(OverflowBlock) + blockAlignment - 1) & ~(blockAlignment - 1);
+		size_t size = headerSize + bytes;
+		std::byte* memory = static_cast<std::byte*>(upstream->allocate(size, blockAlignment));
+
+		OverflowBlock* header = reinterpret_cast<OverflowBlock*>(memory + headerSize - sizeof(OverflowBlock));
+		header->next = overflowBlocks;
+		header->size = size;
+		header->alignment = blockAlignment;
+		overflowBlocks = header;
+		overflowBytes += bytes;
+		overflowCount++;
+
+		return memory + headerSize;
+	}
+
+	void linearArena::releaseOverflow() {
+		while (overflowBlocks != nullptr) {
+			OverflowBlock* header = overflowBlocks;
+			overflowBlocks = header->next;
+
+			// the header ends where the payload starts, so step back over the padded header to find the allocation
+			size_t headerSize = (sizeof(OverflowBlock) + header->alignment - 1) & ~(header->alignment - 1);
+			std::byte* memory = reinterpret_cast<std::byte*>(header + 1) - headerSize;
+			upstream->deallocate(memory, header->size, header->alignment);
+		}
+		overflowBytes = 0;
+	}
+
+	// *************** Frame Arena *********************
+
+	frameArena::frameArena(size_t capacityPerThread) : capacityPerThread{ capacityPerThread } {}
+
+	frameArena::~frameArena() {}
+
+	int frameArena::threadSlot() {
+		static std::atomic<int> nextSlot{ 0 };
+		thread_local int slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+		if (slot >= MAX_THREADS) {
+			throw std::runtime_error("too many threads requested a frame arena!");
+		}
+		return slot;
+	}
+
+	void frameArena::beginFrame(int frameIndex) {
+		currentFrameIndex = frameIndex;
+		for (auto& arena : arenas[frameIndex]) {
+			if (arena != nullptr) {
+				arena->reset();
+			}
+		}
+	}
+
+	linearArena& frameArena::threadArena() {
+		auto& arena = arenas[currentFrameIndex][threadSlot()];
+		if (arena == nullptr) {
+			arena = std::make_unique<linearArena>(capacityPerThread);
+		}
+		return *arena;
+	}
+
+	size_t frameArena::getHighWaterMark() const {
+		size_t highWaterMark = 0;
+		for (const auto& frame : arenas) {
+			for (const auto& arena : frame) {
+				if (arena != nullptr) {
+					highWaterMark = std::max(highWaterMark, std::max(arena->getHighWaterMark(), arena->getUsed()));
+				}
+			}
+		}
+		return highWaterMark;
+	}
+
+	void frameArena::report(std::ostream& out) const {
+		out << "frame arenas:" << std::endl;
+		for (size_t frame = 0; frame < arenas.size(); frame++) {
+			for (size_t thread = 0; thread < arenas[frame].size(); thread++) {
+				const auto& arena = arenas[frame][thread];
+				if (arena == nullptr) continue;
+				out << "\tframe " << frame << " thread " << thread << ": high water " << std::max(arena->getHighWaterMark(), arena->getUsed())
+					<< " of " << arena->getCapacity() << " bytes, " << arena->getOverflowCount() << " overflows" << std::endl;
+			}
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "swapchain.hpp"
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <ostream>
+
+namespace engine {
+	// bump allocator over a single block; deallocation is a no-op and everything is released at once by reset()
+	// requests that don't fit spill to the upstream resource, and the block grows to the high water mark on the next reset
+	class linearArena : public std::pmr::memory_resource {
+	public:
+		linearArena(size_t capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()); // constructor
+		~linearArena(); // destructor
+
+		// not copyable or movable
+		linearArena(const linearArena&) = delete;
+		linearArena& operator = (const linearArena&) = delete;
+
+		void reset(); // release every allocation made since the last reset
+
+		size_t getCapacity() const { return capacity; }
+		size_t getUsed() const { return used + overflowBytes; } // bytes handed out since the last reset
+		size_t getHighWaterMark() const { return highWaterMark; } // most bytes ever in use between two resets
+		size_t getOverflowCount() const { return overflowCount; } // requests that spilled to the upstream resource since startup
+
+	private:
+		struct OverflowBlock {
+			OverflowBlock* next;
+			size_t size;
+			size_t alignment;
+		};
+
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void*, size_t, size_t) override {} // memory is reclaimed by reset()
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+		void* allocateOverflow(size_t bytes, size_t alignment); // fall back to the upstream resource
+		void releaseOverflow(); // return every overflow block to the upstream resource
+
+		std::pmr::memory_resource* upstream; // a handle for the resource backing the arena
+		std::byte* block = nullptr; // a handle for the arena memory
+		size_t capacity = 0; // size of the arena memory
+		size_t used = 0; // bump offset into the arena memory
+		size_t highWaterMark = 0; // peak of getUsed() over all frames
+		OverflowBlock* overflowBlocks = nullptr; // intrusive list of spilled allocations
+		size_t overflowBytes = 0; // bytes in spilled allocations since the last reset
+		size_t overflowCount = 0; // spilled allocations since startup
+	};
+
+	// per frame in flight, per thread scratch arenas for data that only lives until the frame slot is reused
+	class frameArena {
+	public:
+		static constexpr size_t DEFAULT_CAPACITY = 256 * 1024; // initial arena size for each thread and frame
+		static constexpr int MAX_THREADS = 64; // threads that can request an arena
+
+		frameArena(size_t capacityPerThread = DEFAULT_CAPACITY); // constructor
+		~frameArena(); // destructor
+
+		// not copyable or movable
+		frameArena(const frameArena&) = delete;
+		frameArena& operator = (const frameArena&) = delete;
+
+		void beginFrame(int frameIndex); // reset the arenas of the frame slot that is being reused; worker threads must be idle
+		linearArena& threadArena(); // the calling thread's arena for the current frame
+		std::pmr::memory_resource* getResource() { return &threadArena(); } // for std::pmr containers
+
+		size_t getHighWaterMark() const; // largest per-thread high water mark
+		void report(std::ostream& out) const; // print arena usage for every thread
+
+	private:
+		static int threadSlot(); // stable index of the calling thread
+
+		size_t capacityPerThread; // initial size of each arena
+		int currentFrameIndex = 0; // frame slot in use
+		std::array<std::array<std::unique_ptr<linearArena>, MAX_THREADS>, swapchain::MAX_FRAMES_IN_FLIGHT> arenas = {}; // lazily created per frame and thread
+	};
+}
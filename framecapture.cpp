@@ -0,0 +1,227 @@
+#include "framecapture.hpp"
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace engine {
+	// start of every capture file
+	struct CaptureHeader {
+		uint32_t magic = frameCapture::MAGIC;
+		uint32_t version = frameCapture::VERSION;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t frameCount = 0; // written when the capture completes, 0 means the application stopped mid-capture
+		uint32_t vertexSize = sizeof(model::Vertex); // guards against replaying with a different vertex layout
+		uint32_t uboSize = sizeof(GlobalUbo);
+		uint32_t pad = 0;
+	};
+
+	struct ChunkHeader {
+		uint32_t type = 0;
+		uint32_t size = 0; // payload bytes following the header
+	};
+
+	struct MeshChunk {
+		uint32_t index = 0;
+		uint32_t vertexCount = 0;
+		uint32_t indexCount = 0;
+	};
+
+	frameCapture::frameCapture(device& deviceInstance, const std::string& filepath, VkExtent2D extent, uint32_t frameCount) : deviceInstance{ deviceInstance }, filepath{ filepath }, file{ filepath, std::ios::binary }, frameCount{ frameCount } {
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open capture file: " + filepath);
+		}
+
+		CaptureHeader header = {};
+		header.width = extent.width;
+		header.height = extent.height;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	}
+
+	frameCapture::~frameCapture() {
+		close();
+	}
+
+	void frameCapture::beginFrame(const GlobalUbo& ubo) {
+		writeChunk(Chunk::FRAME_BEGIN, &ubo, sizeof(ubo));
+	}
+
+	void frameCapture::endFrame() {
+		writeChunk(Chunk::FRAME_END, nullptr, 0);
+		framesRecorded++;
+		if (isFinished()) {
+			close();
+			std::cout << "captured " << framesRecorded << " frame(s) and " << meshIndices.size() << " mesh(es) to " << filepath << std::endl;
+		}
+	}
+
+	void frameCapture::bindSystem(CaptureSystem system) {
+		CaptureCommand command{ CaptureCommand::Type::BIND_SYSTEM, { static_cast<uint32_t>(system) } };
+		writeChunk(Chunk::COMMAND, &command, sizeof(command));
+	}
+
+	void frameCapture::pushConstants(VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* data) {
+		CaptureCommand command{ CaptureCommand::Type::PUSH_CONSTANTS, { stageFlags, offset, size } };
+		writeChunk(Chunk::COMMAND, &command, sizeof(command), data, size); // the bytes follow the command inside the chunk
+	}
+
+	void frameCapture::bindModel(model& modelInstance) {
+		CaptureCommand command{ CaptureCommand::Type::BIND_MODEL, { meshIndex(modelInstance) } };
+		writeChunk(Chunk::COMMAND, &command, sizeof(command));
+	}
+
+	void frameCapture::drawModel(model& modelInstance) {
+		CaptureCommand command{ CaptureCommand::Type::DRAW_MODEL, { meshIndex(modelInstance) } };
+		writeChunk(Chunk::COMMAND, &command, sizeof(command));
+	}
+
+	void frameCapture::drawSubmesh(model& modelInstance, const model::Submesh& submesh) {
+		CaptureCommand command{ CaptureCommand::Type::DRAW_SUBMESH, { meshIndex(modelInstance), submesh.firstIndex, submesh.indexCount } };
+		writeChunk(Chunk::COMMAND, &command, sizeof(command));
+	}
+
+	void frameCapture::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+		CaptureCommand command{ CaptureCommand::Type::DRAW, { vertexCount, instanceCount, firstVertex, firstInstance } };
+		writeChunk(Chunk::COMMAND, &command, sizeof(command));
+	}
+
+	uint32_t frameCapture::meshIndex(model& modelInstance) {
+		auto found = meshIndices.find(&modelInstance);
+		if (found != meshIndices.end()) return found->second;
+
+		// first use of this model, store its geometry ahead of the command that refers to it
+		model::Builder geometry = modelInstance.readBack();
+		MeshChunk mesh = {};
+		mesh.index = static_cast<uint32_t>(meshIndices.size());
+		mesh.vertexCount = static_cast<uint32_t>(geometry.vertices.size());
+		mesh.indexCount = static_cast<uint32_t>(geometry.indices.size());
+
+		uint32_t vertexBytes = mesh.vertexCount * sizeof(model::Vertex);
+		uint32_t indexBytes = mesh.indexCount * sizeof(uint32_t);
+		ChunkHeader header{ static_cast<uint32_t>(Chunk::MESH), static_cast<uint32_t>(sizeof(mesh)) + vertexBytes + indexBytes };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(&mesh), sizeof(mesh));
+		file.write(reinterpret_cast<const char*>(geometry.vertices.data()), vertexBytes);
+		file.write(reinterpret_cast<const char*>(geometry.indices.data()), indexBytes);
+
+		meshIndices.emplace(&modelInstance, mesh.index);
+		return mesh.index;
+	}
+
+	void frameCapture::writeChunk(Chunk chunk, const void* data, uint32_t size, const void* extraData, uint32_t extraSize) {
+		ChunkHeader header{ static_cast<uint32_t>(chunk), size + extraSize };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		if (size > 0) file.write(reinterpret_cast<const char*>(data), size);
+		if (extraSize > 0) file.write(reinterpret_cast<const char*>(extraData), extraSize);
+	}
+
+	void frameCapture::close() {
+		if (!file.is_open()) return;
+
+		// patch the frame count into the header now that it's known
+		file.seekp(offsetof(CaptureHeader, frameCount));
+		file.write(reinterpret_cast<const char*>(&framesRecorded), sizeof(framesRecorded));
+		file.close();
+		if (file.fail()) {
+			std::cerr << "failed to write capture file: " << filepath << std::endl;
+		}
+	}
+
+	// *************** Loading *********************
+
+	CaptureFile frameCapture::load(const std::string& filepath) {
+		std::ifstream file{ filepath, std::ios::binary };
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open capture file: " + filepath);
+		}
+
+		CaptureHeader header = {};
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != MAGIC) {
+			throw std::runtime_error("failed to load capture " + filepath + ": not a capture file!");
+		}
+		if (header.version != VERSION || header.vertexSize != sizeof(model::Vertex) || header.uboSize != sizeof(GlobalUbo)) {
+			throw std::runtime_error("failed to load capture " + filepath + ": recorded by an incompatible build!");
+		}
+
+		CaptureFile captureInstance = {};
+		captureInstance.extent = { header.width, header.height };
+		captureInstance.frames.reserve(header.frameCount);
+
+		CapturedFrame* frame = nullptr;
+		ChunkHeader chunk = {};
+		std::vector<uint8_t> payload = {};
+		while (file.read(reinterpret_cast<char*>(&chunk), sizeof(chunk))) {
+			payload.resize(chunk.size);
+			if (chunk.size > 0 && !file.read(reinterpret_cast<char*>(payload.data()), chunk.size)) {
+				throw std::runtime_error("failed to load capture " + filepath + ": truncated chunk!");
+			}
+
+			switch (static_cast<Chunk>(chunk.type)) {
+			case Chunk::MESH: {
+				if (chunk.size < sizeof(MeshChunk)) {
+					throw std::runtime_error("failed to load capture " + filepath + ": malformed mesh!");
+				}
+				MeshChunk mesh = {};
+				std::memcpy(&mesh, payload.data(), sizeof(mesh));
+				size_t vertexBytes = static_cast<size_t>(mesh.vertexCount) * sizeof(model::Vertex);
+				size_t indexBytes = static_cast<size_t>(mesh.indexCount) * sizeof(uint32_t);
+				if (mesh.index != captureInstance.meshes.size() || sizeof(mesh) + vertexBytes + indexBytes != chunk.size) {
+					throw std::runtime_error("failed to load capture " + filepath + ": malformed mesh!");
+				}
+
+				model::Builder builderInstance = {};
+				builderInstance.vertices.resize(mesh.vertexCount);
+				builderInstance.indices.resize(mesh.indexCount);
+				std::memcpy(builderInstance.vertices.data(), payload.data() + sizeof(mesh), vertexBytes);
+				std::memcpy(builderInstance.indices.data(), payload.data() + sizeof(mesh) + vertexBytes, indexBytes);
+				captureInstance.meshes.push_back(std::move(builderInstance));
+				break;
+			}
+			case Chunk::FRAME_BEGIN:
+				if (chunk.size != sizeof(GlobalUbo)) {
+					throw std::runtime_error("failed to load capture " + filepath + ": malformed frame!");
+				}
+				captureInstance.frames.emplace_back();
+				frame = &captureInstance.frames.back();
+				std::memcpy(&frame->ubo, payload.data(), sizeof(GlobalUbo));
+				break;
+			case Chunk::COMMAND: {
+				if (frame == nullptr || chunk.size < sizeof(CaptureCommand)) {
+					throw std::runtime_error("failed to load capture " + filepath + ": command outside a frame!");
+				}
+				CaptureCommand command = {};
+				std::memcpy(&command, payload.data(), sizeof(command));
+				if (static_cast<uint32_t>(command.type) > static_cast<uint32_t>(CaptureCommand::Type::DRAW_SUBMESH)) {
+					throw std::runtime_error("failed to load capture " + filepath + ": unknown command type " + std::to_string(static_cast<uint32_t>(command.type)) + "!");
+				}
+				if (command.type == CaptureCommand::Type::PUSH_CONSTANTS && command.args[2] != payload.size() - sizeof(command)) {
+					throw std::runtime_error("failed to load capture " + filepath + ": malformed command!");
+				}
+				if (command.type == CaptureCommand::Type::PUSH_CONSTANTS) {
+					command.args[3] = static_cast<uint32_t>(frame->pushData.size());
+					frame->pushData.insert(frame->pushData.end(), payload.begin() + sizeof(command), payload.end());
+				}
+				else if ((command.type == CaptureCommand::Type::BIND_MODEL || command.type == CaptureCommand::Type::DRAW_MODEL || command.type == CaptureCommand::Type::DRAW_SUBMESH) && command.args[0] >= captureInstance.meshes.size()) {
+					throw std::runtime_error("failed to load capture " + filepath + ": command refers to a missing mesh!");
+				}
+				else if (command.type == CaptureCommand::Type::DRAW_SUBMESH && static_cast<uint64_t>(command.args[1]) + command.args[2] > captureInstance.meshes[command.args[0]].indices.size()) {
+					throw std::runtime_error("failed to load capture " + filepath + ": submesh outside its mesh!");
+				}
+				frame->commands.push_back(command);
+				break;
+			}
+			case Chunk::FRAME_END:
+				frame = nullptr;
+				break;
+			default:
+				throw std::runtime_error("failed to load capture " + filepath + ": unknown chunk type " + std::to_string(chunk.type) + "!");
+			}
+		}
+
+		// a frame cut off by the application closing can't be replayed faithfully
+		if (frame != nullptr) {
+			captureInstance.frames.pop_back();
+		}
+		return captureInstance;
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "device.hpp"
+#include "frameinfo.hpp"
+#include "model.hpp"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+	// render systems a capture can bind; each one is a pipeline plus the global descriptor set
+	enum class CaptureSystem : uint32_t {
+		ENTITIES = 0, // rendersystem
+		POINT_LIGHTS = 1, // pointlightsystem
+	};
+
+	// one recorded command; the meaning of the arguments depends on the type
+	struct CaptureCommand {
+		enum class Type : uint32_t {
+			BIND_SYSTEM, // args[0]: CaptureSystem
+			PUSH_CONSTANTS, // args[0]: stage flags, args[1]: offset, args[2]: size, args[3]: offset into CapturedFrame::pushData once loaded
+			BIND_MODEL, // args[0]: mesh index
+			DRAW_MODEL, // args[0]: mesh index
+			DRAW, // args: vertex count, instance count, first vertex, first instance
+			DRAW_SUBMESH, // args[0]: mesh index, args[1]: first index, args[2]: index count
+		};
+
+		Type type = Type::DRAW;
+		uint32_t args[4] = {};
+	};
+
+	struct CapturedFrame {
+		GlobalUbo ubo = {};
+		std::vector<CaptureCommand> commands = {};
+		std::vector<uint8_t> pushData = {}; // push constant bytes of every PUSH_CONSTANTS command
+	};
+
+	// everything needed to replay a capture without the application: the geometry and each frame's command stream
+	struct CaptureFile {
+		VkExtent2D extent = {};
+		std::vector<model::Builder> meshes = {}; // indexed by the mesh index of the commands
+		std::vector<CapturedFrame> frames = {};
+	};
+
+	// records what the render systems submit for a number of frames into a binary file that tools/capturereplay.cpp plays back
+	// the file is a header followed by tagged chunks; geometry is read back from the GPU the first time a model is bound,
+	// so the capture is self-contained. The layout is native-endian and only meant to be replayed on the same architecture
+	class frameCapture {
+	public:
+		static constexpr uint32_t MAGIC = 0x50414345; // "ECAP"
+		static constexpr uint32_t VERSION = 2; // 2 added DRAW_SUBMESH
+
+		frameCapture(device& deviceInstance, const std::string& filepath, VkExtent2D extent, uint32_t frameCount); // constructor, opens the file
+		~frameCapture(); // destructor, completes the file if the capture ended early
+
+		// not copyable or movable
+		frameCapture(const frameCapture&) = delete;
+		frameCapture& operator = (const frameCapture&) = delete;
+
+		void beginFrame(const GlobalUbo& ubo); // start recording a frame with its uniform data
+		void endFrame(); // finish the frame, closes the file after the last one
+		bool isFinished() const { return framesRecorded >= frameCount; }
+
+		// called by the render systems next to the matching vkCmd* calls
+		void bindSystem(CaptureSystem system);
+		void pushConstants(VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* data);
+		void bindModel(model& modelInstance);
+		void drawModel(model& modelInstance);
+		void drawSubmesh(model& modelInstance, const model::Submesh& submesh);
+		void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+
+		static CaptureFile load(const std::string& filepath); // read a capture back, throws on malformed files
+
+	private:
+		enum class Chunk : uint32_t { MESH = 1, FRAME_BEGIN, COMMAND, FRAME_END };
+
+		uint32_t meshIndex(model& modelInstance); // index of a model, writing its geometry on first use
+		void writeChunk(Chunk chunk, const void* data, uint32_t size, const void* extraData = nullptr, uint32_t extraSize = 0); // chunk header and payload
+		void close(); // write the final frame count and close the file
+
+		device& deviceInstance;
+		std::string filepath;
+		std::ofstream file;
+		uint32_t frameCount; // frames to record
+		uint32_t framesRecorded = 0;
+		std::unordered_map<const model*, uint32_t> meshIndices = {};
+	};
+}
@@ -1,9 +1,23 @@
 #pragma once
 #include "camera.hpp"
 #include "entity.hpp"
+#include "framearena.hpp"
 #include <vulkan/vulkan.h>
 
 namespace engine {
+	class frameCapture;
+	class descriptorAllocator;
+	class staticBatcher;
+
+	// struct to create a global uniform buffer
+	struct GlobalUbo {
+		glm::mat4 projection{ 1.f };
+		glm::mat4 view{ 1.f };
+		glm::vec4 ambientLightColor{ 1.f, 1.f, 1.f, .02f }; // r, g, b, intensity
+		glm::vec3 lightPosition{ -1.f };
+		alignas(16) glm::vec4 lightColor{ 1.f }; // r, g, b, intensity
+	};
+
 	// struct for wrapping all frame-relevant data into a single object
 	struct FrameInfo {
 		int frameIndex;
@@ -12,5 +26,10 @@ namespace engine {
 		camera& cameraInstance;
 		VkDescriptorSet globalDescriptorSet;
 		entity::Map& gameEntities;
+		frameArena& frameAllocator; // scratch memory that lives until this frame slot is reused
+		frameCapture* captureInstance = nullptr; // set while the frame is being captured, render systems mirror their commands into it
+		descriptorAllocator* descriptorAllocatorInstance = nullptr; // for allocateFrame(frameIndex, ...), sets that live until this frame slot is reused
+		const staticBatcher* staticBatches = nullptr; // static entities merged into world space chunks, drawn in their place; null draws every entity on its own
+		VkPipelineLayout globalSetBoundLayout = VK_NULL_HANDLE; // layout the global set was last bound with in this command buffer
 	};
 }
\ No newline at end of file
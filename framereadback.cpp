@@ -0,0 +1,299 @@
+#include "framereadback.hpp"
+#include "swapchain.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace engine {
+	frameReadback::frameReadback(device& deviceInstance, uint32_t ringSize, uint32_t workerCount) : deviceInstance{ deviceInstance }, slots(ringSize) {
+		assert(ringSize > swapchain::MAX_FRAMES_IN_FLIGHT && "the ring needs a free buffer beyond those waiting on frames in flight");
+		for (uint32_t i = 0; i < std::max(workerCount, 1u); i++) {
+			workers.emplace_back(&frameReadback::workerLoop, this);
+		}
+	}
+
+	frameReadback::~frameReadback() {
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+		}
+		workAvailable.notify_all();
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	void frameReadback::record(VkCommandBuffer commandBuffer, int frameIndex, VkImage image, VkFormat format, VkExtent2D extent, VkImageLayout layout, std::string filepath) {
+		bool bgra = format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+		if (!bgra && format != VK_FORMAT_R8G8B8A8_UNORM && format != VK_FORMAT_R8G8B8A8_SRGB) {
+			throw std::runtime_error("failed to read back image: unsupported format!");
+		}
+
+		// claim a free buffer, waiting for a worker only when the whole ring is queued for encoding
+		size_t slotIndex = 0;
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+			auto findFree = [this, &slotIndex]() {
+				for (size_t i = 0; i < slots.size(); i++) {
+					size_t candidate = (nextSlot + i) % slots.size();
+					if (slots[candidate].state == SlotState::FREE) {
+						slotIndex = candidate;
+						return true;
+					}
+				}
+				return false;
+			};
+
+			if (!findFree()) {
+				bool encoding = std::any_of(slots.begin(), slots.end(), [](const Slot& slot) { return slot.state == SlotState::ENCODING; });
+				if (!encoding) {
+					throw std::runtime_error("failed to read back image: every buffer is waiting on the GPU, is collect() being called?");
+				}
+				ringStalls++;
+				slotFreed.wait(lock, findFree);
+			}
+			nextSlot = (slotIndex + 1) % slots.size();
+		}
+
+		// the slot is ours until collect() queues it, so its fields can be set without the lock
+		Slot& slot = slots[slotIndex];
+		VkDeviceSize imageSize = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+		if (slot.stagingBuffer == nullptr || slot.stagingBuffer->getBufferSize() != imageSize) {
+			slot.stagingBuffer = nullptr;
+			try {
+				// cached memory makes the CPU reads in the encoder much faster, not every device offers it
+				slot.stagingBuffer = std::make_unique<buffer>(deviceInstance, imageSize, 1, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+			}
+			catch (const std::runtime_error&) {
+				slot.stagingBuffer = std::make_unique<buffer>(deviceInstance, imageSize, 1, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			}
+			slot.stagingBuffer->map();
+		}
+		slot.frameIndex = frameIndex;
+		slot.extent = extent;
+		slot.bgra = bgra;
+		slot.filepath = std::move(filepath);
+
+		// wait for rendering to finish and move the image to a layout it can be copied from
+		VkImageMemoryBarrier imageBarrier = {};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		imageBarrier.oldLayout = layout;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = image;
+		imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+		VkBufferImageCopy region = {};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = { extent.width, extent.height, 1 };
+		vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.stagingBuffer->getBuffer(), 1, &region);
+
+		// make the copy visible to the host once the fence signals
+		VkBufferMemoryBarrier bufferBarrier = {};
+		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarrier.buffer = slot.stagingBuffer->getBuffer();
+		bufferBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+		// return the image to the layout the caller expects, e.g. for presentation
+		if (layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+			imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			imageBarrier.dstAccessMask = 0;
+			imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			imageBarrier.newLayout = layout;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		slot.state = SlotState::RECORDED;
+	}
+
+	void frameReadback::collect(int frameIndex) {
+		bool queued = false;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			for (size_t i = 0; i < slots.size(); i++) {
+				if (slots[i].state == SlotState::RECORDED && slots[i].frameIndex == frameIndex) {
+					slots[i].state = SlotState::ENCODING;
+					queue.push_back(i);
+					queued = true;
+				}
+			}
+		}
+		if (queued) workAvailable.notify_all();
+	}
+
+	void frameReadback::flush() {
+		std::unique_lock<std::mutex> lock{ mutex };
+		for (size_t i = 0; i < slots.size(); i++) {
+			if (slots[i].state == SlotState::RECORDED) {
+				slots[i].state = SlotState::ENCODING;
+				queue.push_back(i);
+			}
+		}
+		workAvailable.notify_all();
+		slotFreed.wait(lock, [this]() { return std::all_of(slots.begin(), slots.end(), [](const Slot& slot) { return slot.state == SlotState::FREE; }); });
+	}
+
+	void frameReadback::workerLoop() {
+		while (true) {
+			size_t slotIndex = 0;
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				workAvailable.wait(lock, [this]() { return stopping || !queue.empty(); });
+				if (queue.empty()) return; // only when stopping, queued images are finished first
+				slotIndex = queue.front();
+				queue.pop_front();
+			}
+
+			// encode straight from the mapped buffer; nothing else touches an ENCODING slot
+			Slot& slot = slots[slotIndex];
+			auto start = std::chrono::steady_clock::now();
+			bool written = true;
+			try {
+				slot.stagingBuffer->invalidate();
+				writeImage(slot.filepath, slot.extent.width, slot.extent.height, static_cast<const uint8_t*>(slot.stagingBuffer->getMappedMemory()), slot.bgra);
+			}
+			catch (const std::exception& e) {
+				std::cerr << e.what() << std::endl;
+				written = false;
+			}
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				slot.state = SlotState::FREE;
+				if (written) imagesWritten++;
+				encodeMilliseconds += milliseconds;
+			}
+			slotFreed.notify_all();
+		}
+	}
+
+	void frameReadback::report(std::ostream& out) const {
+		std::lock_guard<std::mutex> lock{ mutex };
+		out << "readback: " << imagesWritten << " images written, " << (imagesWritten > 0 ? encodeMilliseconds / static_cast<double>(imagesWritten) : 0.0)
+			<< " ms encode each on " << workers.size() << " worker(s), ring of " << slots.size() << " full " << ringStalls << " time(s)" << std::endl;
+	}
+
+	// *************** Image encoding *********************
+
+	static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size) {
+		static const std::array<uint32_t, 256> table = []() {
+			std::array<uint32_t, 256> entries = {};
+			for (uint32_t n = 0; n < 256; n++) {
+				uint32_t c = n;
+				for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+				entries[n] = c;
+			}
+			return entries;
+		}();
+
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	static void appendBigEndian(std::vector<uint8_t>& bytes, uint32_t value) {
+		bytes.insert(bytes.end(), { static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value) });
+	}
+
+	static void writePngChunk(std::ofstream& file, const char type[4], const std::vector<uint8_t>& data) {
+		std::vector<uint8_t> header = {};
+		appendBigEndian(header, static_cast<uint32_t>(data.size()));
+		header.insert(header.end(), type, type + 4);
+		uint32_t crc = crc32(crc32(0, header.data() + 4, 4), data.data(), data.size());
+
+		std::vector<uint8_t> footer = {};
+		appendBigEndian(footer, crc);
+		file.write(reinterpret_cast<const char*>(header.data()), header.size());
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		file.write(reinterpret_cast<const char*>(footer.data()), footer.size());
+	}
+
+	void frameReadback::writeImage(const std::string& filepath, uint32_t width, uint32_t height, const uint8_t* rgba, bool bgra) {
+		std::ofstream file{ filepath, std::ios::binary };
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open image file: " + filepath);
+		}
+
+		// RGB rows, alpha dropped; PNG rows start with a filter byte
+		std::string extension = filepath.size() >= 4 ? filepath.substr(filepath.size() - 4) : std::string{};
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		bool png = extension == ".png";
+		size_t rowSize = (png ? 1 : 0) + 3 * static_cast<size_t>(width);
+		std::vector<uint8_t> pixels(rowSize * height);
+		for (uint32_t y = 0; y < height; y++) {
+			uint8_t* row = pixels.data() + y * rowSize;
+			if (png) *row++ = 0; // no filter
+			const uint8_t* source = rgba + 4 * static_cast<size_t>(y) * width;
+			for (uint32_t x = 0; x < width; x++, source += 4) {
+				*row++ = source[bgra ? 2 : 0];
+				*row++ = source[1];
+				*row++ = source[bgra ? 0 : 2];
+			}
+		}
+
+		if (!png) {
+			file << "P6\n" << width << " " << height << "\n255\n";
+			file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+		}
+		else {
+			// stored (uncompressed) deflate blocks keep encoding at memcpy speed, which matters when recording every frame
+			static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+			file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+			std::vector<uint8_t> header = {};
+			appendBigEndian(header, width);
+			appendBigEndian(header, height);
+			header.insert(header.end(), { 8, 2, 0, 0, 0 }); // 8-bit RGB, deflate, adaptive filtering, no interlace
+			writePngChunk(file, "IHDR", header);
+
+			constexpr size_t MAX_BLOCK = 65535;
+			std::vector<uint8_t> stream = {};
+			stream.reserve(pixels.size() + 5 * (pixels.size() / MAX_BLOCK + 1) + 6);
+			stream.insert(stream.end(), { 0x78, 0x01 }); // zlib header, 32K window, no preset dictionary
+			uint32_t adlerA = 1;
+			uint32_t adlerB = 0;
+			for (size_t offset = 0; offset < pixels.size() || offset == 0; offset += MAX_BLOCK) {
+				uint16_t length = static_cast<uint16_t>(std::min(MAX_BLOCK, pixels.size() - offset));
+				uint16_t complement = static_cast<uint16_t>(~length);
+				bool last = offset + length >= pixels.size();
+				stream.insert(stream.end(), { static_cast<uint8_t>(last ? 1 : 0), static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(complement), static_cast<uint8_t>(complement >> 8) });
+				stream.insert(stream.end(), pixels.begin() + offset, pixels.begin() + offset + length);
+
+				// adler-32, reduced every 5552 bytes, the most that can't overflow 32 bits
+				for (size_t start = offset; start < offset + length; start += 5552) {
+					size_t end = std::min<size_t>(start + 5552, offset + length);
+					for (size_t i = start; i < end; i++) {
+						adlerA += pixels[i];
+						adlerB += adlerA;
+					}
+					adlerA %= 65521;
+					adlerB %= 65521;
+				}
+				if (last) break;
+			}
+			appendBigEndian(stream, (adlerB << 16) | adlerA);
+			writePngChunk(file, "IDAT", stream);
+			writePngChunk(file, "IEND", {});
+		}
+
+		if (!file) {
+			throw std::runtime_error("failed to write image file: " + filepath);
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "device.hpp"
+#include "buffer.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace engine {
+	// copies rendered images into a ring of host visible buffers from inside the frame's own command buffer and encodes them
+	// to PPM or PNG files on worker threads, so taking screenshots, or every frame for video, never stalls the queue
+	//
+	// per frame: record() after the render pass, then collect() for the same frame slot once its fence has signaled
+	// (right after the next beginFrame that returns that slot) to hand the finished copy to a worker
+	class frameReadback {
+	public:
+		frameReadback(device& deviceInstance, uint32_t ringSize = 4, uint32_t workerCount = 2); // constructor, starts the workers
+		~frameReadback(); // destructor, finishes queued files and stops the workers
+
+		// not copyable or movable
+		frameReadback(const frameReadback&) = delete;
+		frameReadback& operator = (const frameReadback&) = delete;
+
+		// record a copy of image, currently in layout, to be written to filepath; the image is returned to the same layout
+		// waits for a worker to free a buffer only when every buffer in the ring is still queued for encoding
+		void record(VkCommandBuffer commandBuffer, int frameIndex, VkImage image, VkFormat format, VkExtent2D extent, VkImageLayout layout, std::string filepath);
+		void collect(int frameIndex); // frameIndex's fence has signaled, queue its copies for encoding
+		void flush(); // after vkDeviceWaitIdle, encode everything still recorded and wait for the workers
+
+		void report(std::ostream& out) const; // images written, encode times and how often the ring was full
+
+		// write 8-bit RGBA pixels as a binary PPM or an uncompressed PNG, chosen by the file extension
+		static void writeImage(const std::string& filepath, uint32_t width, uint32_t height, const uint8_t* rgba, bool bgra = false);
+
+	private:
+		enum class SlotState { FREE, RECORDED, ENCODING };
+
+		struct Slot {
+			std::unique_ptr<buffer> stagingBuffer = {};
+			SlotState state = SlotState::FREE;
+			int frameIndex = -1; // frame slot whose fence covers the copy
+			VkExtent2D extent = {};
+			bool bgra = false; // swap red and blue while encoding
+			std::string filepath = {};
+		};
+
+		void workerLoop();
+
+		device& deviceInstance;
+		std::vector<Slot> slots;
+		size_t nextSlot = 0; // round robin start for finding a free slot
+
+		mutable std::mutex mutex; // guards slot states, the queue and the statistics
+		std::condition_variable workAvailable; // signaled when a slot is queued or on shutdown
+		std::condition_variable slotFreed; // signaled when a worker finishes a slot
+		std::deque<size_t> queue = {}; // slots waiting for a worker
+		std::vector<std::thread> workers = {};
+		bool stopping = false;
+
+		uint64_t imagesWritten = 0;
+		uint64_t ringStalls = 0; // records that had to wait for a free buffer
+		double encodeMilliseconds = 0.0; // summed over all workers
+	};
+}
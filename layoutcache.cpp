@@ -0,0 +1,106 @@
+#include "layoutcache.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace engine {
+	layoutCache::layoutCache(VkDevice deviceHandle) : deviceHandle{ deviceHandle } {}
+
+	layoutCache::~layoutCache() {
+		// pipeline layouts first, they were created from the set layouts
+		for (const auto& kv : pipelineLayouts) {
+			vkDestroyPipelineLayout(deviceHandle, kv.second, nullptr);
+		}
+		for (const auto& kv : setLayouts) {
+			vkDestroyDescriptorSetLayout(deviceHandle, kv.second, nullptr);
+		}
+	}
+
+	size_t layoutCache::KeyHash::operator()(const Key& key) const {
+		size_t seed = key.size();
+		for (uint64_t word : key) {
+			hashCombine(seed, word);
+		}
+		return seed;
+	}
+
+	VkDescriptorSetLayout layoutCache::getDescriptorSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags) {
+		// sort so that the same bindings added in a different order, or read out of an unordered map, share a layout
+		std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+
+		Key key = { flags };
+		for (const auto& binding : bindings) {
+			key.push_back(binding.binding);
+			key.push_back(static_cast<uint64_t>(binding.descriptorType));
+			key.push_back(binding.descriptorCount);
+			key.push_back(binding.stageFlags);
+			key.push_back(binding.pImmutableSamplers != nullptr);
+			if (binding.pImmutableSamplers != nullptr) {
+				for (uint32_t i = 0; i < binding.descriptorCount; i++) {
+					key.push_back(reinterpret_cast<uint64_t>(binding.pImmutableSamplers[i]));
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto found = setLayouts.find(key);
+		if (found != setLayouts.end()) {
+			setLayoutHits++;
+			return found->second;
+		}
+
+		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo = {};
+		descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptorSetLayoutInfo.flags = flags;
+		descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		descriptorSetLayoutInfo.pBindings = bindings.data();
+
+		VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+		if (vkCreateDescriptorSetLayout(deviceHandle, &descriptorSetLayoutInfo, nullptr, &setLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create descriptor set layout!");
+		}
+		setLayouts.emplace(std::move(key), setLayout);
+		return setLayout;
+	}
+
+	VkPipelineLayout layoutCache::getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges) {
+		// set layouts are cached handles already, so comparing handles compares definitions; set order is significant
+		Key key = {};
+		key.push_back(setLayouts.size());
+		for (VkDescriptorSetLayout setLayout : setLayouts) {
+			key.push_back(reinterpret_cast<uint64_t>(setLayout));
+		}
+		for (const auto& range : pushConstantRanges) {
+			key.push_back(range.stageFlags);
+			key.push_back(range.offset);
+			key.push_back(range.size);
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto found = pipelineLayouts.find(key);
+		if (found != pipelineLayouts.end()) {
+			pipelineLayoutHits++;
+			return found->second;
+		}
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+		pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		if (vkCreatePipelineLayout(deviceHandle, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+		pipelineLayouts.emplace(std::move(key), pipelineLayout);
+		return pipelineLayout;
+	}
+
+	void layoutCache::report(std::ostream& out) const {
+		std::lock_guard<std::mutex> lock{ mutex };
+		out << "layout cache: " << setLayouts.size() << " descriptor set layout(s) created, " << setLayoutHits << " hit(s); "
+			<< pipelineLayouts.size() << " pipeline layout(s) created, " << pipelineLayoutHits << " hit(s)" << std::endl;
+	}
+}
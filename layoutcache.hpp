@@ -0,0 +1,41 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+	// shares descriptor set layouts and pipeline layouts between everything that asks for the same definition
+	// identical definitions get the same handle, so pipelines built on one cached pipeline layout are compatible for every set
+	// and a descriptor set bound for one stays bound for the next; the cache owns the handles and destroys them with the device
+	class layoutCache {
+	public:
+		layoutCache(VkDevice deviceHandle); // constructor
+		~layoutCache(); // destructor, destroys every cached layout
+
+		// not copyable or movable
+		layoutCache(const layoutCache&) = delete;
+		layoutCache& operator = (const layoutCache&) = delete;
+
+		VkDescriptorSetLayout getDescriptorSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags = 0); // binding order doesn't matter
+		VkPipelineLayout getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges);
+
+		void report(std::ostream& out) const; // layouts created and requests served from the cache
+
+	private:
+		// a layout definition flattened into words, compared and hashed as a whole
+		using Key = std::vector<uint64_t>;
+		struct KeyHash {
+			size_t operator()(const Key& key) const;
+		};
+
+		VkDevice deviceHandle;
+		mutable std::mutex mutex; // systems build their pipelines on worker threads
+		std::unordered_map<Key, VkDescriptorSetLayout, KeyHash> setLayouts = {};
+		std::unordered_map<Key, VkPipelineLayout, KeyHash> pipelineLayouts = {};
+		uint64_t setLayoutHits = 0;
+		uint64_t pipelineLayoutHits = 0;
+	};
+}
@@ -1,13 +1,50 @@
 #include "application.hpp"
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
 
-int main() {
-	engine::application app = {};
+int main(int argc, char** argv) {
+	engine::RunSettings runSettings = {};
+	std::optional<engine::SceneSettings> sceneSettings = {}; // any --scene-* option or --seed swaps the model files for a generated scene
+	auto flight = [&runSettings]() -> engine::flythrough::Settings& { return runSettings.flythroughSettings ? *runSettings.flythroughSettings : runSettings.flythroughSettings.emplace(); };
+	auto scene = [&sceneSettings]() -> engine::SceneSettings& { return sceneSettings ? *sceneSettings : sceneSettings.emplace(); };
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) runSettings.frameLimit = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--scene-entities") == 0 && i + 1 < argc) scene().entityCount = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--scene-meshes") == 0 && i + 1 < argc) scene().meshCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (std::strcmp(argv[i], "--scene-lights") == 0 && i + 1 < argc) scene().lightCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (std::strcmp(argv[i], "--scene-depth") == 0 && i + 1 < argc) scene().hierarchyDepth = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (std::strcmp(argv[i], "--scene-static") == 0) scene().staticEntities = true;
+		else if (std::strcmp(argv[i], "--flythrough") == 0 && i + 1 < argc) flight().pathFile = argv[++i];
+		else if (std::strcmp(argv[i], "--fixed-dt") == 0 && i + 1 < argc) flight().fixedFrameTime = std::strtof(argv[++i], nullptr);
+		else if (std::strcmp(argv[i], "--flythrough-warmup") == 0 && i + 1 < argc) flight().warmupFrames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (std::strcmp(argv[i], "--flythrough-json") == 0 && i + 1 < argc) flight().jsonPath = argv[++i];
+		else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) runSettings.capturePath = argv[++i];
+		else if (std::strcmp(argv[i], "--capture-start") == 0 && i + 1 < argc) runSettings.captureStart = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--capture-frames") == 0 && i + 1 < argc) runSettings.captureFrames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (std::strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc) runSettings.screenshotPath = argv[++i];
+		else if (std::strcmp(argv[i], "--screenshot-frame") == 0 && i + 1 < argc) runSettings.screenshotFrame = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) runSettings.recordPrefix = argv[++i];
+		else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) scene().seed = std::strtoull(argv[++i], nullptr, 10);
+	}
+
+	if (const char* reason = sceneSettings ? engine::sceneGenerator::validate(*sceneSettings) : nullptr) {
+		std::cerr << "usage: " << reason << " (--scene-entities, --scene-meshes)" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// the flythrough options only tune a flythrough, on their own there's no path to fly
+	if (runSettings.flythroughSettings && runSettings.flythroughSettings->pathFile.empty()) {
+		std::cerr << "usage: --fixed-dt, --flythrough-warmup and --flythrough-json need --flythrough <path>" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	engine::application app{ sceneSettings };
 
 	try {
-		app.run();
+		app.run(runSettings);
 	}
 
 	catch (const std::exception& e) {
@@ -0,0 +1,343 @@
+#include "meshcodec.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_MESH_CODEC_SSE
+#include <emmintrin.h>
+#endif
+
+namespace engine {
+	// bits per byte of a group for each 2-bit header code
+	static constexpr uint32_t GROUP_WIDTHS[4] = { 0, 2, 4, 8 };
+
+	static uint8_t zigzag(uint8_t delta) {
+		return static_cast<uint8_t>((delta << 1) ^ (static_cast<int8_t>(delta) >> 7));
+	}
+
+	static uint32_t zigzag(uint32_t delta) {
+		return (delta << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(delta) >> 31);
+	}
+
+	static uint32_t groupCount(uint32_t elements) {
+		return (elements + meshCodec::GROUP_SIZE - 1) / meshCodec::GROUP_SIZE;
+	}
+
+	static uint32_t groupWidth(const uint8_t* header, uint32_t group) {
+		return GROUP_WIDTHS[(header[group / 4] >> (group % 4 * 2)) & 3];
+	}
+
+	// appends one plane of groupCount * GROUP_SIZE bytes, headers first
+	static void encodePlane(const uint8_t* values, uint32_t groups, std::vector<char>& out) {
+		size_t header = out.size();
+		out.resize(out.size() + (groups + 3) / 4, 0);
+		for (uint32_t group = 0; group < groups; group++) {
+			const uint8_t* bytes = values + group * meshCodec::GROUP_SIZE;
+			uint8_t largest = *std::max_element(bytes, bytes + meshCodec::GROUP_SIZE);
+			uint32_t code = largest == 0 ? 0 : largest < 4 ? 1 : largest < 16 ? 2 : 3;
+			out[header + group / 4] = static_cast<char>(out[header + group / 4] | (code << (group % 4 * 2)));
+
+			// value i sits at bit (i * width) % 8 of byte i * width / 8
+			uint32_t width = GROUP_WIDTHS[code];
+			if (width == 0) continue;
+			char packed[meshCodec::GROUP_SIZE] = {};
+			for (uint32_t i = 0; i < meshCodec::GROUP_SIZE; i++) {
+				packed[i * width / 8] = static_cast<char>(packed[i * width / 8] | (bytes[i] << (i * width % 8)));
+			}
+			out.insert(out.end(), packed, packed + meshCodec::GROUP_SIZE * width / 8);
+		}
+	}
+
+	// checks that a whole plane is there and returns its headers; data is left at the first group
+	static const uint8_t* readPlaneHeader(const uint8_t*& data, const uint8_t* end, uint32_t groups) {
+		size_t headerBytes = (groups + 3) / 4;
+		if (static_cast<size_t>(end - data) < headerBytes) {
+			throw std::runtime_error("failed to decode mesh: truncated stream!");
+		}
+		const uint8_t* header = data;
+		size_t groupBytes = 0;
+		for (uint32_t group = 0; group < groups; group++) {
+			groupBytes += meshCodec::GROUP_SIZE * groupWidth(header, group) / 8;
+		}
+		data += headerBytes;
+		if (static_cast<size_t>(end - data) < groupBytes) {
+			throw std::runtime_error("failed to decode mesh: truncated stream!");
+		}
+		return header;
+	}
+
+#ifdef ENGINE_MESH_CODEC_SSE
+	// the 16 bytes of a group, unpacked; data is left at the next group
+	static __m128i unpackGroup(const uint8_t*& data, uint32_t width) {
+		switch (width) {
+		case 0:
+			return _mm_setzero_si128();
+		case 2: {
+			int32_t packed;
+			std::memcpy(&packed, data, sizeof(packed));
+			data += 4;
+			__m128i x = _mm_cvtsi32_si128(packed);
+			__m128i mask = _mm_set1_epi8(3);
+			__m128i low = _mm_unpacklo_epi8(_mm_and_si128(x, mask), _mm_and_si128(_mm_srli_epi16(x, 2), mask));
+			__m128i high = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(x, 4), mask), _mm_and_si128(_mm_srli_epi16(x, 6), mask));
+			return _mm_unpacklo_epi16(low, high);
+		}
+		case 4: {
+			__m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+			data += 8;
+			__m128i mask = _mm_set1_epi8(15);
+			return _mm_unpacklo_epi8(_mm_and_si128(x, mask), _mm_and_si128(_mm_srli_epi16(x, 4), mask));
+		}
+		default: {
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+			data += 16;
+			return x;
+		}
+		}
+	}
+
+	static __m128i unzigzag8(__m128i value) {
+		__m128i shifted = _mm_and_si128(_mm_srli_epi16(value, 1), _mm_set1_epi8(0x7f));
+		return _mm_xor_si128(shifted, _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(value, _mm_set1_epi8(1))));
+	}
+
+	static __m128i unzigzag32(__m128i value) {
+		return _mm_xor_si128(_mm_srli_epi32(value, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(value, _mm_set1_epi32(1))));
+	}
+
+	// byte 15 in every lane
+	static __m128i broadcastLast8(__m128i value) {
+		__m128i high = _mm_shufflehi_epi16(_mm_unpackhi_epi8(value, value), _MM_SHUFFLE(3, 3, 3, 3));
+		return _mm_shuffle_epi32(high, _MM_SHUFFLE(3, 3, 3, 3));
+	}
+
+	// 16 bytes from each of four consecutive planes as 16 little-endian words, four per lane
+	static void interleave4(const uint8_t* const planes[4], uint32_t offset, __m128i lanes[4]) {
+		__m128i p0 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[0] + offset));
+		__m128i p1 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[1] + offset));
+		__m128i p2 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[2] + offset));
+		__m128i p3 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[3] + offset));
+		__m128i low01 = _mm_unpacklo_epi8(p0, p1);
+		__m128i low23 = _mm_unpacklo_epi8(p2, p3);
+		__m128i high01 = _mm_unpackhi_epi8(p0, p1);
+		__m128i high23 = _mm_unpackhi_epi8(p2, p3);
+		lanes[0] = _mm_unpacklo_epi16(low01, low23);
+		lanes[1] = _mm_unpackhi_epi16(low01, low23);
+		lanes[2] = _mm_unpacklo_epi16(high01, high23);
+		lanes[3] = _mm_unpackhi_epi16(high01, high23);
+	}
+#else
+	static uint8_t unzigzag(uint8_t value) {
+		return static_cast<uint8_t>((value >> 1) ^ (0u - (value & 1u)));
+	}
+
+	static uint32_t unzigzag(uint32_t value) {
+		return (value >> 1) ^ (0u - (value & 1u));
+	}
+
+	static void unpackGroup(const uint8_t*& data, uint32_t width, uint8_t* out) {
+		if (width == 0) {
+			std::memset(out, 0, meshCodec::GROUP_SIZE);
+			return;
+		}
+		uint32_t mask = (1u << width) - 1;
+		for (uint32_t i = 0; i < meshCodec::GROUP_SIZE; i++) {
+			out[i] = static_cast<uint8_t>((data[i * width / 8] >> (i * width % 8)) & mask);
+		}
+		data += meshCodec::GROUP_SIZE * width / 8;
+	}
+#endif
+
+	std::vector<char> meshCodec::encodeVertices(const void* vertices, uint32_t count, uint32_t stride) {
+		assert(stride > 0 && stride <= MAX_STRIDE && "vertex stride not supported by the mesh codec");
+		const uint8_t* source = static_cast<const uint8_t*>(vertices);
+
+		std::vector<char> out = {};
+		uint8_t previous[MAX_STRIDE] = {}; // the last vertex, the first one is stored as its difference from zero
+		uint8_t plane[BLOCK_SIZE];
+		for (uint32_t first = 0; first < count; first += BLOCK_SIZE) {
+			uint32_t elements = std::min(BLOCK_SIZE, count - first);
+			uint32_t groups = groupCount(elements);
+			for (uint32_t k = 0; k < stride; k++) {
+				std::memset(plane, 0, sizeof(plane)); // padding past the last vertex is a zero difference
+				for (uint32_t i = 0; i < elements; i++) {
+					uint8_t value = source[static_cast<size_t>(first + i) * stride + k];
+					plane[i] = zigzag(static_cast<uint8_t>(value - previous[k]));
+					previous[k] = value;
+				}
+				encodePlane(plane, groups, out);
+			}
+		}
+		return out;
+	}
+
+	void meshCodec::decodeVertices(void* destination, uint32_t count, uint32_t stride, const char* data, size_t size) {
+		assert(stride > 0 && stride <= MAX_STRIDE && "vertex stride not supported by the mesh codec");
+		uint8_t* out = static_cast<uint8_t*>(destination);
+		const uint8_t* in = reinterpret_cast<const uint8_t*>(data);
+		const uint8_t* end = in + size;
+
+		uint8_t previous[MAX_STRIDE] = {};
+		alignas(16) uint8_t planes[MAX_STRIDE][BLOCK_SIZE];
+		for (uint32_t first = 0; first < count; first += BLOCK_SIZE) {
+			uint32_t elements = std::min(BLOCK_SIZE, count - first);
+			uint32_t groups = groupCount(elements);
+			for (uint32_t k = 0; k < stride; k++) {
+				const uint8_t* header = readPlaneHeader(in, end, groups);
+				uint8_t* plane = planes[k];
+#ifdef ENGINE_MESH_CODEC_SSE
+				// a prefix sum over the 16 differences in four shifted adds, then the byte of the vertex before the group
+				__m128i carry = _mm_set1_epi8(static_cast<char>(previous[k]));
+				for (uint32_t group = 0; group < groups; group++) {
+					__m128i value = unzigzag8(unpackGroup(in, groupWidth(header, group)));
+					value = _mm_add_epi8(value, _mm_slli_si128(value, 1));
+					value = _mm_add_epi8(value, _mm_slli_si128(value, 2));
+					value = _mm_add_epi8(value, _mm_slli_si128(value, 4));
+					value = _mm_add_epi8(value, _mm_slli_si128(value, 8));
+					value = _mm_add_epi8(value, carry);
+					_mm_store_si128(reinterpret_cast<__m128i*>(plane + group * GROUP_SIZE), value);
+					carry = broadcastLast8(value);
+				}
+#else
+				uint8_t value = previous[k];
+				for (uint32_t group = 0; group < groups; group++) {
+					uint8_t* bytes = plane + group * GROUP_SIZE;
+					unpackGroup(in, groupWidth(header, group), bytes);
+					for (uint32_t i = 0; i < GROUP_SIZE; i++) {
+						value = static_cast<uint8_t>(value + unzigzag(bytes[i]));
+						bytes[i] = value;
+					}
+				}
+#endif
+				previous[k] = plane[elements - 1];
+			}
+
+			// planes back to interleaved vertices, written front to back so write-combined staging memory stays fast
+			uint8_t* block = out + static_cast<size_t>(first) * stride;
+			uint32_t i = 0;
+#ifdef ENGINE_MESH_CODEC_SSE
+			// four planes at a time become one 32-bit store per vertex instead of four byte stores
+			if (stride % 4 == 0) {
+				for (; i + GROUP_SIZE <= elements; i += GROUP_SIZE) {
+					for (uint32_t k = 0; k < stride; k += 4) {
+						const uint8_t* const source[4] = { planes[k], planes[k + 1], planes[k + 2], planes[k + 3] };
+						alignas(16) uint32_t words[GROUP_SIZE];
+						__m128i lanes[4];
+						interleave4(source, i, lanes);
+						for (uint32_t lane = 0; lane < 4; lane++) {
+							_mm_store_si128(reinterpret_cast<__m128i*>(words + lane * 4), lanes[lane]);
+						}
+						for (uint32_t j = 0; j < GROUP_SIZE; j++) {
+							std::memcpy(block + static_cast<size_t>(i + j) * stride + k, &words[j], sizeof(uint32_t));
+						}
+					}
+				}
+			}
+#endif
+			for (; i < elements; i++) {
+				for (uint32_t k = 0; k < stride; k++) {
+					block[static_cast<size_t>(i) * stride + k] = planes[k][i];
+				}
+			}
+		}
+	}
+
+	std::vector<char> meshCodec::encodeIndices(const uint32_t* indices, uint32_t count) {
+		std::vector<char> out = {};
+		uint32_t previous = 0;
+		uint8_t planes[4][BLOCK_SIZE];
+		for (uint32_t first = 0; first < count; first += BLOCK_SIZE) {
+			uint32_t elements = std::min(BLOCK_SIZE, count - first);
+			std::memset(planes, 0, sizeof(planes));
+			for (uint32_t i = 0; i < elements; i++) {
+				uint32_t value = zigzag(indices[first + i] - previous);
+				previous = indices[first + i];
+				for (uint32_t k = 0; k < 4; k++) {
+					planes[k][i] = static_cast<uint8_t>(value >> (k * 8));
+				}
+			}
+			for (uint32_t k = 0; k < 4; k++) {
+				encodePlane(planes[k], groupCount(elements), out);
+			}
+		}
+		return out;
+	}
+
+	void meshCodec::decodeIndices(uint32_t* destination, uint32_t count, const char* data, size_t size) {
+		const uint8_t* in = reinterpret_cast<const uint8_t*>(data);
+		const uint8_t* end = in + size;
+
+		uint32_t previous = 0;
+		alignas(16) uint8_t planes[4][BLOCK_SIZE];
+		for (uint32_t first = 0; first < count; first += BLOCK_SIZE) {
+			uint32_t elements = std::min(BLOCK_SIZE, count - first);
+			uint32_t groups = groupCount(elements);
+			for (uint32_t k = 0; k < 4; k++) {
+				const uint8_t* header = readPlaneHeader(in, end, groups);
+				for (uint32_t group = 0; group < groups; group++) {
+#ifdef ENGINE_MESH_CODEC_SSE
+					_mm_store_si128(reinterpret_cast<__m128i*>(planes[k] + group * GROUP_SIZE), unpackGroup(in, groupWidth(header, group)));
+#else
+					unpackGroup(in, groupWidth(header, group), planes[k] + group * GROUP_SIZE);
+#endif
+				}
+			}
+
+			uint32_t* block = destination + first;
+#ifdef ENGINE_MESH_CODEC_SSE
+			// the four planes of 16 indices interleaved back into 32-bit lanes, then undone four at a time
+			const uint8_t* const source[4] = { planes[0], planes[1], planes[2], planes[3] };
+			__m128i carry = _mm_set1_epi32(static_cast<int32_t>(previous));
+			for (uint32_t group = 0; group < groups; group++) {
+				uint32_t offset = group * GROUP_SIZE;
+				__m128i lanes[4];
+				interleave4(source, offset, lanes);
+
+				alignas(16) uint32_t values[GROUP_SIZE];
+				for (uint32_t lane = 0; lane < 4; lane++) {
+					__m128i value = unzigzag32(lanes[lane]);
+					value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+					value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+					value = _mm_add_epi32(value, carry);
+					carry = _mm_shuffle_epi32(value, _MM_SHUFFLE(3, 3, 3, 3));
+					_mm_store_si128(reinterpret_cast<__m128i*>(values + lane * 4), value);
+				}
+				uint32_t valid = std::min(GROUP_SIZE, elements - offset);
+				if (valid == GROUP_SIZE) {
+					for (uint32_t lane = 0; lane < 4; lane++) {
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(block + offset + lane * 4), _mm_load_si128(reinterpret_cast<const __m128i*>(values + lane * 4)));
+					}
+				}
+				else {
+					std::memcpy(block + offset, values, valid * sizeof(uint32_t));
+				}
+			}
+			previous = block[elements - 1];
+#else
+			for (uint32_t i = 0; i < elements; i++) {
+				uint32_t value = static_cast<uint32_t>(planes[0][i]) | static_cast<uint32_t>(planes[1][i]) << 8 | static_cast<uint32_t>(planes[2][i]) << 16 | static_cast<uint32_t>(planes[3][i]) << 24;
+				previous += unzigzag(value);
+				block[i] = previous;
+			}
+#endif
+		}
+	}
+
+	void meshCodec::quantize(float* values, size_t count, uint32_t mantissaBits) {
+		if (mantissaBits >= 23) return;
+		uint32_t dropped = 23 - mantissaBits;
+		uint32_t mask = ~((1u << dropped) - 1);
+		for (size_t i = 0; i < count; i++) {
+			uint32_t bits;
+			std::memcpy(&bits, &values[i], sizeof(bits));
+			if ((bits & 0x7f800000u) == 0x7f800000u) continue; // infinities and NaNs are kept as they are
+
+			// round to nearest, unless that would carry into infinity
+			uint32_t rounded = (bits + (1u << (dropped - 1))) & mask;
+			if ((rounded & 0x7f800000u) == 0x7f800000u) rounded = bits & mask;
+			std::memcpy(&values[i], &rounded, sizeof(rounded));
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+	// lossless compression of cooked vertex and index streams, decoded straight into upload memory
+	// both streams are cut into blocks of BLOCK_SIZE elements and every block into byte planes, byte k of each element.
+	// A plane is stored in groups of GROUP_SIZE bytes, each packed at 0, 2, 4 or 8 bits per byte as its 2-bit header
+	// says. Filters ahead of that keep the bytes small: a vertex byte is stored as its difference from the same byte of
+	// the previous vertex, an index as its difference from the previous index, both zigzag encoded so that small steps
+	// back stay small too. Decoding handles a group of 16 bytes at a time, with SSE2 where it's available
+	class meshCodec {
+	public:
+		static constexpr uint32_t BLOCK_SIZE = 256; // elements per block, one block's planes are decoded on the stack
+		static constexpr uint32_t GROUP_SIZE = 16; // bytes sharing a bit width, one SSE register
+		static constexpr uint32_t MAX_STRIDE = 64; // largest vertex the codec accepts
+
+		static std::vector<char> encodeVertices(const void* vertices, uint32_t count, uint32_t stride);
+		static void decodeVertices(void* destination, uint32_t count, uint32_t stride, const char* data, size_t size); // throws if the data is truncated
+		static std::vector<char> encodeIndices(const uint32_t* indices, uint32_t count);
+		static void decodeIndices(uint32_t* destination, uint32_t count, const char* data, size_t size); // throws if the data is truncated
+
+		// rounds each float to mantissaBits bits of mantissa before encoding; the low byte planes become zero and cost
+		// nothing, at the price of precision. 23 keeps every value exact
+		static void quantize(float* values, size_t count, uint32_t mantissaBits);
+	};
+}
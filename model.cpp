@@ -1,27 +1,80 @@
 #include "model.hpp"
 #include "utils.hpp"
+#include "startupprofiler.hpp"
+#include "meshcodec.hpp"
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <istream>
+#include <streambuf>
 #include <unordered_map>
+#include <utility>
 
-namespace std {
-	template <>
-	struct hash<engine::model::Vertex> {
-		size_t operator()(engine::model::Vertex const& vertexInstance) const {
-			size_t seed = 0;
-			engine::hashCombine(seed, vertexInstance.position, vertexInstance.color, vertexInstance.normal, vertexInstance.uv);
-			return seed;
+namespace engine {
+	// a fill that copies count elements from data
+	template <typename T>
+	static auto copyFrom(const T* data, uint32_t count) {
+		return [data, count](void* memory) { std::memcpy(memory, data, sizeof(T) * count); };
+	}
+
+	// the union of the submeshes' bounds
+	static model::Bounds boundsOf(const std::vector<model::Submesh>& submeshes) {
+		if (submeshes.empty()) return {};
+		model::Bounds result = submeshes[0].bounds;
+		for (const auto& submesh : submeshes) {
+			result.min = glm::min(result.min, submesh.bounds.min);
+			result.max = glm::max(result.max, submesh.bounds.max);
 		}
-	};
-}
+		return result;
+	}
 
-namespace engine {
-	model::model(device& deviceInstance, const model::Builder& builderInstance) : deviceInstance{ deviceInstance } {
-		createVertexBuffers(builderInstance.vertices);
-		createIndexBuffer(builderInstance.indices);
+	model::model(device& deviceInstance, const model::Builder& builderInstance, Residency residency) : deviceInstance{ deviceInstance }, residency{ residency } {
+		startupProfiler::phase phase{ "model upload" };
+		uint32_t vertexTotal = static_cast<uint32_t>(builderInstance.vertices.size());
+		uint32_t indexTotal = static_cast<uint32_t>(builderInstance.indices.size());
+		createVertexBuffers(vertexTotal, copyFrom(builderInstance.vertices.data(), vertexTotal));
+		createIndexBuffer(indexTotal, copyFrom(builderInstance.indices.data(), indexTotal));
+		submeshes = builderInstance.getSubmeshes();
+		bounds = boundsOf(submeshes);
+	}
+
+	model::model(device& deviceInstance, const MeshView& mesh, Residency residency) : deviceInstance{ deviceInstance }, residency{ residency } {
+		startupProfiler::phase phase{ "model upload" };
+		createVertexBuffers(mesh.vertexCount, copyFrom(mesh.vertices, mesh.vertexCount));
+		createIndexBuffer(mesh.indexCount, copyFrom(mesh.indices, mesh.indexCount));
+		submeshes.assign(mesh.submeshes, mesh.submeshes + mesh.submeshCount);
+		bounds = boundsOf(submeshes);
+	}
+
+	model::model(device& deviceInstance, const EncodedMeshView& mesh, Residency residency) : deviceInstance{ deviceInstance }, residency{ residency } {
+		startupProfiler::phase phase{ "model upload" };
+		// decoded into the staging or host visible mapping itself, the full size geometry never exists anywhere else on the host
+		createVertexBuffers(mesh.vertexCount, [&mesh](void* memory) { meshCodec::decodeVertices(memory, mesh.vertexCount, sizeof(Vertex), mesh.vertexData, mesh.vertexBytes); });
+		createIndexBuffer(mesh.indexCount, [&mesh](void* memory) { meshCodec::decodeIndices(static_cast<uint32_t*>(memory), mesh.indexCount, mesh.indexData, mesh.indexBytes); });
+		submeshes.assign(mesh.submeshes, mesh.submeshes + mesh.submeshCount);
+		bounds = boundsOf(submeshes);
+	}
+
+	model::model(device& deviceInstance, const ProgressiveMeshView& mesh, Residency residency) : deviceInstance{ deviceInstance }, residency{ residency }, progressiveLevels{ mesh.levels } {
+		startupProfiler::phase phase{ "model upload" };
+		assert(!progressiveLevels.empty() && "progressive mesh without levels");
+
+		// buffers for the full mesh up front, so refining only ever appends to them
+		uint32_t vertexTotal = 0;
+		uint32_t indexTotal = 0;
+		for (const auto& level : progressiveLevels) {
+			vertexTotal += level.vertexCount;
+			indexTotal += level.indexCount;
+		}
+		vertexBuffer = createBuffer(sizeof(Vertex), vertexTotal, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+		indexBuffer = createBuffer(sizeof(uint32_t), indexTotal, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+		hasIndexBuffer = true;
+		vertexCount = 0;
+		indexCount = 0;
+		bounds = mesh.bounds;
+		refine();
 	}
 
 	model::~model() {}
@@ -32,43 +85,66 @@ namespace engine {
 		return std::make_unique<model>(deviceInstance, builderInstance);
 	}
 
-	void model::createVertexBuffers(const std::vector<Vertex>& vertices) {
+	void model::createVertexBuffers(uint32_t count, const Fill& fill) {
 		// check that we have at least one triangle (3 vertices)
-		vertexCount = static_cast<uint32_t>(vertices.size());
+		vertexCount = count;
 		assert(vertexCount >= 3 && "Vertex count must be at least 3");
 
-		// create a staging buffer
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-		uint32_t vertexSize = sizeof(vertices[0]);
-		buffer stagingBuffer{ deviceInstance, vertexSize, vertexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
-		
-		// map the staging buffer memory
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)vertices.data());
-
-		// create a vertex buffer
-		vertexBuffer = std::make_unique<buffer>(deviceInstance, vertexSize, vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		deviceInstance.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+		vertexBuffer = createBuffer(sizeof(Vertex), vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+		uploadRange(*vertexBuffer, 0, sizeof(Vertex) * static_cast<VkDeviceSize>(vertexCount), fill);
 	}
 
-	void model::createIndexBuffer(const std::vector<uint32_t>& indices) {
+	void model::createIndexBuffer(uint32_t count, const Fill& fill) {
 		// check that we are using an index buffer for rendering
-		indexCount = static_cast<uint32_t>(indices.size());
+		indexCount = count;
 		hasIndexBuffer = indexCount > 0;
 		if (!hasIndexBuffer) return;
 
+		indexBuffer = createBuffer(sizeof(uint32_t), indexCount, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+		uploadRange(*indexBuffer, 0, sizeof(uint32_t) * static_cast<VkDeviceSize>(indexCount), fill);
+	}
+
+	std::unique_ptr<buffer> model::createBuffer(uint32_t elementSize, uint32_t elementCount, VkBufferUsageFlags usage) {
+		if (residency == Residency::HOST_VISIBLE) {
+			return std::make_unique<buffer>(deviceInstance, elementSize, elementCount, usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		}
+		return std::make_unique<buffer>(deviceInstance, elementSize, elementCount, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	}
+
+	void model::uploadRange(buffer& target, VkDeviceSize offset, VkDeviceSize size, const Fill& fill) {
+		if (size == 0) return;
+
+		// host visible buffers are written in place, nothing is submitted so nothing has to be waited for
+		if (residency == Residency::HOST_VISIBLE) {
+			target.map(size, offset);
+			fill(target.getMappedMemory());
+			target.unmap();
+			return;
+		}
+
 		// create a staging buffer
-		VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-		uint32_t indexSize = sizeof(indices[0]);
-		buffer stagingBuffer{ deviceInstance, indexSize, indexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+		buffer stagingBuffer{ deviceInstance, size, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
 
 		// map the staging buffer memory
 		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)indices.data());
+		fill(stagingBuffer.getMappedMemory());
+
+		// copy into the device local buffer
+		deviceInstance.copyBuffer(stagingBuffer.getBuffer(), target.getBuffer(), size, 0, offset);
+	}
+
+	bool model::refine() {
+		if (isRefined()) return false;
+		const ProgressiveMeshView::Level& level = progressiveLevels[nextLevel++];
 
-		// create a vertex buffer
-		indexBuffer = std::make_unique<buffer>(deviceInstance, indexSize, indexCount, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		deviceInstance.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+		// both ranges are past anything a frame in flight reads, and the draw only switches over once they're in place
+		uploadRange(*vertexBuffer, sizeof(Vertex) * static_cast<VkDeviceSize>(vertexCount), sizeof(Vertex) * static_cast<VkDeviceSize>(level.vertexCount), copyFrom(level.vertices, level.vertexCount));
+		uploadRange(*indexBuffer, sizeof(uint32_t) * static_cast<VkDeviceSize>(uploadedIndices), sizeof(uint32_t) * static_cast<VkDeviceSize>(level.indexCount), copyFrom(level.indices, level.indexCount));
+		vertexCount += level.vertexCount;
+		firstIndex = uploadedIndices;
+		indexCount = level.indexCount;
+		uploadedIndices += level.indexCount;
+		return !isRefined();
 	}
 
 	void model::bind(VkCommandBuffer commandBuffer) {
@@ -83,13 +159,39 @@ namespace engine {
 
 	void model::draw(VkCommandBuffer commandBuffer) {
 		if (hasIndexBuffer) {
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+			vkCmdDrawIndexed(commandBuffer, indexCount, 1, firstIndex, 0, 0);
 		}
 		else {
 			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
 		}
 	}
 
+	void model::drawSubmesh(VkCommandBuffer commandBuffer, const Submesh& submesh) {
+		assert(hasIndexBuffer && "submeshes are index ranges");
+		vkCmdDrawIndexed(commandBuffer, submesh.indexCount, 1, submesh.firstIndex, 0, 0);
+	}
+
+	model::Builder model::readBack() {
+		Builder builderInstance = {};
+
+		// copy each device local buffer into a host visible one, the reverse of the upload; a progressive model gives back the level it draws
+		builderInstance.vertices.resize(vertexCount);
+		buffer vertexStaging{ deviceInstance, sizeof(Vertex), vertexCount, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+		deviceInstance.copyBuffer(vertexBuffer->getBuffer(), vertexStaging.getBuffer(), sizeof(Vertex) * vertexCount);
+		vertexStaging.map();
+		std::memcpy(builderInstance.vertices.data(), vertexStaging.getMappedMemory(), sizeof(Vertex) * vertexCount);
+
+		if (hasIndexBuffer) {
+			builderInstance.indices.resize(indexCount);
+			buffer indexStaging{ deviceInstance, sizeof(uint32_t), indexCount, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+			deviceInstance.copyBuffer(indexBuffer->getBuffer(), indexStaging.getBuffer(), sizeof(uint32_t) * indexCount, sizeof(uint32_t) * static_cast<VkDeviceSize>(firstIndex), 0);
+			indexStaging.map();
+			std::memcpy(builderInstance.indices.data(), indexStaging.getMappedMemory(), sizeof(uint32_t) * indexCount);
+		}
+		builderInstance.submeshes = submeshes;
+		return builderInstance;
+	}
+
 	std::vector<VkVertexInputBindingDescription> model::Vertex::getBindingDescriptions() {
 		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
 		bindingDescriptions[0].binding = 0;
@@ -109,6 +211,90 @@ namespace engine {
 		return attributeDescriptions;
 	}
 
+	// deduplicate the vertices of every shape into one indexed mesh, with the indices grouped into a submesh per shape and material
+	static void buildMesh(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes, std::vector<model::Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<model::Submesh>& submeshes) {
+		// start from a fresh builder state
+		vertices.clear();
+		indices.clear();
+		submeshes.clear();
+
+		std::unordered_map<model::Vertex, uint32_t> uniqueVertices = {};
+		auto addIndex = [&](const tinyobj::index_t& index) {
+			model::Vertex vertexInstance = {};
+
+			if (index.vertex_index >= 0) {
+				vertexInstance.position = { 
+					attrib.vertices[3 * index.vertex_index + 0],
+					attrib.vertices[3 * index.vertex_index + 1],
+					attrib.vertices[3 * index.vertex_index + 2],
+				};
+
+				vertexInstance.color = {
+					attrib.colors[3 * index.vertex_index + 0],
+					attrib.colors[3 * index.vertex_index + 1],
+					attrib.colors[3 * index.vertex_index + 2],
+				};
+			}
+
+			if (index.normal_index >= 0) {
+				vertexInstance.normal = {
+					attrib.normals[3 * index.normal_index + 0],
+					attrib.normals[3 * index.normal_index + 1],
+					attrib.normals[3 * index.normal_index + 2],
+				};
+			}
+
+			if (index.texcoord_index >= 0) {
+				vertexInstance.uv = {
+					attrib.texcoords[2 * index.texcoord_index + 0],
+					attrib.texcoords[2 * index.texcoord_index + 1],
+				};
+			}
+
+			if (uniqueVertices.count(vertexInstance) == 0) {
+				uniqueVertices[vertexInstance] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(vertexInstance);
+			}
+			indices.push_back(uniqueVertices[vertexInstance]);
+		};
+
+		for (const auto& shape : shapes) {
+			// the shape's faces bucketed by material in one pass, buckets in the order their material is first used; faces
+			// without an entry have none
+			std::unordered_map<int, size_t> bucketOf = {};
+			std::vector<std::pair<int, std::vector<size_t>>> buckets = {}; // a material and its faces
+			std::vector<size_t> faceOffsets(shape.mesh.num_face_vertices.size()); // where each face's corners start in the shape's indices
+			size_t offset = 0;
+			for (size_t face = 0; face < shape.mesh.num_face_vertices.size(); face++) {
+				int material = face < shape.mesh.material_ids.size() ? shape.mesh.material_ids[face] : -1;
+				auto found = bucketOf.emplace(material, buckets.size());
+				if (found.second) buckets.emplace_back(material, std::vector<size_t>{});
+				buckets[found.first->second].second.push_back(face);
+				faceOffsets[face] = offset;
+				offset += shape.mesh.num_face_vertices[face];
+			}
+
+			// one contiguous range per material; the vertices are still shared across the whole mesh
+			for (const auto& bucket : buckets) {
+				model::Submesh submesh = {};
+				submesh.firstIndex = static_cast<uint32_t>(indices.size());
+				submesh.material = bucket.first;
+				for (size_t face : bucket.second) {
+					for (size_t corner = 0; corner < shape.mesh.num_face_vertices[face]; corner++) addIndex(shape.mesh.indices[faceOffsets[face] + corner]);
+				}
+				submesh.indexCount = static_cast<uint32_t>(indices.size()) - submesh.firstIndex;
+				if (submesh.indexCount == 0) continue;
+
+				submesh.bounds.min = submesh.bounds.max = vertices[indices[submesh.firstIndex]].position;
+				for (uint32_t i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i++) {
+					submesh.bounds.min = glm::min(submesh.bounds.min, vertices[indices[i]].position);
+					submesh.bounds.max = glm::max(submesh.bounds.max, vertices[indices[i]].position);
+				}
+				submeshes.push_back(submesh);
+			}
+		}
+	}
+
 	void model::Builder::loadModel(const std::string& filepath) {
 		tinyobj::attrib_t attrib;
 		std::vector<tinyobj::shape_t> shapes;
@@ -118,52 +304,125 @@ namespace engine {
 		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str())) {
 			throw std::runtime_error(warn + err);
 		}
+		buildMesh(attrib, shapes, vertices, indices, submeshes);
+	}
 
-		// start from a fresh builder state
-		vertices.clear();
-		indices.clear();
+	void model::Builder::loadModelFromMemory(const std::vector<char>& data, const std::string& name) {
+		// a read-only stream over the bytes, without copying them into a string first
+		struct memoryBuffer : std::streambuf {
+			memoryBuffer(const std::vector<char>& data) {
+				char* begin = const_cast<char*>(data.data());
+				setg(begin, begin, begin + data.size());
+			}
+		};
+		memoryBuffer bufferInstance{ data };
+		std::istream stream{ &bufferInstance };
 
-		std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
 
-		for (const auto& shape : shapes) {
-			for (const auto& index : shape.mesh.indices) {
-				Vertex vertexInstance = {};
-
-				if (index.vertex_index >= 0) {
-					vertexInstance.position = { 
-						attrib.vertices[3 * index.vertex_index + 0],
-						attrib.vertices[3 * index.vertex_index + 1],
-						attrib.vertices[3 * index.vertex_index + 2],
-					};
-
-					vertexInstance.color = {
-						attrib.colors[3 * index.vertex_index + 0],
-						attrib.colors[3 * index.vertex_index + 1],
-						attrib.colors[3 * index.vertex_index + 2],
-					};
-				}
+		// material libraries are looked up next to the model, so usemtl resolves and the submeshes split by material too
+		size_t separator = name.find_last_of("/\\");
+		tinyobj::MaterialFileReader materialReader{ separator == std::string::npos ? std::string{} : name.substr(0, separator + 1) };
+		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream, &materialReader)) {
+			throw std::runtime_error("failed to parse model " + name + ": " + warn + err);
+		}
+		buildMesh(attrib, shapes, vertices, indices, submeshes);
+	}
 
-				if (index.normal_index >= 0) {
-					vertexInstance.normal = {
-						attrib.normals[3 * index.normal_index + 0],
-						attrib.normals[3 * index.normal_index + 1],
-						attrib.normals[3 * index.normal_index + 2],
-					};
-				}
+	model::Bounds model::Builder::getBounds() const {
+		Bounds result = {};
+		if (vertices.empty()) return result;
+		result.min = result.max = vertices[0].position;
+		for (const auto& vertexInstance : vertices) {
+			result.min = glm::min(result.min, vertexInstance.position);
+			result.max = glm::max(result.max, vertexInstance.position);
+		}
+		return result;
+	}
 
-				if (index.texcoord_index >= 0) {
-					vertexInstance.uv = {
-						attrib.texcoords[2 * index.texcoord_index + 0],
-						attrib.texcoords[2 * index.texcoord_index + 1],
-					};
-				}
+	std::vector<model::Submesh> model::Builder::getSubmeshes() const {
+		if (!submeshes.empty()) return submeshes;
+
+		Submesh whole = {};
+		whole.indexCount = static_cast<uint32_t>(indices.size());
+		whole.bounds = getBounds();
+		return { whole };
+	}
+
+	std::vector<model::ProgressiveLevel> model::Builder::makeProgressive(uint32_t levelCount) {
+		submeshes.clear();
+		const uint32_t fullIndexCount = static_cast<uint32_t>(indices.size());
+		if (levelCount <= 1 || vertices.empty() || fullIndexCount < 3) {
+			return { { static_cast<uint32_t>(vertices.size()), fullIndexCount } };
+		}
+
+		// the grid stops getting finer at 1 << 20 cells a side, ten coarse levels in; more would repeat the last one
+		levelCount = std::min(levelCount, 11u);
 
-				if (uniqueVertices.count(vertexInstance) == 0) {
-					uniqueVertices[vertexInstance] = static_cast<uint32_t>(vertices.size());
-					vertices.push_back(vertexInstance);
+		Bounds bounds = getBounds();
+		glm::vec3 minimum = bounds.min;
+		glm::vec3 extent = glm::max(bounds.max - bounds.min, glm::vec3{ 1e-6f });
+
+		// coarse levels by vertex clustering: every vertex snaps to the first vertex of its grid cell, triangles that
+		// collapse are dropped. The grid gets four times finer per level and the last level is the mesh as it is
+		std::vector<std::vector<uint32_t>> levelIndices = {};
+		for (uint32_t level = 0; level + 1 < levelCount; level++) {
+			const uint32_t resolution = std::min(8u << (2 * level), 1u << 20);
+			std::unordered_map<uint64_t, uint32_t> cells = {};
+			std::vector<uint32_t> representative(vertices.size());
+			for (uint32_t i = 0; i < static_cast<uint32_t>(vertices.size()); i++) {
+				glm::vec3 cell = glm::min((vertices[i].position - minimum) / extent * static_cast<float>(resolution), glm::vec3{ static_cast<float>(resolution - 1) });
+				uint64_t key = static_cast<uint64_t>(cell.x) | static_cast<uint64_t>(cell.y) << 21 | static_cast<uint64_t>(cell.z) << 42;
+				representative[i] = cells.emplace(key, i).first->second;
+			}
+
+			std::vector<uint32_t> coarse = {};
+			for (uint32_t i = 0; i + 2 < fullIndexCount; i += 3) {
+				uint32_t a = representative[indices[i]], b = representative[indices[i + 1]], c = representative[indices[i + 2]];
+				if (a == b || b == c || a == c) continue;
+				coarse.insert(coarse.end(), { a, b, c });
+			}
+			// a level is only worth streaming if it's smaller than both the full mesh and the next level
+			if (coarse.empty() || coarse.size() >= fullIndexCount / 2) break;
+			if (!levelIndices.empty() && coarse.size() <= levelIndices.back().size()) continue;
+			levelIndices.push_back(std::move(coarse));
+		}
+		levelIndices.push_back(indices);
+
+		// vertices in the order levels first use them, so each level only appends to the vertex buffer
+		constexpr uint32_t UNASSIGNED = ~0u;
+		std::vector<uint32_t> remap(vertices.size(), UNASSIGNED);
+		std::vector<Vertex> ordered = {};
+		ordered.reserve(vertices.size());
+		std::vector<ProgressiveLevel> levels = {};
+		for (auto& list : levelIndices) {
+			ProgressiveLevel levelInstance = {};
+			for (uint32_t& index : list) {
+				if (remap[index] == UNASSIGNED) {
+					remap[index] = static_cast<uint32_t>(ordered.size());
+					ordered.push_back(vertices[index]);
+					levelInstance.vertexCount++;
 				}
-				indices.push_back(uniqueVertices[vertexInstance]);
+				index = remap[index];
 			}
+			levelInstance.indexCount = static_cast<uint32_t>(list.size());
+			levels.push_back(levelInstance);
 		}
+		// vertices no triangle uses still come along with the last level
+		for (uint32_t i = 0; i < static_cast<uint32_t>(vertices.size()); i++) {
+			if (remap[i] != UNASSIGNED) continue;
+			ordered.push_back(vertices[i]);
+			levels.back().vertexCount++;
+		}
+
+		vertices = std::move(ordered);
+		indices.clear();
+		for (const auto& list : levelIndices) {
+			indices.insert(indices.end(), list.begin(), list.end());
+		}
+		return levels;
 	}
-}
\ No newline at end of file
+}
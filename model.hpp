@@ -1,9 +1,13 @@
 #pragma once
 #include "device.hpp"
 #include "buffer.hpp"
+#include "utils.hpp"
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+#include <functional>
 #include <vector>
 #include <memory>
 
@@ -23,14 +27,85 @@ namespace engine {
 			}
 		};
 
+		// one level of a progressive mesh: the vertices it adds after the coarser levels' and the length of its own index list
+		struct ProgressiveLevel {
+			uint32_t vertexCount = 0;
+			uint32_t indexCount = 0;
+		};
+
+		// an axis aligned box in model space
+		struct Bounds {
+			glm::vec3 min{ 0.f };
+			glm::vec3 max{ 0.f };
+		};
+
+		// a range of the index buffer that is culled and drawn on its own, one per OBJ shape and material
+		struct Submesh {
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+			int32_t material = -1; // the OBJ's material index, -1 for faces without one; only meaningful within one model
+			Bounds bounds = {}; // of the vertices the range uses
+		};
+
 		// struct for holding vertex and index information until it can be copied into the model's buffer memory
 		struct Builder {
 			std::vector<Vertex> vertices = {};
 			std::vector<uint32_t> indices = {};
+			std::vector<Submesh> submeshes = {}; // the index ranges of the OBJ's shapes and materials, back to back; empty for geometry built by hand
 			void loadModel(const std::string& filepath);
+			void loadModelFromMemory(const std::vector<char>& data, const std::string& name); // an OBJ already read into memory, name is its path, for errors and finding its material library
+
+			// reorders the mesh coarse to fine, in at most levelCount levels of which the last is the mesh itself; the vertices
+			// are sorted by the first level that uses them and the indices become every level's list back to back. The levels
+			// cut across submeshes, so those are dropped and the mesh is drawn whole
+			std::vector<ProgressiveLevel> makeProgressive(uint32_t levelCount);
+
+			Bounds getBounds() const; // of every vertex
+			std::vector<Submesh> getSubmeshes() const; // the submeshes, or a single one spanning the mesh when there are none
+		};
+
+		// geometry owned by someone else, e.g. a cooked mesh in a mapped asset pack, uploaded without an intermediate copy
+		struct MeshView {
+			const Vertex* vertices = nullptr;
+			uint32_t vertexCount = 0;
+			const uint32_t* indices = nullptr;
+			uint32_t indexCount = 0;
+			const Submesh* submeshes = nullptr; // at least one
+			uint32_t submeshCount = 0;
 		};
 
-		model(device& deviceInstance, const model::Builder& builderInstance); // constructor
+		// geometry compressed by meshCodec, decoded straight into the upload memory
+		struct EncodedMeshView {
+			uint32_t vertexCount = 0;
+			uint32_t indexCount = 0;
+			const char* vertexData = nullptr;
+			size_t vertexBytes = 0;
+			const char* indexData = nullptr;
+			size_t indexBytes = 0;
+			const Submesh* submeshes = nullptr; // at least one
+			uint32_t submeshCount = 0;
+		};
+
+		// geometry cooked by Builder::makeProgressive; every level is a complete, coarser version of the mesh, so it can be
+		// drawn as soon as its own vertices and indices are uploaded
+		struct ProgressiveMeshView {
+			struct Level {
+				const Vertex* vertices = nullptr; // the vertices this level adds
+				uint32_t vertexCount = 0;
+				const uint32_t* indices = nullptr; // the level's whole index list, referencing only vertices up to its own
+				uint32_t indexCount = 0;
+			};
+			std::vector<Level> levels = {}; // coarsest first
+			Bounds bounds = {}; // of the full mesh, the coarser levels fit inside it
+		};
+
+		// where the geometry lives; HOST_VISIBLE skips the staging copy and its queue wait, for meshes that are drawn only a few times
+		enum class Residency { DEVICE_LOCAL, HOST_VISIBLE };
+
+		model(device& deviceInstance, const model::Builder& builderInstance, Residency residency = Residency::DEVICE_LOCAL); // constructor
+		model(device& deviceInstance, const MeshView& mesh, Residency residency = Residency::DEVICE_LOCAL); // constructor, reads the geometry in place
+		model(device& deviceInstance, const EncodedMeshView& mesh, Residency residency = Residency::DEVICE_LOCAL); // constructor, throws if the geometry can't be decoded
+		model(device& deviceInstance, const ProgressiveMeshView& mesh, Residency residency = Residency::DEVICE_LOCAL); // constructor, uploads only the coarsest level; the geometry must outlive the refinement
 		~model(); // destructor
 
 		// not copyable or movable
@@ -41,16 +116,47 @@ namespace engine {
 
 		void bind(VkCommandBuffer commandBuffer);
 		void draw(VkCommandBuffer commandBuffer);
+		void drawSubmesh(VkCommandBuffer commandBuffer, const Submesh& submesh); // one index range, for models with an index buffer
+		Builder readBack(); // copy the geometry and its submeshes back from device memory, e.g. for frame captures; waits for the queue to go idle
+		const std::vector<Submesh>& getSubmeshes() const { return submeshes; } // empty for progressive models, which are drawn whole
+		const Bounds& getBounds() const { return bounds; } // of the whole model
+
+		bool refine(); // upload the next level of a progressive model and draw it from then on, returns true while levels remain
+		bool isRefined() const { return nextLevel >= progressiveLevels.size(); } // true once the full mesh is drawn, always for other models
 
 	private:
-		void createVertexBuffers(const std::vector<Vertex>& vertices); // to create the vertex buffers
-		void createIndexBuffer(const std::vector<uint32_t>& indices); // to create the index buffers
+		using Fill = std::function<void(void* memory)>; // writes a buffer's contents into mapped memory
+
+		void createVertexBuffers(uint32_t count, const Fill& fill); // to create the vertex buffers
+		void createIndexBuffer(uint32_t count, const Fill& fill); // to create the index buffers
+		std::unique_ptr<buffer> createBuffer(uint32_t elementSize, uint32_t elementCount, VkBufferUsageFlags usage); // in memory according to the residency
+		void uploadRange(buffer& target, VkDeviceSize offset, VkDeviceSize size, const Fill& fill); // through a staging buffer unless host visible
 		device& deviceInstance; // reference to the device
+		Residency residency; // memory the buffers were created in
 
 		std::unique_ptr<buffer> vertexBuffer; // a handle for the vertex buffer
 		uint32_t vertexCount; // a handle for the count of vertices
 		bool hasIndexBuffer = false; // a flag for using index buffers
 		std::unique_ptr<buffer> indexBuffer; // a handle for the index buffer
 		uint32_t indexCount; // a handle for the count of indices
+		uint32_t firstIndex = 0; // start of the drawn level's indices, non-zero only for progressive models
+		std::vector<Submesh> submeshes = {}; // index ranges drawn on their own
+		Bounds bounds = {}; // the union of the submeshes' bounds
+
+		std::vector<ProgressiveMeshView::Level> progressiveLevels = {}; // empty for models uploaded whole
+		size_t nextLevel = 0; // the level refine() uploads next
+		uint32_t uploadedIndices = 0; // indices of every level uploaded so far
+	};
+}
+
+namespace std {
+	// hash for vertex deduplication, exposed here so tools and benchmarks hash vertices the same way the loader does
+	template <>
+	struct hash<engine::model::Vertex> {
+		size_t operator()(engine::model::Vertex const& vertexInstance) const {
+			size_t seed = 0;
+			engine::hashCombine(seed, vertexInstance.position, vertexInstance.color, vertexInstance.normal, vertexInstance.uv);
+			return seed;
+		}
 	};
-}
\ No newline at end of file
+}
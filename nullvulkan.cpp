@@ -0,0 +1,657 @@
+#include "nullvulkan.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <type_traits>
+
+namespace engine {
+	// counters are relaxed atomics so recording from several threads stays cheap and still adds up
+	struct NullVulkanCounters {
+		std::atomic<uint64_t> commandBuffersRecorded{ 0 };
+		std::atomic<uint64_t> renderPasses{ 0 };
+		std::atomic<uint64_t> draws{ 0 };
+		std::atomic<uint64_t> indexedDraws{ 0 };
+		std::atomic<uint64_t> verticesSubmitted{ 0 };
+		std::atomic<uint64_t> pipelineBinds{ 0 };
+		std::atomic<uint64_t> descriptorSetBinds{ 0 };
+		std::atomic<uint64_t> vertexBufferBinds{ 0 };
+		std::atomic<uint64_t> indexBufferBinds{ 0 };
+		std::atomic<uint64_t> pushConstantBytes{ 0 };
+		std::atomic<uint64_t> descriptorWrites{ 0 };
+		std::atomic<uint64_t> submits{ 0 };
+		std::atomic<uint64_t> presents{ 0 };
+		std::atomic<uint64_t> objectsCreated{ 0 };
+		std::atomic<uint64_t> objectsDestroyed{ 0 };
+		std::atomic<uint64_t> bytesAllocated{ 0 };
+	};
+
+	static NullVulkanCounters counters;
+
+	static void count(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+		counter.fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	NullVulkanStats nullVulkan::getStats() {
+		NullVulkanStats stats = {};
+		stats.commandBuffersRecorded = counters.commandBuffersRecorded.load(std::memory_order_relaxed);
+		stats.renderPasses = counters.renderPasses.load(std::memory_order_relaxed);
+		stats.draws = counters.draws.load(std::memory_order_relaxed);
+		stats.indexedDraws = counters.indexedDraws.load(std::memory_order_relaxed);
+		stats.verticesSubmitted = counters.verticesSubmitted.load(std::memory_order_relaxed);
+		stats.pipelineBinds = counters.pipelineBinds.load(std::memory_order_relaxed);
+		stats.descriptorSetBinds = counters.descriptorSetBinds.load(std::memory_order_relaxed);
+		stats.vertexBufferBinds = counters.vertexBufferBinds.load(std::memory_order_relaxed);
+		stats.indexBufferBinds = counters.indexBufferBinds.load(std::memory_order_relaxed);
+		stats.pushConstantBytes = counters.pushConstantBytes.load(std::memory_order_relaxed);
+		stats.descriptorWrites = counters.descriptorWrites.load(std::memory_order_relaxed);
+		stats.submits = counters.submits.load(std::memory_order_relaxed);
+		stats.presents = counters.presents.load(std::memory_order_relaxed);
+		stats.objectsCreated = counters.objectsCreated.load(std::memory_order_relaxed);
+		stats.objectsDestroyed = counters.objectsDestroyed.load(std::memory_order_relaxed);
+		stats.bytesAllocated = counters.bytesAllocated.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	void nullVulkan::resetStats() {
+		for (auto* counter : { &counters.commandBuffersRecorded, &counters.renderPasses, &counters.draws, &counters.indexedDraws, &counters.verticesSubmitted,
+			&counters.pipelineBinds, &counters.descriptorSetBinds, &counters.vertexBufferBinds, &counters.indexBufferBinds, &counters.pushConstantBytes,
+			&counters.descriptorWrites, &counters.submits, &counters.presents }) {
+			counter->store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void nullVulkan::report(std::ostream& out, uint64_t frameCount) {
+		NullVulkanStats stats = getStats();
+		double frames = frameCount > 0 ? static_cast<double>(frameCount) : 1.0;
+		auto line = [&out, frames](const char* name, uint64_t total) {
+			out << "\t" << std::left << std::setw(26) << name << std::right << std::setw(14) << total
+				<< std::fixed << std::setprecision(1) << std::setw(14) << static_cast<double>(total) / frames << " /frame" << std::endl;
+		};
+
+		out << "null vulkan backend, " << frameCount << " frames:" << std::endl;
+		line("command buffers", stats.commandBuffersRecorded);
+		line("render passes", stats.renderPasses);
+		line("draws", stats.draws);
+		line("indexed draws", stats.indexedDraws);
+		line("vertices submitted", stats.verticesSubmitted);
+		line("pipeline binds", stats.pipelineBinds);
+		line("descriptor set binds", stats.descriptorSetBinds);
+		line("vertex buffer binds", stats.vertexBufferBinds);
+		line("index buffer binds", stats.indexBufferBinds);
+		line("push constant bytes", stats.pushConstantBytes);
+		line("descriptor writes", stats.descriptorWrites);
+		line("submits", stats.submits);
+		line("presents", stats.presents);
+		out << "\tlive objects: " << stats.objectsCreated - stats.objectsDestroyed << ", device memory: " << stats.bytesAllocated << " bytes" << std::endl;
+	}
+}
+
+#ifdef ENGINE_NULL_VULKAN
+namespace {
+	using engine::count;
+	using engine::counters;
+
+	// buffers and images remember their size so memory requirements can be answered
+	struct NullResource {
+		VkDeviceSize size;
+	};
+
+	// memory is real host memory so mapping and writing uniform/vertex data works as usual
+	struct NullMemory {
+		void* data;
+		VkDeviceSize size;
+	};
+
+	struct NullSwapchain {
+		uint32_t imageCount;
+		uint32_t nextImage;
+	};
+
+	std::atomic<uint64_t> nextHandle{ 0x1000 };
+
+	// unique, never dereferenced handle of any type; works for both pointer and 64-bit integer handle definitions
+	template <typename Handle>
+	Handle fakeHandle() {
+		count(counters.objectsCreated);
+		uint64_t value = nextHandle.fetch_add(0x10, std::memory_order_relaxed);
+		if constexpr (std::is_pointer_v<Handle>) {
+			return reinterpret_cast<Handle>(static_cast<uintptr_t>(value));
+		}
+		else {
+			return static_cast<Handle>(value);
+		}
+	}
+
+	// handle that points at a real object owned by the backend
+	template <typename Handle, typename Object>
+	Handle objectHandle(Object* object) {
+		count(counters.objectsCreated);
+		if constexpr (std::is_pointer_v<Handle>) {
+			return reinterpret_cast<Handle>(object);
+		}
+		else {
+			return static_cast<Handle>(reinterpret_cast<uintptr_t>(object));
+		}
+	}
+
+	template <typename Object, typename Handle>
+	Object* handleObject(Handle handle) {
+		if constexpr (std::is_pointer_v<Handle>) {
+			return reinterpret_cast<Object*>(handle);
+		}
+		else {
+			return reinterpret_cast<Object*>(static_cast<uintptr_t>(handle));
+		}
+	}
+
+	template <typename Handle>
+	void releaseHandle(Handle handle) {
+		if (handle != VK_NULL_HANDLE) count(counters.objectsDestroyed);
+	}
+
+	// the usual two-call enumeration idiom over a fixed list
+	template <typename T>
+	VkResult enumerate(const T* items, uint32_t available, uint32_t* count, T* out) {
+		if (out == nullptr) {
+			*count = available;
+			return VK_SUCCESS;
+		}
+		uint32_t written = *count < available ? *count : available;
+		for (uint32_t i = 0; i < written; i++) out[i] = items[i];
+		*count = written;
+		return written < available ? VK_INCOMPLETE : VK_SUCCESS;
+	}
+
+	VkExtensionProperties extensionProperties(const char* name) {
+		VkExtensionProperties properties = {};
+		std::strncpy(properties.extensionName, name, VK_MAX_EXTENSION_NAME_SIZE - 1);
+		properties.specVersion = 1;
+		return properties;
+	}
+
+	VkResult VKAPI_CALL nullCreateDebugUtilsMessengerEXT(VkInstance, const VkDebugUtilsMessengerCreateInfoEXT*, const VkAllocationCallbacks*, VkDebugUtilsMessengerEXT* pMessenger) {
+		*pMessenger = fakeHandle<VkDebugUtilsMessengerEXT>();
+		return VK_SUCCESS;
+	}
+
+	void VKAPI_CALL nullDestroyDebugUtilsMessengerEXT(VkInstance, VkDebugUtilsMessengerEXT messenger, const VkAllocationCallbacks*) {
+		releaseHandle(messenger);
+	}
+
+	// pushed writes count like written descriptors plus a set bind, which is what they replace
+	void VKAPI_CALL nullCmdPushDescriptorSetKHR(VkCommandBuffer, VkPipelineBindPoint, VkPipelineLayout, uint32_t, uint32_t descriptorWriteCount, const VkWriteDescriptorSet*) {
+		count(counters.descriptorWrites, descriptorWriteCount);
+		count(counters.descriptorSetBinds);
+	}
+
+	PFN_vkVoidFunction lookupExtensionFunction(const char* name) {
+		if (std::strcmp(name, "vkCmdPushDescriptorSetKHR") == 0) return reinterpret_cast<PFN_vkVoidFunction>(&nullCmdPushDescriptorSetKHR);
+		if (std::strcmp(name, "vkCreateDebugUtilsMessengerEXT") == 0) return reinterpret_cast<PFN_vkVoidFunction>(&nullCreateDebugUtilsMessengerEXT);
+		if (std::strcmp(name, "vkDestroyDebugUtilsMessengerEXT") == 0) return reinterpret_cast<PFN_vkVoidFunction>(&nullDestroyDebugUtilsMessengerEXT);
+		return nullptr;
+	}
+}
+
+extern "C" {
+	// *************** Instance and physical device *********************
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateInstance(const VkInstanceCreateInfo*, const VkAllocationCallbacks*, VkInstance* pInstance) {
+		*pInstance = fakeHandle<VkInstance>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyInstance(VkInstance instance, const VkAllocationCallbacks*) { releaseHandle(instance); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateInstanceExtensionProperties(const char*, uint32_t* pPropertyCount, VkExtensionProperties* pProperties) {
+		const VkExtensionProperties extensions[] = {
+			extensionProperties(VK_KHR_SURFACE_EXTENSION_NAME),
+			extensionProperties(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME),
+			extensionProperties(VK_EXT_DEBUG_UTILS_EXTENSION_NAME),
+		};
+		return enumerate(extensions, 3, pPropertyCount, pProperties);
+	}
+
+	// the validation layer is reported so debug builds start, but nothing is validated
+	VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateInstanceLayerProperties(uint32_t* pPropertyCount, VkLayerProperties* pProperties) {
+		VkLayerProperties layer = {};
+		std::strncpy(layer.layerName, "VK_LAYER_KHRONOS_validation", VK_MAX_EXTENSION_NAME_SIZE - 1);
+		std::strncpy(layer.description, "null backend placeholder", VK_MAX_DESCRIPTION_SIZE - 1);
+		layer.specVersion = VK_API_VERSION_1_0;
+		return enumerate(&layer, 1, pPropertyCount, pProperties);
+	}
+
+	VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance, const char* pName) { return lookupExtensionFunction(pName); }
+
+	VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice, const char* pName) { return lookupExtensionFunction(pName); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkEnumeratePhysicalDevices(VkInstance, uint32_t* pPhysicalDeviceCount, VkPhysicalDevice* pPhysicalDevices) {
+		static const VkPhysicalDevice physicalDevice = fakeHandle<VkPhysicalDevice>();
+		return enumerate(&physicalDevice, 1, pPhysicalDeviceCount, pPhysicalDevices);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties(VkPhysicalDevice, VkPhysicalDeviceProperties* pProperties) {
+		*pProperties = {};
+		pProperties->apiVersion = VK_API_VERSION_1_1;
+		pProperties->deviceType = VK_PHYSICAL_DEVICE_TYPE_CPU;
+		std::strncpy(pProperties->deviceName, "null vulkan backend", VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+		pProperties->limits.maxImageDimension2D = 16384;
+		pProperties->limits.maxPushConstantsSize = 128;
+		pProperties->limits.maxBoundDescriptorSets = 8;
+		pProperties->limits.minUniformBufferOffsetAlignment = 256;
+		pProperties->limits.minStorageBufferOffsetAlignment = 256;
+		pProperties->limits.nonCoherentAtomSize = 64;
+		pProperties->limits.maxSamplerAnisotropy = 16.f;
+		pProperties->limits.timestampComputeAndGraphics = VK_FALSE; // there is no GPU time to measure
+		pProperties->limits.timestampPeriod = 1.f;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures(VkPhysicalDevice, VkPhysicalDeviceFeatures* pFeatures) {
+		*pFeatures = {};
+		pFeatures->samplerAnisotropy = VK_TRUE;
+	}
+
+	// extension structures in the chain are left untouched, the backend advertises none that have any
+	VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2* pFeatures) {
+		vkGetPhysicalDeviceFeatures(physicalDevice, &pFeatures->features);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties2* pProperties) {
+		vkGetPhysicalDeviceProperties(physicalDevice, &pProperties->properties);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice, VkFormat, VkFormatProperties* pFormatProperties) {
+		// every format supports everything, so format selection always picks the first candidate
+		pFormatProperties->linearTilingFeatures = ~0u;
+		pFormatProperties->optimalTilingFeatures = ~0u;
+		pFormatProperties->bufferFeatures = ~0u;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice, uint32_t* pQueueFamilyPropertyCount, VkQueueFamilyProperties* pQueueFamilyProperties) {
+		VkQueueFamilyProperties family = {};
+		family.queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+		family.queueCount = 1;
+		family.timestampValidBits = 0;
+		family.minImageTransferGranularity = { 1, 1, 1 };
+		enumerate(&family, 1, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice, VkPhysicalDeviceMemoryProperties* pMemoryProperties) {
+		*pMemoryProperties = {};
+		pMemoryProperties->memoryHeapCount = 1;
+		pMemoryProperties->memoryHeaps[0].size = VkDeviceSize{ 1 } << 40;
+		pMemoryProperties->memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+		pMemoryProperties->memoryTypeCount = 1;
+		pMemoryProperties->memoryTypes[0].heapIndex = 0;
+		pMemoryProperties->memoryTypes[0].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateDeviceExtensionProperties(VkPhysicalDevice, const char*, uint32_t* pPropertyCount, VkExtensionProperties* pProperties) {
+		const VkExtensionProperties extensions[] = { extensionProperties(VK_KHR_SWAPCHAIN_EXTENSION_NAME), extensionProperties(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) };
+		return enumerate(extensions, 2, pPropertyCount, pProperties);
+	}
+
+	// *************** Surface and swap chain *********************
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateHeadlessSurfaceEXT(VkInstance, const VkHeadlessSurfaceCreateInfoEXT*, const VkAllocationCallbacks*, VkSurfaceKHR* pSurface) {
+		*pSurface = fakeHandle<VkSurfaceKHR>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroySurfaceKHR(VkInstance, VkSurfaceKHR surface, const VkAllocationCallbacks*) { releaseHandle(surface); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceSupportKHR(VkPhysicalDevice, uint32_t, VkSurfaceKHR, VkBool32* pSupported) {
+		*pSupported = VK_TRUE;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceCapabilitiesKHR(VkPhysicalDevice, VkSurfaceKHR, VkSurfaceCapabilitiesKHR* pSurfaceCapabilities) {
+		*pSurfaceCapabilities = {};
+		pSurfaceCapabilities->minImageCount = 2;
+		pSurfaceCapabilities->maxImageCount = 3;
+		pSurfaceCapabilities->currentExtent = { 0xFFFFFFFF, 0xFFFFFFFF }; // the swap chain decides, so it uses the window size
+		pSurfaceCapabilities->minImageExtent = { 1, 1 };
+		pSurfaceCapabilities->maxImageExtent = { 16384, 16384 };
+		pSurfaceCapabilities->maxImageArrayLayers = 1;
+		pSurfaceCapabilities->supportedTransforms = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+		pSurfaceCapabilities->currentTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+		pSurfaceCapabilities->supportedCompositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+		pSurfaceCapabilities->supportedUsageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceFormatsKHR(VkPhysicalDevice, VkSurfaceKHR, uint32_t* pSurfaceFormatCount, VkSurfaceFormatKHR* pSurfaceFormats) {
+		const VkSurfaceFormatKHR format = { VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+		return enumerate(&format, 1, pSurfaceFormatCount, pSurfaceFormats);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfacePresentModesKHR(VkPhysicalDevice, VkSurfaceKHR, uint32_t* pPresentModeCount, VkPresentModeKHR* pPresentModes) {
+		const VkPresentModeKHR modes[] = { VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_MAILBOX_KHR };
+		return enumerate(modes, 2, pPresentModeCount, pPresentModes);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateSwapchainKHR(VkDevice, const VkSwapchainCreateInfoKHR* pCreateInfo, const VkAllocationCallbacks*, VkSwapchainKHR* pSwapchain) {
+		*pSwapchain = objectHandle<VkSwapchainKHR>(new NullSwapchain{ pCreateInfo->minImageCount, 0 });
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroySwapchainKHR(VkDevice, VkSwapchainKHR swapchain, const VkAllocationCallbacks*) {
+		if (swapchain == VK_NULL_HANDLE) return;
+		releaseHandle(swapchain);
+		delete handleObject<NullSwapchain>(swapchain);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkGetSwapchainImagesKHR(VkDevice, VkSwapchainKHR swapchain, uint32_t* pSwapchainImageCount, VkImage* pSwapchainImages) {
+		NullSwapchain* swapchainObject = handleObject<NullSwapchain>(swapchain);
+		if (pSwapchainImages == nullptr) {
+			*pSwapchainImageCount = swapchainObject->imageCount;
+			return VK_SUCCESS;
+		}
+		for (uint32_t i = 0; i < *pSwapchainImageCount && i < swapchainObject->imageCount; i++) {
+			pSwapchainImages[i] = fakeHandle<VkImage>(); // owned by the swap chain, never destroyed individually
+		}
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkAcquireNextImageKHR(VkDevice, VkSwapchainKHR swapchain, uint64_t, VkSemaphore, VkFence, uint32_t* pImageIndex) {
+		NullSwapchain* swapchainObject = handleObject<NullSwapchain>(swapchain);
+		*pImageIndex = swapchainObject->nextImage;
+		swapchainObject->nextImage = (swapchainObject->nextImage + 1) % swapchainObject->imageCount;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkQueuePresentKHR(VkQueue, const VkPresentInfoKHR* pPresentInfo) {
+		count(counters.presents, pPresentInfo->swapchainCount);
+		return VK_SUCCESS;
+	}
+
+	// *************** Device, queues and synchronization *********************
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateDevice(VkPhysicalDevice, const VkDeviceCreateInfo*, const VkAllocationCallbacks*, VkDevice* pDevice) {
+		*pDevice = fakeHandle<VkDevice>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyDevice(VkDevice device, const VkAllocationCallbacks*) { releaseHandle(device); }
+
+	VKAPI_ATTR void VKAPI_CALL vkGetDeviceQueue(VkDevice, uint32_t, uint32_t, VkQueue* pQueue) {
+		static const VkQueue queue = fakeHandle<VkQueue>();
+		*pQueue = queue;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkQueueSubmit(VkQueue, uint32_t submitCount, const VkSubmitInfo*, VkFence) {
+		count(counters.submits, submitCount);
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkQueueWaitIdle(VkQueue) { return VK_SUCCESS; }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkDeviceWaitIdle(VkDevice) { return VK_SUCCESS; }
+
+	// work completes the moment it is submitted, so fences are always signaled
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateFence(VkDevice, const VkFenceCreateInfo*, const VkAllocationCallbacks*, VkFence* pFence) {
+		*pFence = fakeHandle<VkFence>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyFence(VkDevice, VkFence fence, const VkAllocationCallbacks*) { releaseHandle(fence); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkResetFences(VkDevice, uint32_t, const VkFence*) { return VK_SUCCESS; }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkWaitForFences(VkDevice, uint32_t, const VkFence*, VkBool32, uint64_t) { return VK_SUCCESS; }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateSemaphore(VkDevice, const VkSemaphoreCreateInfo*, const VkAllocationCallbacks*, VkSemaphore* pSemaphore) {
+		*pSemaphore = fakeHandle<VkSemaphore>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroySemaphore(VkDevice, VkSemaphore semaphore, const VkAllocationCallbacks*) { releaseHandle(semaphore); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateQueryPool(VkDevice, const VkQueryPoolCreateInfo*, const VkAllocationCallbacks*, VkQueryPool* pQueryPool) {
+		*pQueryPool = fakeHandle<VkQueryPool>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyQueryPool(VkDevice, VkQueryPool queryPool, const VkAllocationCallbacks*) { releaseHandle(queryPool); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkGetQueryPoolResults(VkDevice, VkQueryPool, uint32_t, uint32_t, size_t dataSize, void* pData, VkDeviceSize, VkQueryResultFlags) {
+		std::memset(pData, 0, dataSize);
+		return VK_SUCCESS;
+	}
+
+	// *************** Memory and resources *********************
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(VkDevice, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks*, VkDeviceMemory* pMemory) {
+		void* data = std::calloc(1, static_cast<size_t>(pAllocateInfo->allocationSize));
+		if (data == nullptr) return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+		count(counters.bytesAllocated, pAllocateInfo->allocationSize);
+		*pMemory = objectHandle<VkDeviceMemory>(new NullMemory{ data, pAllocateInfo->allocationSize });
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks*) {
+		if (memory == VK_NULL_HANDLE) return;
+		NullMemory* memoryObject = handleObject<NullMemory>(memory);
+		counters.bytesAllocated.fetch_sub(memoryObject->size, std::memory_order_relaxed);
+		std::free(memoryObject->data);
+		delete memoryObject;
+		releaseHandle(memory);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(VkDevice, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize, VkMemoryMapFlags, void** ppData) {
+		*ppData = static_cast<char*>(handleObject<NullMemory>(memory)->data) + offset;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkUnmapMemory(VkDevice, VkDeviceMemory) {}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkFlushMappedMemoryRanges(VkDevice, uint32_t, const VkMappedMemoryRange*) { return VK_SUCCESS; }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkInvalidateMappedMemoryRanges(VkDevice, uint32_t, const VkMappedMemoryRange*) { return VK_SUCCESS; }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateBuffer(VkDevice, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkBuffer* pBuffer) {
+		*pBuffer = objectHandle<VkBuffer>(new NullResource{ pCreateInfo->size });
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyBuffer(VkDevice, VkBuffer buffer, const VkAllocationCallbacks*) {
+		if (buffer == VK_NULL_HANDLE) return;
+		delete handleObject<NullResource>(buffer);
+		releaseHandle(buffer);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements(VkDevice, VkBuffer buffer, VkMemoryRequirements* pMemoryRequirements) {
+		pMemoryRequirements->size = handleObject<NullResource>(buffer)->size;
+		pMemoryRequirements->alignment = 256;
+		pMemoryRequirements->memoryTypeBits = 1;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkBindBufferMemory(VkDevice, VkBuffer, VkDeviceMemory, VkDeviceSize) { return VK_SUCCESS; }
+
+	// images get a token allocation; nothing is ever rendered into them
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateImage(VkDevice, const VkImageCreateInfo*, const VkAllocationCallbacks*, VkImage* pImage) {
+		*pImage = objectHandle<VkImage>(new NullResource{ 256 });
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyImage(VkDevice, VkImage image, const VkAllocationCallbacks*) {
+		if (image == VK_NULL_HANDLE) return;
+		delete handleObject<NullResource>(image);
+		releaseHandle(image);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements(VkDevice, VkImage image, VkMemoryRequirements* pMemoryRequirements) {
+		pMemoryRequirements->size = handleObject<NullResource>(image)->size;
+		pMemoryRequirements->alignment = 256;
+		pMemoryRequirements->memoryTypeBits = 1;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkBindImageMemory(VkDevice, VkImage, VkDeviceMemory, VkDeviceSize) { return VK_SUCCESS; }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateImageView(VkDevice, const VkImageViewCreateInfo*, const VkAllocationCallbacks*, VkImageView* pView) {
+		*pView = fakeHandle<VkImageView>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyImageView(VkDevice, VkImageView imageView, const VkAllocationCallbacks*) { releaseHandle(imageView); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateSampler(VkDevice, const VkSamplerCreateInfo*, const VkAllocationCallbacks*, VkSampler* pSampler) {
+		*pSampler = fakeHandle<VkSampler>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroySampler(VkDevice, VkSampler sampler, const VkAllocationCallbacks*) { releaseHandle(sampler); }
+
+	// *************** Pipelines and render passes *********************
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateShaderModule(VkDevice, const VkShaderModuleCreateInfo*, const VkAllocationCallbacks*, VkShaderModule* pShaderModule) {
+		*pShaderModule = fakeHandle<VkShaderModule>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyShaderModule(VkDevice, VkShaderModule shaderModule, const VkAllocationCallbacks*) { releaseHandle(shaderModule); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateGraphicsPipelines(VkDevice, VkPipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo*, const VkAllocationCallbacks*, VkPipeline* pPipelines) {
+		for (uint32_t i = 0; i < createInfoCount; i++) pPipelines[i] = fakeHandle<VkPipeline>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyPipeline(VkDevice, VkPipeline pipeline, const VkAllocationCallbacks*) { releaseHandle(pipeline); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreatePipelineLayout(VkDevice, const VkPipelineLayoutCreateInfo*, const VkAllocationCallbacks*, VkPipelineLayout* pPipelineLayout) {
+		*pPipelineLayout = fakeHandle<VkPipelineLayout>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyPipelineLayout(VkDevice, VkPipelineLayout pipelineLayout, const VkAllocationCallbacks*) { releaseHandle(pipelineLayout); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateRenderPass(VkDevice, const VkRenderPassCreateInfo*, const VkAllocationCallbacks*, VkRenderPass* pRenderPass) {
+		*pRenderPass = fakeHandle<VkRenderPass>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyRenderPass(VkDevice, VkRenderPass renderPass, const VkAllocationCallbacks*) { releaseHandle(renderPass); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateFramebuffer(VkDevice, const VkFramebufferCreateInfo*, const VkAllocationCallbacks*, VkFramebuffer* pFramebuffer) {
+		*pFramebuffer = fakeHandle<VkFramebuffer>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyFramebuffer(VkDevice, VkFramebuffer framebuffer, const VkAllocationCallbacks*) { releaseHandle(framebuffer); }
+
+	// *************** Descriptors *********************
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorSetLayout(VkDevice, const VkDescriptorSetLayoutCreateInfo*, const VkAllocationCallbacks*, VkDescriptorSetLayout* pSetLayout) {
+		*pSetLayout = fakeHandle<VkDescriptorSetLayout>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyDescriptorSetLayout(VkDevice, VkDescriptorSetLayout descriptorSetLayout, const VkAllocationCallbacks*) { releaseHandle(descriptorSetLayout); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorPool(VkDevice, const VkDescriptorPoolCreateInfo*, const VkAllocationCallbacks*, VkDescriptorPool* pDescriptorPool) {
+		*pDescriptorPool = fakeHandle<VkDescriptorPool>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyDescriptorPool(VkDevice, VkDescriptorPool descriptorPool, const VkAllocationCallbacks*) { releaseHandle(descriptorPool); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkResetDescriptorPool(VkDevice, VkDescriptorPool, VkDescriptorPoolResetFlags) { return VK_SUCCESS; }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkAllocateDescriptorSets(VkDevice, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets) {
+		for (uint32_t i = 0; i < pAllocateInfo->descriptorSetCount; i++) pDescriptorSets[i] = fakeHandle<VkDescriptorSet>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkFreeDescriptorSets(VkDevice, VkDescriptorPool, uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets) {
+		for (uint32_t i = 0; i < descriptorSetCount; i++) releaseHandle(pDescriptorSets[i]);
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkUpdateDescriptorSets(VkDevice, uint32_t descriptorWriteCount, const VkWriteDescriptorSet*, uint32_t, const VkCopyDescriptorSet*) {
+		count(counters.descriptorWrites, descriptorWriteCount);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorUpdateTemplate(VkDevice, const VkDescriptorUpdateTemplateCreateInfo*, const VkAllocationCallbacks*, VkDescriptorUpdateTemplate* pDescriptorUpdateTemplate) {
+		*pDescriptorUpdateTemplate = fakeHandle<VkDescriptorUpdateTemplate>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyDescriptorUpdateTemplate(VkDevice, VkDescriptorUpdateTemplate descriptorUpdateTemplate, const VkAllocationCallbacks*) { releaseHandle(descriptorUpdateTemplate); }
+
+	// a template update counts as one write, like a single vkUpdateDescriptorSets entry
+	VKAPI_ATTR void VKAPI_CALL vkUpdateDescriptorSetWithTemplate(VkDevice, VkDescriptorSet, VkDescriptorUpdateTemplate, const void*) {
+		count(counters.descriptorWrites);
+	}
+
+	// *************** Command buffers *********************
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkCreateCommandPool(VkDevice, const VkCommandPoolCreateInfo*, const VkAllocationCallbacks*, VkCommandPool* pCommandPool) {
+		*pCommandPool = fakeHandle<VkCommandPool>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkDestroyCommandPool(VkDevice, VkCommandPool commandPool, const VkAllocationCallbacks*) { releaseHandle(commandPool); }
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkAllocateCommandBuffers(VkDevice, const VkCommandBufferAllocateInfo* pAllocateInfo, VkCommandBuffer* pCommandBuffers) {
+		for (uint32_t i = 0; i < pAllocateInfo->commandBufferCount; i++) pCommandBuffers[i] = fakeHandle<VkCommandBuffer>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkFreeCommandBuffers(VkDevice, VkCommandPool, uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers) {
+		for (uint32_t i = 0; i < commandBufferCount; i++) releaseHandle(pCommandBuffers[i]);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkBeginCommandBuffer(VkCommandBuffer, const VkCommandBufferBeginInfo*) {
+		count(counters.commandBuffersRecorded);
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkEndCommandBuffer(VkCommandBuffer) { return VK_SUCCESS; }
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdBeginRenderPass(VkCommandBuffer, const VkRenderPassBeginInfo*, VkSubpassContents) { count(counters.renderPasses); }
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdEndRenderPass(VkCommandBuffer) {}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdSetViewport(VkCommandBuffer, uint32_t, uint32_t, const VkViewport*) {}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdSetScissor(VkCommandBuffer, uint32_t, uint32_t, const VkRect2D*) {}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdBindPipeline(VkCommandBuffer, VkPipelineBindPoint, VkPipeline) { count(counters.pipelineBinds); }
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdBindDescriptorSets(VkCommandBuffer, VkPipelineBindPoint, VkPipelineLayout, uint32_t, uint32_t descriptorSetCount, const VkDescriptorSet*, uint32_t, const uint32_t*) {
+		count(counters.descriptorSetBinds, descriptorSetCount);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdBindVertexBuffers(VkCommandBuffer, uint32_t, uint32_t bindingCount, const VkBuffer*, const VkDeviceSize*) {
+		count(counters.vertexBufferBinds, bindingCount);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdBindIndexBuffer(VkCommandBuffer, VkBuffer, VkDeviceSize, VkIndexType) { count(counters.indexBufferBinds); }
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdPushConstants(VkCommandBuffer, VkPipelineLayout, VkShaderStageFlags, uint32_t, uint32_t size, const void*) {
+		count(counters.pushConstantBytes, size);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdDraw(VkCommandBuffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t, uint32_t) {
+		count(counters.draws);
+		count(counters.verticesSubmitted, static_cast<uint64_t>(vertexCount) * instanceCount);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexed(VkCommandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t, int32_t, uint32_t) {
+		count(counters.indexedDraws);
+		count(counters.verticesSubmitted, static_cast<uint64_t>(indexCount) * instanceCount);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdCopyBuffer(VkCommandBuffer, VkBuffer, VkBuffer, uint32_t, const VkBufferCopy*) {}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdCopyBufferToImage(VkCommandBuffer, VkBuffer, VkImage, VkImageLayout, uint32_t, const VkBufferImageCopy*) {}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdCopyImageToBuffer(VkCommandBuffer, VkImage, VkImageLayout, VkBuffer, uint32_t, const VkBufferImageCopy*) {}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier(VkCommandBuffer, VkPipelineStageFlags, VkPipelineStageFlags, VkDependencyFlags, uint32_t, const VkMemoryBarrier*, uint32_t, const VkBufferMemoryBarrier*, uint32_t, const VkImageMemoryBarrier*) {}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdResetQueryPool(VkCommandBuffer, VkQueryPool, uint32_t, uint32_t) {}
+
+	VKAPI_ATTR void VKAPI_CALL vkCmdWriteTimestamp(VkCommandBuffer, VkPipelineStageFlagBits, VkQueryPool, uint32_t) {}
+}
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <ostream>
+
+namespace engine {
+	// snapshot of the work the null backend has been asked to do
+	struct NullVulkanStats {
+		uint64_t commandBuffersRecorded = 0;
+		uint64_t renderPasses = 0;
+		uint64_t draws = 0; // vkCmdDraw calls
+		uint64_t indexedDraws = 0; // vkCmdDrawIndexed calls
+		uint64_t verticesSubmitted = 0; // vertices or indices times instances, over both draw kinds
+		uint64_t pipelineBinds = 0;
+		uint64_t descriptorSetBinds = 0; // individual sets, not calls
+		uint64_t vertexBufferBinds = 0;
+		uint64_t indexBufferBinds = 0;
+		uint64_t pushConstantBytes = 0;
+		uint64_t descriptorWrites = 0;
+		uint64_t submits = 0;
+		uint64_t presents = 0;
+		uint64_t objectsCreated = 0; // handles handed out, of any type
+		uint64_t objectsDestroyed = 0;
+		uint64_t bytesAllocated = 0; // device memory currently allocated
+	};
+
+	// Vulkan implementation that does nothing but count; built with ENGINE_NULL_VULKAN and linked in place of the Vulkan loader
+	// every entry point the engine calls returns success and plausible handles, so the whole frame loop runs on the CPU alone
+	class nullVulkan {
+	public:
+		static NullVulkanStats getStats(); // read every counter
+		static void resetStats(); // zero the per-frame work counters, object and memory counts are kept
+		static void report(std::ostream& out, uint64_t frameCount); // print totals and per-frame averages
+	};
+}
@@ -0,0 +1,333 @@
+#include "offscreenrenderer.hpp"
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace engine {
+	offscreenRenderer::offscreenRenderer(device& deviceInstance, VkExtent2D extent, uint32_t framesInFlight) : deviceInstance{ deviceInstance }, extent{ extent }, framesInFlight{ framesInFlight } {
+		assert(framesInFlight > 0 && "offscreen renderer needs at least one frame slot");
+		depthFormat = deviceInstance.findSupportedFormat({ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT }, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+		createRenderPass();
+		createImages();
+		createFramebuffers();
+		createCommandBuffers();
+		createSyncObjects();
+	}
+
+	offscreenRenderer::~offscreenRenderer() {
+		VkDevice logicalDevice = deviceInstance.getDevice();
+		vkDeviceWaitIdle(logicalDevice);
+
+		if (timestampPool != VK_NULL_HANDLE) {
+			vkDestroyQueryPool(logicalDevice, timestampPool, nullptr);
+		}
+		for (auto fence : inFlightFences) {
+			vkDestroyFence(logicalDevice, fence, nullptr);
+		}
+		vkFreeCommandBuffers(logicalDevice, deviceInstance.getCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+
+		for (size_t i = 0; i < framebuffers.size(); i++) {
+			vkDestroyFramebuffer(logicalDevice, framebuffers[i], nullptr);
+			vkDestroyImageView(logicalDevice, colorImageViews[i], nullptr);
+			vkDestroyImage(logicalDevice, colorImages[i], nullptr);
+			vkFreeMemory(logicalDevice, colorImageMemorys[i], nullptr);
+			vkDestroyImageView(logicalDevice, depthImageViews[i], nullptr);
+			vkDestroyImage(logicalDevice, depthImages[i], nullptr);
+			vkFreeMemory(logicalDevice, depthImageMemorys[i], nullptr);
+		}
+
+		vkDestroyRenderPass(logicalDevice, renderPass, nullptr);
+	}
+
+	void offscreenRenderer::createImages() {
+		colorImages.resize(framesInFlight);
+		colorImageMemorys.resize(framesInFlight);
+		colorImageViews.resize(framesInFlight);
+		depthImages.resize(framesInFlight);
+		depthImageMemorys.resize(framesInFlight);
+		depthImageViews.resize(framesInFlight);
+
+		for (uint32_t i = 0; i < framesInFlight; i++) {
+			// the color target is copied out after rendering, so it needs to be a transfer source as well
+			VkImageCreateInfo imageInfo = {};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.extent.width = extent.width;
+			imageInfo.extent.height = extent.height;
+			imageInfo.extent.depth = 1;
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.format = COLOR_FORMAT;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			deviceInstance.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImages[i], colorImageMemorys[i]);
+
+			imageInfo.format = depthFormat;
+			imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			deviceInstance.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImages[i], depthImageMemorys[i]);
+
+			VkImageViewCreateInfo viewInfo = {};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.subresourceRange.baseMipLevel = 0;
+			viewInfo.subresourceRange.levelCount = 1;
+			viewInfo.subresourceRange.baseArrayLayer = 0;
+			viewInfo.subresourceRange.layerCount = 1;
+
+			viewInfo.image = colorImages[i];
+			viewInfo.format = COLOR_FORMAT;
+			viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			if (vkCreateImageView(deviceInstance.getDevice(), &viewInfo, nullptr, &colorImageViews[i]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create offscreen color image view!");
+			}
+
+			viewInfo.image = depthImages[i];
+			viewInfo.format = depthFormat;
+			viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+			if (vkCreateImageView(deviceInstance.getDevice(), &viewInfo, nullptr, &depthImageViews[i]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create offscreen depth image view!");
+			}
+		}
+	}
+
+	void offscreenRenderer::createRenderPass() {
+		VkAttachmentDescription colorAttachment = {};
+		colorAttachment.format = COLOR_FORMAT;
+		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL; // nothing presents this image, it's only ever copied from
+
+		VkAttachmentDescription depthAttachment = {};
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference colorAttachmentRef = {};
+		colorAttachmentRef.attachment = 0;
+		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		VkAttachmentReference depthAttachmentRef = {};
+		depthAttachmentRef.attachment = 1;
+		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorAttachmentRef;
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+		// the previous use of the targets (rendering or a copy out) must finish before this pass writes to them
+		std::array<VkSubpassDependency, 2> dependencies = {};
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[0].srcAccessMask = 0;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		// and color writes must land before anything copies the image out
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+		VkRenderPassCreateInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassInfo.pDependencies = dependencies.data();
+
+		if (vkCreateRenderPass(deviceInstance.getDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create offscreen render pass!");
+		}
+	}
+
+	void offscreenRenderer::createFramebuffers() {
+		framebuffers.resize(framesInFlight);
+		for (uint32_t i = 0; i < framesInFlight; i++) {
+			std::array<VkImageView, 2> attachments = { colorImageViews[i], depthImageViews[i] };
+			VkFramebufferCreateInfo framebufferInfo = {};
+			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferInfo.renderPass = renderPass;
+			framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+			framebufferInfo.pAttachments = attachments.data();
+			framebufferInfo.width = extent.width;
+			framebufferInfo.height = extent.height;
+			framebufferInfo.layers = 1;
+
+			if (vkCreateFramebuffer(deviceInstance.getDevice(), &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create offscreen framebuffer!");
+			}
+		}
+	}
+
+	void offscreenRenderer::createCommandBuffers() {
+		commandBuffers.resize(framesInFlight);
+
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = deviceInstance.getCommandPool();
+		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+		if (vkAllocateCommandBuffers(deviceInstance.getDevice(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate command buffers!");
+		}
+	}
+
+	void offscreenRenderer::createSyncObjects() {
+		inFlightFences.resize(framesInFlight);
+		timestampsPending.resize(framesInFlight, false);
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		for (auto& fence : inFlightFences) {
+			if (vkCreateFence(deviceInstance.getDevice(), &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create synchronization objects for a frame!");
+			}
+		}
+
+		if (!deviceInstance.supportsTimestamps()) return; // frames still render, they just report no GPU time
+
+		VkQueryPoolCreateInfo queryPoolInfo = {};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = 2 * framesInFlight;
+		if (vkCreateQueryPool(deviceInstance.getDevice(), &queryPoolInfo, nullptr, &timestampPool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create timestamp query pool!");
+		}
+	}
+
+	void offscreenRenderer::collectGpuTime(int frameIndex) {
+		if (!timestampsPending[frameIndex]) return;
+		timestampsPending[frameIndex] = false;
+
+		// the slot's fence has signaled, so the results are available without waiting
+		uint64_t timestamps[2] = {};
+		VkResult result = vkGetQueryPoolResults(deviceInstance.getDevice(), timestampPool, 2 * frameIndex, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result == VK_SUCCESS) {
+			// timestamps only have the queue's valid bits, so take the difference modulo that range
+			uint32_t validBits = deviceInstance.getTimestampValidBits();
+			uint64_t mask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+			double ticks = static_cast<double>((timestamps[1] - timestamps[0]) & mask);
+			gpuFrameTimes.push_back(ticks * deviceInstance.getTimestampPeriod() / 1e6);
+		}
+	}
+
+	VkCommandBuffer offscreenRenderer::beginFrame() {
+		assert(!isFrameStarted && "Can't call beginFrame while already in progress");
+
+		// wait until the GPU is done with this slot's targets and command buffer
+		vkWaitForFences(deviceInstance.getDevice(), 1, &inFlightFences[currentFrameIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		collectGpuTime(currentFrameIndex);
+
+		isFrameStarted = true;
+
+		auto commandBuffer = getCurrentCommandBuffer();
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}
+
+		if (timestampPool != VK_NULL_HANDLE) {
+			vkCmdResetQueryPool(commandBuffer, timestampPool, 2 * currentFrameIndex, 2);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, 2 * currentFrameIndex);
+		}
+
+		return commandBuffer;
+	}
+
+	void offscreenRenderer::endFrame() {
+		assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
+
+		auto commandBuffer = getCurrentCommandBuffer();
+		if (timestampPool != VK_NULL_HANDLE) {
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 2 * currentFrameIndex + 1);
+			timestampsPending[currentFrameIndex] = true;
+		}
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record command buffer!");
+		}
+
+		// nothing is acquired or presented, so there are no semaphores to wait on or signal
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		vkResetFences(deviceInstance.getDevice(), 1, &inFlightFences[currentFrameIndex]);
+		if (vkQueueSubmit(deviceInstance.getGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrameIndex]) != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit draw command buffer!");
+		}
+
+		isFrameStarted = false;
+		currentFrameIndex = (currentFrameIndex + 1) % framesInFlight;
+	}
+
+	void offscreenRenderer::beginRenderPass(VkCommandBuffer commandBuffer) {
+		assert(isFrameStarted && "Can't call beginRenderPass if frame is not in progress");
+		assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame");
+
+		VkRenderPassBeginInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = renderPass;
+		renderPassInfo.framebuffer = framebuffers[currentFrameIndex];
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = extent;
+
+		// same clear values as the swap chain pass so the output matches what's on screen
+		std::array<VkClearValue, 2> clearValues = {};
+		clearValues[0].color = { 0.01f, 0.1f, 0.1f, 1.0f };
+		clearValues[1].depthStencil = { 1.0f, 0 };
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassInfo.pClearValues = clearValues.data();
+
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+		VkViewport viewport = {};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ {0, 0}, extent };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
+	void offscreenRenderer::endRenderPass(VkCommandBuffer commandBuffer) {
+		assert(isFrameStarted && "Can't call endRenderPass if frame is not in progress");
+		assert(commandBuffer == getCurrentCommandBuffer() && "Can't end render pass on command buffer from a different frame");
+
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
+	void offscreenRenderer::finish() {
+		vkWaitForFences(deviceInstance.getDevice(), static_cast<uint32_t>(inFlightFences.size()), inFlightFences.data(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+		// collect in submission order, starting with the oldest slot
+		for (uint32_t i = 0; i < framesInFlight; i++) {
+			collectGpuTime((currentFrameIndex + i) % framesInFlight);
+		}
+	}
+}
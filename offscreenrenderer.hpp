@@ -0,0 +1,79 @@
+#pragma once
+#include "device.hpp"
+#include "swapchain.hpp"
+#include <cassert>
+#include <vector>
+
+namespace engine {
+	// renders into images owned by the engine instead of a swap chain, for headless benchmarks and offline rendering
+	// mirrors the renderer interface so render systems can't tell the difference
+	class offscreenRenderer {
+	public:
+		static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM; // linear RGBA, easy to read back
+
+		// framesInFlight sets how many frames can be queued before beginFrame waits; batch work like thumbnails wants more than a swap chain
+		offscreenRenderer(device& deviceInstance, VkExtent2D extent, uint32_t framesInFlight = swapchain::MAX_FRAMES_IN_FLIGHT); // constructor
+		~offscreenRenderer(); // destructor
+
+		// not copyable or movable
+		offscreenRenderer(const offscreenRenderer&) = delete;
+		offscreenRenderer& operator = (const offscreenRenderer&) = delete;
+
+		VkRenderPass getRenderPass() const { return renderPass; }
+		VkExtent2D getExtent() const { return extent; }
+		uint32_t getFramesInFlight() const { return framesInFlight; }
+		float getAspectRatio() const { return static_cast<float>(extent.width) / static_cast<float>(extent.height); }
+		VkImage getColorImage(int index) const { return colorImages[index]; } // left in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL after each frame
+		bool isFrameInProgress() const { return isFrameStarted; }
+
+		VkCommandBuffer getCurrentCommandBuffer() const {
+			assert(isFrameStarted && "Cannot get command buffer when frame is not in progress");
+			return commandBuffers[currentFrameIndex];
+		}
+
+		int getFrameIndex() const {
+			assert(isFrameStarted && "Cannot get frame index when frame is not in progress");
+			return currentFrameIndex;
+		}
+
+		VkCommandBuffer beginFrame(); // wait for this frame slot to retire, then start recording
+		void endFrame(); // submit the frame without waiting for it
+		void beginRenderPass(VkCommandBuffer commandBuffer);
+		void endRenderPass(VkCommandBuffer commandBuffer);
+		void finish(); // wait for every submitted frame and collect its GPU time
+
+		const std::vector<double>& getGpuFrameTimes() const { return gpuFrameTimes; } // GPU milliseconds of each retired frame, in submission order
+		void clearGpuFrameTimes() { gpuFrameTimes.clear(); } // drop timings gathered so far, e.g. after warm-up
+
+	private:
+		void createImages(); // create the color and depth targets for every frame in flight
+		void createRenderPass(); // same attachments as the swap chain pass, ending in a layout ready for copies
+		void createFramebuffers();
+		void createCommandBuffers();
+		void createSyncObjects(); // fences and the timestamp query pool
+		void collectGpuTime(int frameIndex); // read back the timestamps of a retired frame
+
+		device& deviceInstance; // a handle for the device instance
+		VkExtent2D extent; // size of every target
+		uint32_t framesInFlight; // number of frame slots, each with its own targets, command buffer and fence
+		VkFormat depthFormat;
+		VkRenderPass renderPass;
+
+		std::vector<VkImage> colorImages;
+		std::vector<VkDeviceMemory> colorImageMemorys;
+		std::vector<VkImageView> colorImageViews;
+		std::vector<VkImage> depthImages;
+		std::vector<VkDeviceMemory> depthImageMemorys;
+		std::vector<VkImageView> depthImageViews;
+		std::vector<VkFramebuffer> framebuffers;
+
+		std::vector<VkCommandBuffer> commandBuffers; // one per frame in flight
+		std::vector<VkFence> inFlightFences; // signaled when the frame slot's work has finished
+		std::vector<bool> timestampsPending; // whether the slot has timestamps that haven't been read yet
+		VkQueryPool timestampPool = VK_NULL_HANDLE; // two timestamps per frame slot, null if unsupported
+		std::vector<double> gpuFrameTimes;
+
+		int currentFrameIndex = 0;
+		bool isFrameStarted = false;
+	};
+}
@@ -1,6 +1,8 @@
 #include "pipeline.hpp"
 #include "model.hpp"
-#include <fstream>
+#include "assetreader.hpp"
+#include "assetpack.hpp"
+#include "startupprofiler.hpp"
 #include <iostream>
 #include <cassert>
 
@@ -17,20 +19,8 @@ namespace engine {
 	}
 
 	std::vector<char> pipeline::readFile(const std::string& filepath) {
-		std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
-
-		if (!file.is_open()) {
-			throw std::runtime_error("failed to open file: " + filepath);
-		}
-
-		size_t fileSize = static_cast<size_t>(file.tellg());
-		std::vector<char> buffer(fileSize);
-
-		file.seekg(0);
-		file.read(buffer.data(), fileSize);
-		file.close();
-
-		return buffer;
+		// one sized read straight into the vector, without a stream buffer in between
+		return assetReader::readFileBlocking(filepath);
 	}
 
 	void pipeline::createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo) {
@@ -38,10 +28,12 @@ namespace engine {
 		assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline:: no renderPass provided in configInfo");
 
 		// initialize shader modules
-		auto vertCode = readFile(vertFilepath);
-		auto fragCode = readFile(fragFilepath);
-		createShaderModule(vertCode, &vertShaderModule);
-		createShaderModule(fragCode, &fragShaderModule);
+		{
+			startupProfiler::phase phase{ "shader load" };
+			loadShaderModule(vertFilepath, &vertShaderModule);
+			loadShaderModule(fragFilepath, &fragShaderModule);
+		}
+		startupProfiler::phase phase{ "pipeline create" };
 
 		// fill in shader structs
 		VkPipelineShaderStageCreateInfo shaderStages[2];
@@ -73,6 +65,7 @@ namespace engine {
 		// fill in the VkGraphicsPipelineCreateInfo struct with the fixed-function stage structs
 		VkGraphicsPipelineCreateInfo pipelineInfo = {};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.flags = configInfo.pipelineFlags;
 		pipelineInfo.stageCount = 2;
 		pipelineInfo.pStages = shaderStages;
 		pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -99,11 +92,23 @@ namespace engine {
 		}
 	}
 
-	void pipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule) {
+	void pipeline::loadShaderModule(const std::string& filepath, VkShaderModule* shaderModule) {
+		// SPIR-V in a mounted pack is handed to the driver straight from the mapping, loose files are read in full
+		if (const assetPack* pack = assetPack::mounted()) {
+			if (std::optional<assetPack::Asset> asset = pack->find(filepath)) {
+				createShaderModule(asset->data, static_cast<size_t>(asset->size), shaderModule);
+				return;
+			}
+		}
+		auto code = readFile(filepath);
+		createShaderModule(code.data(), code.size(), shaderModule);
+	}
+
+	void pipeline::createShaderModule(const char* code, size_t size, VkShaderModule* shaderModule) {
 		VkShaderModuleCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+		createInfo.codeSize = size;
+		createInfo.pCode = reinterpret_cast<const uint32_t*>(code);
 
 		// create the shader module
 		if (vkCreateShaderModule(deviceInstance.getDevice(), &createInfo, nullptr, shaderModule) != VK_SUCCESS) {
@@ -23,6 +23,7 @@ namespace engine {
 		VkPipelineLayout pipelineLayout = nullptr;
 		VkRenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
+		VkPipelineCreateFlags pipelineFlags = 0; // VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT when the layout's sets live in a descriptor buffer
 	};
 
 	class pipeline {
@@ -40,7 +41,8 @@ namespace engine {
 	private:
 		static std::vector<char> readFile(const std::string& filepath); // to read a file
 		void createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo); // to set up the graphics pipeline
-		void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule); // for loading vertex buffer data
+		void loadShaderModule(const std::string& filepath, VkShaderModule* shaderModule); // from the mounted asset pack, or the loose file when it isn't packed
+		void createShaderModule(const char* code, size_t size, VkShaderModule* shaderModule); // for loading vertex buffer data
 
 		device& deviceInstance; // reference to device; this will outlive any instances of this class as a pipeline depends on a device to exist
 		VkPipeline graphicsPipeline; // a handle to the graphics pipeline
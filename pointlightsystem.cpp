@@ -1,4 +1,6 @@
 #include "pointlightsystem.hpp"
+#include "framecapture.hpp"
+#include "rendersystem.hpp"
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
@@ -12,31 +14,12 @@ namespace engine {
 		createPipeline(renderPass);
 	}
 
-	pointlightsystem::~pointlightsystem() {
-		vkDestroyPipelineLayout(deviceInstance.getDevice(), pipelineLayout, nullptr);
-	}
+	pointlightsystem::~pointlightsystem() {}
 
 	void pointlightsystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
-		// create a push constant range
-		//VkPushConstantRange pushConstantRange = {};
-		//pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		//pushConstantRange.offset = 0;
-		//pushConstantRange.size = sizeof(SimplePushConstantData);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
-
-		// fill out the VkPipelineLayoutCreateInfo struct
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
-		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 0;
-		pipelineLayoutInfo.pPushConstantRanges = nullptr;
-
-		// create the pipeline layout
-		if (vkCreatePipelineLayout(deviceInstance.getDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create pipeline layout!");
-		}
+		// the point light shaders take no push constants, but declaring the entity range anyway makes the layout identical to
+		// rendersystem's, so the cache hands back the same one and the global set bound for entities carries over
+		pipelineLayout = deviceInstance.getLayoutCache().getPipelineLayout({ globalSetLayout }, { rendersystem::pushConstantRange() });
 	}
 
 	void pointlightsystem::createPipeline(VkRenderPass renderPass) {
@@ -52,11 +35,21 @@ namespace engine {
 		pipelineInstance = std::make_unique<pipeline>(deviceInstance, "point_light.vert.spv", "point_light.frag.spv", pipelineConfig);
 	}
 
-	void pointlightsystem::render(FrameInfo& frameInfo) {
-		pipelineInstance->bind(frameInfo.commandBuffer);
+	void pointlightsystem::bind(VkCommandBuffer commandBuffer, VkDescriptorSet globalDescriptorSet) {
+		pipelineInstance->bind(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &globalDescriptorSet, 0, nullptr);
+	}
 
-		vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
+	uint32_t pointlightsystem::render(FrameInfo& frameInfo) {
+		pipelineInstance->bind(frameInfo.commandBuffer);
+		if (frameInfo.globalSetBoundLayout != pipelineLayout) {
+			vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
+			frameInfo.globalSetBoundLayout = pipelineLayout;
+		}
+		if (frameInfo.captureInstance) frameInfo.captureInstance->bindSystem(CaptureSystem::POINT_LIGHTS);
 
 		vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
+		if (frameInfo.captureInstance) frameInfo.captureInstance->draw(6, 1, 0, 0);
+		return 1;
 	}
 }
\ No newline at end of file
@@ -17,7 +17,9 @@ namespace engine {
 		pointlightsystem(const pointlightsystem&) = delete;
 		pointlightsystem& operator = (const pointlightsystem&) = delete;
 
-		void render(FrameInfo& frameInfo); // render the entities
+		uint32_t render(FrameInfo& frameInfo); // render the entities, returns the number of draws recorded
+		void bind(VkCommandBuffer commandBuffer, VkDescriptorSet globalDescriptorSet); // bind the pipeline and the global descriptor set
+		VkPipelineLayout getPipelineLayout() const { return pipelineLayout; }
 
 	private:
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout); // create a pipeline layout
@@ -25,6 +27,6 @@ namespace engine {
 
 		device& deviceInstance; // a handle for the device instance
 		std::unique_ptr<pipeline> pipelineInstance; // a handle for the pipeline instance
-		VkPipelineLayout pipelineLayout; // a handle for the pipeline layout
+		VkPipelineLayout pipelineLayout; // a handle for the pipeline layout, owned by the device's layout cache
 	};
 }
\ No newline at end of file
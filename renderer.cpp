@@ -1,4 +1,5 @@
 #include "renderer.hpp"
+#include "alloctracker.hpp"
 #include <stdexcept>
 #include <array>
 
@@ -13,6 +14,9 @@ namespace engine {
 	}
 
 	void renderer::recreateSwapchain() {
+		// recreating the swap chain allocates, so don't count this frame against the zero allocation budget
+		alloctracker::exemptCurrentFrame();
+
 		// get the current window size
 		auto extent = windowInstance.getExtent();
 
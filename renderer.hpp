@@ -19,6 +19,14 @@ namespace engine {
 		VkRenderPass getSwapchainRenderPass() const { return swapchainInstance->getRenderPass(); }
 		float getAspectRatio() const { return swapchainInstance->extentAspectRatio(); }
 		bool isFrameInProgress() const { return isFrameStarted; }
+		VkExtent2D getSwapchainExtent() const { return swapchainInstance->getSwapchainExtent(); }
+		VkFormat getSwapchainImageFormat() const { return swapchainInstance->getSwapchainImageFormat(); }
+		bool supportsReadback() const { return swapchainInstance->supportsReadback(); }
+
+		VkImage getCurrentImage() const {
+			assert(isFrameStarted && "Cannot get the swap chain image when frame is not in progress");
+			return swapchainInstance->getImage(currentImageIndex);
+		}
 
 		VkCommandBuffer getCurrentCommandBuffer() const {
 			assert(isFrameStarted && "Cannot get command buffer when frame is not in progress");
@@ -1,10 +1,14 @@
 #include "rendersystem.hpp"
+#include "framecapture.hpp"
+#include "staticbatcher.hpp"
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <stdexcept>
 #include <array>
+#include <algorithm>
+#include <memory_resource>
 
 namespace engine {
 	struct SimplePushConstantData {
@@ -12,36 +16,54 @@ namespace engine {
 		glm::mat4 normalMatrix{ 1.f };
 	};
 
+	// one draw of the frame: a whole model, or one submesh of a model with several
+	struct DrawItem {
+		entity* entityInstance = nullptr; // null for static chunks, which are already in world space
+		model* modelInstance = nullptr;
+		const model::Submesh* submesh = nullptr; // null draws the whole model
+		int32_t material = -1;
+	};
+
+	// conservative frustum test in clip space: a box is culled only if all eight corners are outside the same plane
+	static bool isVisible(const glm::mat4& modelViewProjection, const model::Bounds& bounds) {
+		uint32_t outside = 0x3f; // planes every corner so far is outside of: left, right, bottom, top, near, far
+		for (uint32_t corner = 0; corner < 8; corner++) {
+			glm::vec4 position = modelViewProjection * glm::vec4{
+				corner & 1 ? bounds.max.x : bounds.min.x,
+				corner & 2 ? bounds.max.y : bounds.min.y,
+				corner & 4 ? bounds.max.z : bounds.min.z,
+				1.f };
+			uint32_t planes = 0;
+			if (position.x < -position.w) planes |= 1;
+			if (position.x > position.w) planes |= 2;
+			if (position.y < -position.w) planes |= 4;
+			if (position.y > position.w) planes |= 8;
+			if (position.z < 0.f) planes |= 16;
+			if (position.z > position.w) planes |= 32;
+			outside &= planes;
+			if (outside == 0) return true;
+		}
+		return false;
+	}
+
 	rendersystem::rendersystem(device& deviceInstance, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : deviceInstance{ deviceInstance } {
 		createPipelineLayout(globalSetLayout);
 		createPipeline(renderPass);
 	}
 
-	rendersystem::~rendersystem() {
-		vkDestroyPipelineLayout(deviceInstance.getDevice(), pipelineLayout, nullptr);
+	rendersystem::~rendersystem() {}
+
+	VkPushConstantRange rendersystem::pushConstantRange() {
+		VkPushConstantRange range = {};
+		range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		range.offset = 0;
+		range.size = sizeof(SimplePushConstantData);
+		return range;
 	}
 
 	void rendersystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
-		// create a push constant range
-		VkPushConstantRange pushConstantRange = {};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(SimplePushConstantData);
-
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
-
-		// fill out the VkPipelineLayoutCreateInfo struct
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
-		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-
-		// create the pipeline layout
-		if (vkCreatePipelineLayout(deviceInstance.getDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create pipeline layout!");
-		}
+		// the layout is shared with every system that declares the same sets and push constants
+		pipelineLayout = deviceInstance.getLayoutCache().getPipelineLayout({ globalSetLayout }, { pushConstantRange() });
 	}
 
 	void rendersystem::createPipeline(VkRenderPass renderPass) {
@@ -55,23 +77,89 @@ namespace engine {
 		pipelineInstance = std::make_unique<pipeline>(deviceInstance, "simple_shader.vert.spv", "simple_shader.frag.spv", pipelineConfig);
 	}
 
-	void rendersystem::renderEntities(FrameInfo& frameInfo) {
-		pipelineInstance->bind(frameInfo.commandBuffer);
+	void rendersystem::bind(VkCommandBuffer commandBuffer, VkDescriptorSet globalDescriptorSet) {
+		pipelineInstance->bind(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &globalDescriptorSet, 0, nullptr);
+	}
 
-		vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
+	uint32_t rendersystem::renderEntities(FrameInfo& frameInfo) {
+		// the global set stays bound across pipelines with the same layout, so only the first system to draw binds it
+		pipelineInstance->bind(frameInfo.commandBuffer);
+		if (frameInfo.globalSetBoundLayout != pipelineLayout) {
+			vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
+			frameInfo.globalSetBoundLayout = pipelineLayout;
+		}
+		if (frameInfo.captureInstance) frameInfo.captureInstance->bindSystem(CaptureSystem::ENTITIES);
 
-		// loop through all entities and record their binds and draws to the command buffer
+		// gather what survives culling into frame scratch memory: the whole model, or each visible submesh when it has several
+		glm::mat4 viewProjection = frameInfo.cameraInstance.getProjection() * frameInfo.cameraInstance.getView();
+		std::pmr::vector<DrawItem> drawList{ frameInfo.frameAllocator.getResource() };
+		drawList.reserve(frameInfo.gameEntities.size() + (frameInfo.staticBatches ? frameInfo.staticBatches->getChunks().size() : 0));
 		for (auto& kv : frameInfo.gameEntities) {
-			auto& entityInstance = kv.second;
-			if (entityInstance.modelInstance == nullptr) continue;
-			SimplePushConstantData push = {};
-			push.modelMatrix = entityInstance.transform.mat4();
-			push.normalMatrix = entityInstance.transform.normalMatrix();
+			model* modelInstance = kv.second.modelInstance.get();
+			if (modelInstance == nullptr) continue;
+			if (kv.second.isStatic && frameInfo.staticBatches && frameInfo.staticBatches->isBatched(kv.first)) continue; // drawn by its chunk
+			glm::mat4 modelViewProjection = viewProjection * kv.second.transform.mat4();
+			if (!isVisible(modelViewProjection, modelInstance->getBounds())) continue;
+
+			const std::vector<model::Submesh>& submeshes = modelInstance->getSubmeshes();
+			if (submeshes.size() <= 1) {
+				drawList.push_back({ &kv.second, modelInstance, nullptr, submeshes.empty() ? -1 : submeshes[0].material });
+				continue;
+			}
+			for (const auto& submesh : submeshes) {
+				if (isVisible(modelViewProjection, submesh.bounds)) drawList.push_back({ &kv.second, modelInstance, &submesh, submesh.material });
+			}
+		}
+		if (frameInfo.staticBatches) {
+			for (const auto& chunk : frameInfo.staticBatches->getChunks()) {
+				if (isVisible(viewProjection, chunk.modelInstance->getBounds())) drawList.push_back({ nullptr, chunk.modelInstance, nullptr, chunk.material });
+			}
+		}
+
+		// sort by model so consecutive draws share buffer bindings, then by material; material indices are per model, so
+		// grouping them only means something within one
+		std::sort(drawList.begin(), drawList.end(), [](const DrawItem& a, const DrawItem& b) {
+			if (a.modelInstance != b.modelInstance) return a.modelInstance < b.modelInstance;
+			if (a.material != b.material) return a.material < b.material;
+			return a.entityInstance < b.entityInstance;
+		});
 
-			vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
+		// record the binds and draws to the command buffer, pushing an entity's constants only when the entity changes
+		uint32_t drawCount = 0;
+		model* boundModel = nullptr;
+		bool pushed = false;
+		entity* pushedEntity = nullptr;
+		for (const DrawItem& item : drawList) {
+			if (!pushed || item.entityInstance != pushedEntity) {
+				pushed = true;
+				pushedEntity = item.entityInstance;
+				SimplePushConstantData push = {}; // identity for static chunks
+				if (pushedEntity) {
+					push.modelMatrix = pushedEntity->transform.mat4();
+					push.normalMatrix = pushedEntity->transform.normalMatrix();
+				}
 
-			entityInstance.modelInstance->bind(frameInfo.commandBuffer);
-			entityInstance.modelInstance->draw(frameInfo.commandBuffer);
+				vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
+				if (frameInfo.captureInstance) frameInfo.captureInstance->pushConstants(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
+			}
+
+			if (item.modelInstance != boundModel) {
+				boundModel = item.modelInstance;
+				boundModel->bind(frameInfo.commandBuffer);
+				if (frameInfo.captureInstance) frameInfo.captureInstance->bindModel(*boundModel);
+			}
+			if (item.submesh == nullptr) {
+				boundModel->draw(frameInfo.commandBuffer);
+				if (frameInfo.captureInstance) frameInfo.captureInstance->drawModel(*boundModel);
+			}
+			else {
+				boundModel->drawSubmesh(frameInfo.commandBuffer, *item.submesh);
+				if (frameInfo.captureInstance) frameInfo.captureInstance->drawSubmesh(*boundModel, *item.submesh);
+			}
+			drawCount++;
 		}
+
+		return drawCount;
 	}
 }
\ No newline at end of file
@@ -17,7 +17,10 @@ namespace engine {
 		rendersystem(const rendersystem&) = delete;
 		rendersystem& operator = (const rendersystem&) = delete;
 
-		void renderEntities(FrameInfo& frameInfo); // render the entities
+		uint32_t renderEntities(FrameInfo& frameInfo); // render the entities, returns the number of draws recorded
+		void bind(VkCommandBuffer commandBuffer, VkDescriptorSet globalDescriptorSet); // bind the pipeline and the global descriptor set
+		VkPipelineLayout getPipelineLayout() const { return pipelineLayout; }
+		static VkPushConstantRange pushConstantRange(); // the per-entity push constants
 
 	private:
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout); // create a pipeline layout
@@ -25,6 +28,6 @@ namespace engine {
 		
 		device& deviceInstance; // a handle for the device instance
 		std::unique_ptr<pipeline> pipelineInstance; // a handle for the pipeline instance
-		VkPipelineLayout pipelineLayout; // a handle for the pipeline layout
+		VkPipelineLayout pipelineLayout; // a handle for the pipeline layout, owned by the device's layout cache
 	};
 }
\ No newline at end of file
@@ -0,0 +1,312 @@
+#include "scenegenerator.hpp"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace engine {
+	// splitmix64; unlike the std distributions its output is specified exactly, so scenes match across standard libraries
+	class sceneRandom {
+	public:
+		explicit sceneRandom(uint64_t seed) : state{ seed } {}
+
+		uint64_t next() {
+			uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			return z ^ (z >> 31);
+		}
+
+		float uniform(float low, float high) { return low + (high - low) * static_cast<float>(next() >> 40) * (1.f / 16777216.f); }
+		uint32_t below(uint32_t bound) { return static_cast<uint32_t>(((next() >> 32) * bound) >> 32); }
+		glm::vec3 color() { return { uniform(0.2f, 1.f), uniform(0.2f, 1.f), uniform(0.2f, 1.f) }; }
+
+	private:
+		uint64_t state;
+	};
+
+	// independent stream per purpose so adding meshes doesn't reshuffle node placement and vice versa
+	static uint64_t streamSeed(uint64_t seed, uint64_t stream) {
+		return sceneRandom{ seed ^ (stream * 0xd1b54a32d192ed03ull) }.next();
+	}
+
+	enum SceneStream : uint64_t {
+		NODE_STREAM = 1,
+		LIGHT_STREAM = 2,
+		MESH_STREAM = 0x100, // plus the mesh index
+	};
+
+	// fanout per level and number of roots so that hierarchyDepth levels hold at least entityCount nodes
+	static void hierarchyShape(const SceneSettings& settings, uint64_t& roots, uint64_t& fanout) {
+		uint32_t depth = std::max(settings.hierarchyDepth, 1u);
+		fanout = depth > 1 ? std::max<uint64_t>(2, static_cast<uint64_t>(std::llround(std::pow(static_cast<double>(settings.entityCount), 1.0 / depth)))) : 1;
+
+		uint64_t nodesPerRoot = 0;
+		uint64_t levelSize = 1;
+		for (uint32_t level = 0; level < depth && nodesPerRoot < settings.entityCount; level++) {
+			nodesPerRoot += levelSize;
+			levelSize *= fanout;
+		}
+		roots = std::max<uint64_t>(1, (settings.entityCount + nodesPerRoot - 1) / nodesPerRoot);
+	}
+
+	static uint64_t rootGridSide(uint64_t roots) {
+		return static_cast<uint64_t>(std::ceil(std::sqrt(static_cast<double>(roots))));
+	}
+
+	// world transform of a child whose parent only rotates about y and scales uniformly, which keeps the result an exact TRS
+	static TransformComponent composeTransforms(TransformComponent& parentWorld, const TransformComponent& local) {
+		TransformComponent world = {};
+		world.translation = glm::vec3{ parentWorld.mat4() * glm::vec4{ local.translation, 1.f } };
+		world.rotation = local.rotation + glm::vec3{ 0.f, parentWorld.rotation.y, 0.f };
+		world.scale = parentWorld.scale.x * local.scale;
+		return world;
+	}
+
+	const char* sceneGenerator::validate(const SceneSettings& settings) {
+		// the loader makes meshCount meshes and the nodes index them, so both must agree on there being at least one
+		if (settings.entityCount == 0) return "the scene needs at least one entity";
+		if (settings.entityCount >= SceneNode::NO_PARENT) return "too many entities for 32-bit node indices";
+		if (settings.meshCount == 0) return "the scene needs at least one mesh";
+		return nullptr;
+	}
+
+	Scene sceneGenerator::generate(const SceneSettings& settings) {
+		Scene sceneInstance = {};
+		sceneInstance.meshes.reserve(settings.meshCount);
+		for (uint32_t i = 0; i < settings.meshCount; i++) {
+			sceneInstance.meshes.push_back(generateMesh(settings, i));
+		}
+		sceneInstance.nodes = generateNodes(settings);
+		sceneInstance.lights = generateLights(settings);
+		return sceneInstance;
+	}
+
+	model::Builder sceneGenerator::generateMesh(const SceneSettings& settings, uint32_t meshIndex) {
+		sceneRandom random{ streamSeed(settings.seed, MESH_STREAM + meshIndex) };
+		uint32_t detail = std::max(settings.meshDetail, 4u);
+		detail += random.below(detail / 2 + 1); // vary the triangle count so every mesh is unique
+		glm::vec3 color = random.color();
+
+		switch (meshIndex % 3) {
+		case 0: return sphere(detail / 2, detail, color);
+		case 1: return grid(detail, random.uniform(0.05f, 0.2f), random.next(), color);
+		default: return rock(detail / 2, detail, random.uniform(0.1f, 0.35f), random.next(), color);
+		}
+	}
+
+	std::vector<SceneNode> sceneGenerator::generateNodes(const SceneSettings& settings) {
+		assert(settings.entityCount < SceneNode::NO_PARENT && "scene too large for 32-bit node indices");
+		sceneRandom random{ streamSeed(settings.seed, NODE_STREAM) };
+		uint32_t depth = std::max(settings.hierarchyDepth, 1u);
+		uint32_t meshCount = std::max(settings.meshCount, 1u);
+		uint64_t roots = 0;
+		uint64_t fanout = 0;
+		hierarchyShape(settings, roots, fanout);
+
+		std::vector<SceneNode> nodes = {};
+		nodes.reserve(settings.entityCount);
+
+		// random rotation for leaves, y only for anything that may get children
+		auto randomRotation = [&random](bool leaf) {
+			float yaw = random.uniform(-glm::pi<float>(), glm::pi<float>());
+			return leaf ? glm::vec3{ random.uniform(-glm::pi<float>(), glm::pi<float>()), yaw, random.uniform(-glm::pi<float>(), glm::pi<float>()) } : glm::vec3{ 0.f, yaw, 0.f };
+		};
+
+		// roots on a square grid on the ground
+		uint64_t side = rootGridSide(roots);
+		float offset = 0.5f * settings.spacing * static_cast<float>(side - 1);
+		for (uint64_t i = 0; i < roots && nodes.size() < settings.entityCount; i++) {
+			SceneNode node = {};
+			node.mesh = random.below(meshCount);
+			node.color = random.color();
+			node.transform.translation = { settings.spacing * static_cast<float>(i % side) - offset, 0.f, settings.spacing * static_cast<float>(i / side) - offset };
+			node.transform.rotation = randomRotation(depth == 1);
+			node.transform.scale = glm::vec3{ random.uniform(0.2f, 0.4f) * settings.spacing };
+			nodes.push_back(node);
+		}
+
+		// every further level orbits the previous one, breadth first so parents always precede children
+		size_t levelBegin = 0;
+		for (uint32_t level = 1; level < depth && nodes.size() < settings.entityCount; level++) {
+			size_t levelEnd = nodes.size();
+			bool leaf = level + 1 == depth;
+			for (size_t parent = levelBegin; parent < levelEnd && nodes.size() < settings.entityCount; parent++) {
+				for (uint64_t child = 0; child < fanout && nodes.size() < settings.entityCount; child++) {
+					float angle = glm::two_pi<float>() * (static_cast<float>(child) + random.uniform(0.f, 0.5f)) / static_cast<float>(fanout);
+					float radius = random.uniform(1.5f, 2.5f);
+
+					SceneNode node = {};
+					node.parent = static_cast<uint32_t>(parent);
+					node.mesh = random.below(meshCount);
+					node.color = random.color();
+					node.transform.translation = { radius * std::cos(angle), random.uniform(-0.3f, 0.3f), radius * std::sin(angle) };
+					node.transform.rotation = randomRotation(leaf);
+					node.transform.scale = glm::vec3{ random.uniform(0.25f, 0.5f) };
+					nodes.push_back(node);
+				}
+			}
+			levelBegin = levelEnd;
+		}
+
+		return nodes;
+	}
+
+	std::vector<SceneLight> sceneGenerator::generateLights(const SceneSettings& settings) {
+		sceneRandom random{ streamSeed(settings.seed, LIGHT_STREAM) };
+		uint64_t roots = 0;
+		uint64_t fanout = 0;
+		hierarchyShape(settings, roots, fanout);
+		float extent = 0.5f * settings.spacing * static_cast<float>(rootGridSide(roots));
+
+		// scattered above the ground, which is towards -y in this engine
+		std::vector<SceneLight> lights(settings.lightCount);
+		for (auto& light : lights) {
+			light.position = { random.uniform(-extent, extent), -random.uniform(1.f, 2.f) * settings.spacing, random.uniform(-extent, extent) };
+			light.color = glm::vec4{ random.color(), random.uniform(0.5f, 1.5f) };
+		}
+		return lights;
+	}
+
+	std::vector<TransformComponent> sceneGenerator::worldTransforms(const std::vector<SceneNode>& nodes) {
+		// resolved in one pass since parents come first
+		std::vector<TransformComponent> transforms(nodes.size());
+		for (size_t i = 0; i < nodes.size(); i++) {
+			const SceneNode& node = nodes[i];
+			assert((node.parent == SceneNode::NO_PARENT || node.parent < i) && "scene nodes must come after their parents");
+			transforms[i] = node.parent == SceneNode::NO_PARENT ? node.transform : composeTransforms(transforms[node.parent], node.transform);
+		}
+		return transforms;
+	}
+
+	void sceneGenerator::createEntities(const std::vector<SceneNode>& nodes, const std::vector<std::shared_ptr<model>>& models, entity::Map& entities) {
+		std::vector<TransformComponent> transforms = worldTransforms(nodes);
+		entities.reserve(entities.size() + nodes.size());
+
+		for (size_t i = 0; i < nodes.size(); i++) {
+			assert(nodes[i].mesh < models.size() && "scene node refers to a missing mesh");
+
+			auto entityInstance = entity::createEntity();
+			entityInstance.modelInstance = models[nodes[i].mesh];
+			entityInstance.color = nodes[i].color;
+			entityInstance.transform = transforms[i];
+			entities.emplace(entityInstance.getId(), std::move(entityInstance));
+		}
+	}
+
+	// *************** Mesh primitives *********************
+
+	model::Builder sceneGenerator::sphere(uint32_t rings, uint32_t segments, glm::vec3 color) {
+		model::Builder builderInstance = {};
+		builderInstance.vertices.reserve((rings + 1) * (segments + 1));
+		for (uint32_t ring = 0; ring <= rings; ring++) {
+			float phi = glm::pi<float>() * static_cast<float>(ring) / static_cast<float>(rings);
+			for (uint32_t segment = 0; segment <= segments; segment++) {
+				float theta = glm::two_pi<float>() * static_cast<float>(segment) / static_cast<float>(segments);
+				model::Vertex vertex = {};
+				vertex.normal = { std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta) };
+				vertex.position = vertex.normal;
+				vertex.color = color;
+				vertex.uv = { static_cast<float>(segment) / segments, static_cast<float>(ring) / rings };
+				builderInstance.vertices.push_back(vertex);
+			}
+		}
+
+		builderInstance.indices.reserve(6 * rings * segments);
+		for (uint32_t ring = 0; ring < rings; ring++) {
+			for (uint32_t segment = 0; segment < segments; segment++) {
+				uint32_t a = ring * (segments + 1) + segment;
+				uint32_t b = a + segments + 1;
+				builderInstance.indices.insert(builderInstance.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+		return builderInstance;
+	}
+
+	model::Builder sceneGenerator::grid(uint32_t cells, float amplitude, uint64_t seed, glm::vec3 color) {
+		// height field from a few random waves, which keeps the normals analytic
+		sceneRandom random{ seed };
+		struct Wave { float kx, kz, phase, weight; };
+		Wave waves[4] = {};
+		for (auto& wave : waves) {
+			wave = { random.uniform(-6.f, 6.f), random.uniform(-6.f, 6.f), random.uniform(0.f, glm::two_pi<float>()), amplitude * random.uniform(0.25f, 1.f) };
+		}
+
+		model::Builder builderInstance = {};
+		builderInstance.vertices.reserve((cells + 1) * (cells + 1));
+		for (uint32_t z = 0; z <= cells; z++) {
+			for (uint32_t x = 0; x <= cells; x++) {
+				float u = static_cast<float>(x) / cells;
+				float v = static_cast<float>(z) / cells;
+				float px = 2.f * u - 1.f;
+				float pz = 2.f * v - 1.f;
+
+				float height = 0.f;
+				float dx = 0.f;
+				float dz = 0.f;
+				for (const auto& wave : waves) {
+					float angle = wave.kx * px + wave.kz * pz + wave.phase;
+					height += wave.weight * std::sin(angle);
+					dx += wave.weight * wave.kx * std::cos(angle);
+					dz += wave.weight * wave.kz * std::cos(angle);
+				}
+
+				model::Vertex vertex = {};
+				vertex.position = { px, -height, pz }; // -y is up
+				vertex.normal = glm::normalize(glm::vec3{ -dx, -1.f, -dz });
+				vertex.color = color;
+				vertex.uv = { u, v };
+				builderInstance.vertices.push_back(vertex);
+			}
+		}
+
+		builderInstance.indices.reserve(6 * cells * cells);
+		for (uint32_t z = 0; z < cells; z++) {
+			for (uint32_t x = 0; x < cells; x++) {
+				uint32_t a = z * (cells + 1) + x;
+				uint32_t b = a + cells + 1;
+				builderInstance.indices.insert(builderInstance.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+		return builderInstance;
+	}
+
+	model::Builder sceneGenerator::rock(uint32_t rings, uint32_t segments, float roughness, uint64_t seed, glm::vec3 color) {
+		model::Builder builderInstance = sphere(rings, segments, color);
+
+		// push every vertex in or out along a sum of random directional waves
+		sceneRandom random{ seed };
+		struct Lump { glm::vec3 direction; float frequency, phase, weight; };
+		Lump lumps[6] = {};
+		for (auto& lump : lumps) {
+			glm::vec3 direction{ random.uniform(-1.f, 1.f), random.uniform(-1.f, 1.f), random.uniform(-1.f, 1.f) };
+			lump = { glm::normalize(direction + glm::vec3{ 1e-3f }), random.uniform(1.f, 5.f), random.uniform(0.f, glm::two_pi<float>()), random.uniform(0.3f, 1.f) };
+		}
+		for (auto& vertex : builderInstance.vertices) {
+			float displacement = 0.f;
+			for (const auto& lump : lumps) {
+				displacement += lump.weight * std::sin(lump.frequency * glm::dot(lump.direction, vertex.normal) + lump.phase);
+			}
+			vertex.position = vertex.normal * (1.f + roughness * displacement / 6.f);
+		}
+
+		// recompute normals from the displaced faces
+		for (auto& vertex : builderInstance.vertices) {
+			vertex.normal = glm::vec3{ 0.f };
+		}
+		for (size_t i = 0; i + 2 < builderInstance.indices.size(); i += 3) {
+			auto& a = builderInstance.vertices[builderInstance.indices[i]];
+			auto& b = builderInstance.vertices[builderInstance.indices[i + 1]];
+			auto& c = builderInstance.vertices[builderInstance.indices[i + 2]];
+			glm::vec3 faceNormal = glm::cross(b.position - a.position, c.position - a.position);
+			a.normal += faceNormal;
+			b.normal += faceNormal;
+			c.normal += faceNormal;
+		}
+		for (auto& vertex : builderInstance.vertices) {
+			float length = glm::length(vertex.normal);
+			vertex.normal = length > 0.f ? vertex.normal / length : glm::normalize(vertex.position);
+		}
+		return builderInstance;
+	}
+}
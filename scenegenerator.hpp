@@ -0,0 +1,63 @@
+#pragma once
+#include "entity.hpp"
+#include "model.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace engine {
+	// parameters of a generated scene; the same settings always produce the same scene
+	struct SceneSettings {
+		uint64_t entityCount = 1000; // 1 to 10M
+		uint32_t meshCount = 8; // unique meshes, cycling through spheres, grids and rocks
+		uint32_t meshDetail = 24; // segments around a sphere or rock, cells along a grid
+		uint32_t lightCount = 1;
+		uint32_t hierarchyDepth = 1; // 1 is flat, each extra level puts entities in orbit around a parent one level up
+		uint64_t seed = 1;
+		float spacing = 3.f; // distance between root entities on the ground grid
+		bool staticEntities = false; // flag every entity static so they're drawn from merged chunks rather than one by one
+	};
+
+	// one entity of a generated scene
+	struct SceneNode {
+		static constexpr uint32_t NO_PARENT = UINT32_MAX;
+		uint32_t parent = NO_PARENT; // index of the parent node, always lower than this node's own index
+		uint32_t mesh = 0; // index into Scene::meshes
+		TransformComponent transform = {}; // relative to the parent; nodes with children only rotate about y and scale uniformly
+		glm::vec3 color = {};
+	};
+
+	struct SceneLight {
+		glm::vec3 position = {};
+		glm::vec4 color{ 1.f }; // r, g, b, intensity
+	};
+
+	// CPU side description of a scene, ready to upload
+	struct Scene {
+		std::vector<model::Builder> meshes = {};
+		std::vector<SceneNode> nodes = {}; // parents come before their children
+		std::vector<SceneLight> lights = {};
+	};
+
+	// procedural scenes of configurable size for scaling tests
+	class sceneGenerator {
+	public:
+		static const char* validate(const SceneSettings& settings); // null when the settings can be generated, otherwise why not, for a usage error
+		static Scene generate(const SceneSettings& settings); // meshes, nodes and lights in one go
+
+		// the parts can also be generated separately, e.g. meshes on worker threads; each depends only on the settings
+		static model::Builder generateMesh(const SceneSettings& settings, uint32_t meshIndex);
+		static std::vector<SceneNode> generateNodes(const SceneSettings& settings);
+		static std::vector<SceneLight> generateLights(const SceneSettings& settings);
+
+		// resolve the hierarchy into world transforms, indexed like the nodes
+		static std::vector<TransformComponent> worldTransforms(const std::vector<SceneNode>& nodes);
+		// and add one entity per node
+		static void createEntities(const std::vector<SceneNode>& nodes, const std::vector<std::shared_ptr<model>>& models, entity::Map& entities);
+
+		// mesh primitives, all centered on the origin with unit radius or size
+		static model::Builder sphere(uint32_t rings, uint32_t segments, glm::vec3 color);
+		static model::Builder grid(uint32_t cells, float amplitude, uint64_t seed, glm::vec3 color);
+		static model::Builder rock(uint32_t rings, uint32_t segments, float roughness, uint64_t seed, glm::vec3 color);
+	};
+}
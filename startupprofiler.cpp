@@ -0,0 +1,70 @@
+#include "startupprofiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+	// captured during static initialization, which is as close to process start as we can get portably
+	static const startupProfiler::clock::time_point processStart = startupProfiler::clock::now();
+
+	struct StartupPhase {
+		const char* name;
+		startupProfiler::clock::time_point start;
+		startupProfiler::clock::time_point end;
+		std::thread::id threadId;
+	};
+
+	static std::mutex phaseMutex;
+	static std::vector<StartupPhase> phases;
+	static std::atomic<bool> firstFrameReported{ false };
+
+	static double millisecondsSinceStart(startupProfiler::clock::time_point time) {
+		return std::chrono::duration<double, std::milli>(time - processStart).count();
+	}
+
+	void startupProfiler::record(const char* name, clock::time_point start, clock::time_point end) {
+		if (firstFrameReported.load(std::memory_order_relaxed)) return; // only startup is of interest
+
+		std::lock_guard<std::mutex> lock{ phaseMutex };
+		phases.push_back({ name, start, end, std::this_thread::get_id() });
+	}
+
+	void startupProfiler::markFirstFrame() {
+		if (firstFrameReported.load(std::memory_order_relaxed)) return;
+
+		auto now = clock::now();
+		report(std::cout);
+		std::cout << "time to first frame: " << std::fixed << std::setprecision(2) << millisecondsSinceStart(now) << " ms" << std::endl;
+		firstFrameReported.store(true, std::memory_order_relaxed);
+	}
+
+	void startupProfiler::markFullDetail() {
+		static std::atomic<bool> fullDetailReported{ false };
+		if (fullDetailReported.exchange(true, std::memory_order_relaxed)) return;
+
+		std::cout << "time to full detail: " << std::fixed << std::setprecision(2) << millisecondsSinceStart(clock::now()) << " ms" << std::endl;
+	}
+
+	void startupProfiler::report(std::ostream& out) {
+		std::lock_guard<std::mutex> lock{ phaseMutex };
+
+		// number the threads in the order they first show up so the report is readable
+		std::unordered_map<std::thread::id, int> threadNumbers = {};
+		std::vector<StartupPhase> sorted = phases;
+		std::sort(sorted.begin(), sorted.end(), [](const StartupPhase& a, const StartupPhase& b) { return a.start < b.start; });
+
+		out << "startup phases (start/end relative to process start):" << std::endl;
+		for (const auto& phase : sorted) {
+			auto thread = threadNumbers.emplace(phase.threadId, static_cast<int>(threadNumbers.size())).first->second;
+			out << "\t" << std::left << std::setw(20) << phase.name << std::right << std::fixed << std::setprecision(2)
+				<< std::setw(10) << std::chrono::duration<double, std::milli>(phase.end - phase.start).count() << " ms"
+				<< "  [" << std::setw(9) << millisecondsSinceStart(phase.start) << " - " << std::setw(9) << millisecondsSinceStart(phase.end) << "]"
+				<< "  thread " << thread << std::endl;
+		}
+	}
+}
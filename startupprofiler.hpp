@@ -0,0 +1,41 @@
+#pragma once
+#include <chrono>
+#include <future>
+#include <ostream>
+
+namespace engine {
+	// records how long each startup phase takes, on whichever thread it runs, and reports it once the first frame is presented
+	class startupProfiler {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		// times the enclosing scope as a named startup phase
+		class phase {
+		public:
+			phase(const char* name) : name{ name }, start{ clock::now() } {} // constructor, starts the timer
+			~phase() { startupProfiler::record(name, start, clock::now()); } // destructor, records the phase
+
+			// not copyable or movable
+			phase(const phase&) = delete;
+			phase& operator = (const phase&) = delete;
+
+		private:
+			const char* name; // phase name, must be a string literal
+			clock::time_point start; // time the phase started
+		};
+
+		static void record(const char* name, clock::time_point start, clock::time_point end); // add a finished phase, ignored after the first frame
+		static void markFirstFrame(); // report time-to-first-frame and the phase breakdown, only the first call does anything
+		static void markFullDetail(); // report the time until streamed models finished refining, only the first call does anything
+		static void report(std::ostream& out); // print the phases recorded so far
+
+		// launch policy for startup work; ENGINE_SERIAL_STARTUP runs every task inline so the serial baseline can be measured
+		static constexpr std::launch launchPolicy() {
+#ifdef ENGINE_SERIAL_STARTUP
+			return std::launch::deferred;
+#else
+			return std::launch::async;
+#endif
+		}
+	};
+}
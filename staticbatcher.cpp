@@ -0,0 +1,178 @@
+#include "staticbatcher.hpp"
+#include "swapchain.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace engine {
+	staticBatcher::staticBatcher(device& deviceInstance) : deviceInstance{ deviceInstance } {}
+
+	staticBatcher::~staticBatcher() {}
+
+	uint64_t staticBatcher::cellKey(const glm::vec3& position) {
+		// 21 bits per axis centred on the origin, anything further out shares the border cells
+		auto axis = [](float value) {
+			float cell = std::floor(value / CELL_SIZE) + static_cast<float>(1 << 20);
+			return static_cast<uint64_t>(std::clamp(cell, 0.f, static_cast<float>((1 << 21) - 1)));
+		};
+		return axis(position.x) | axis(position.y) << 21 | axis(position.z) << 42;
+	}
+
+	uint32_t staticBatcher::update(entity::Map& entities) {
+		updateCount++;
+
+		// a chunk replaced MAX_FRAMES_IN_FLIGHT updates ago was last recorded in a frame whose fence has signaled since
+		retired.erase(std::remove_if(retired.begin(), retired.end(), [this](const auto& entry) { return entry.first + swapchain::MAX_FRAMES_IN_FLIGHT <= updateCount; }), retired.end());
+
+		// entities that became static, changed or stopped being batchable; unchanged ones cost a lookup and a compare
+		dirtyCells.clear();
+		size_t present = 0; // batched entities still in the map
+		for (auto& kv : entities) {
+			entity& entityInstance = kv.second;
+			auto found = batched.find(kv.first);
+			if (found != batched.end() && entityInstance.isStatic && found->second.modelInstance == entityInstance.modelInstance.get() &&
+				found->second.transform.translation == entityInstance.transform.translation && found->second.transform.rotation == entityInstance.transform.rotation && found->second.transform.scale == entityInstance.transform.scale) {
+				present++;
+				continue;
+			}
+
+			if (found != batched.end()) {
+				removeMember(found->second.cell, kv.first);
+				markDirty(found->second.cell);
+				batched.erase(found);
+			}
+			if (!isBatchable(entityInstance)) continue;
+
+			BatchedEntity state{ entityInstance.modelInstance.get(), entityInstance.transform, cellKey(entityInstance.transform.translation) };
+			cells[state.cell].members.push_back(kv.first);
+			markDirty(state.cell);
+			batched.emplace(kv.first, state);
+			present++;
+		}
+
+		// entities that were destroyed, only searched for when some are missing
+		if (present < batched.size()) {
+			for (auto it = batched.begin(); it != batched.end();) {
+				if (entities.count(it->first) > 0) {
+					++it;
+					continue;
+				}
+				removeMember(it->second.cell, it->first);
+				markDirty(it->second.cell);
+				it = batched.erase(it);
+			}
+		}
+
+		if (dirtyCells.empty()) return 0;
+		for (uint64_t key : dirtyCells) {
+			Cell& cell = cells[key];
+			cell.dirty = false;
+			rebuildCell(cell, entities);
+			if (cell.members.empty()) cells.erase(key);
+		}
+		rebuildCount += dirtyCells.size();
+
+		// meshes only the cache still holds belonged to models that were swapped out or destroyed, free them and their buffers
+		for (auto it = geometry.begin(); it != geometry.end();) {
+			if (it->second.owner.use_count() == 1) it = geometry.erase(it);
+			else ++it;
+		}
+
+		chunks.clear();
+		for (const auto& kv : cells) {
+			for (const auto& chunk : kv.second.chunks) {
+				chunks.push_back({ chunk.get(), chunk->getSubmeshes()[0].material });
+			}
+		}
+		return static_cast<uint32_t>(dirtyCells.size());
+	}
+
+	void staticBatcher::removeMember(uint64_t cell, entity::id_t id) {
+		std::vector<entity::id_t>& members = cells[cell].members;
+		auto found = std::find(members.begin(), members.end(), id);
+		if (found == members.end()) return;
+		*found = members.back();
+		members.pop_back();
+	}
+
+	void staticBatcher::markDirty(uint64_t cell) {
+		Cell& cellInstance = cells[cell];
+		if (cellInstance.dirty) return;
+		cellInstance.dirty = true;
+		dirtyCells.push_back(cell);
+	}
+
+	const model::Builder& staticBatcher::geometryOf(const std::shared_ptr<model>& modelInstance) {
+		auto found = geometry.find(modelInstance.get());
+		if (found != geometry.end()) return found->second.mesh;
+
+		Geometry& entry = geometry[modelInstance.get()];
+		entry.owner = modelInstance;
+		entry.mesh = modelInstance->readBack();
+		return entry.mesh;
+	}
+
+	bool staticBatcher::isBatchable(const entity& entityInstance) {
+		// progressive models wait until they're fully refined, or the chunk would keep the coarse level forever
+		if (!entityInstance.isStatic || entityInstance.modelInstance == nullptr || !entityInstance.modelInstance->isRefined()) return false;
+		return !geometryOf(entityInstance.modelInstance).indices.empty();
+	}
+
+	void staticBatcher::rebuildCell(Cell& cell, entity::Map& entities) {
+		for (auto& chunk : cell.chunks) retire(std::move(chunk));
+		cell.chunks.clear();
+
+		// a run of builders per material; a new one is started when the next mesh could take the current one past the limit
+		constexpr uint32_t UNASSIGNED = ~0u;
+		std::map<int32_t, std::vector<model::Builder>> batches = {};
+		std::vector<uint32_t> remap = {};
+		for (entity::id_t id : cell.members) {
+			entity& entityInstance = entities.at(id);
+			const model::Builder& source = geometryOf(entityInstance.modelInstance);
+			glm::mat4 modelMatrix = entityInstance.transform.mat4();
+			glm::mat3 normalMatrix = entityInstance.transform.normalMatrix();
+
+			for (const auto& submesh : source.getSubmeshes()) {
+				std::vector<model::Builder>& builders = batches[submesh.material];
+				if (builders.empty() || (!builders.back().vertices.empty() && builders.back().vertices.size() + source.vertices.size() > MAX_CHUNK_VERTICES)) {
+					builders.emplace_back();
+				}
+				model::Builder& target = builders.back();
+
+				// only the vertices the submesh uses, each transformed once
+				remap.assign(source.vertices.size(), UNASSIGNED);
+				for (uint32_t i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i++) {
+					uint32_t index = source.indices[i];
+					if (remap[index] == UNASSIGNED) {
+						remap[index] = static_cast<uint32_t>(target.vertices.size());
+						model::Vertex vertexInstance = source.vertices[index];
+						vertexInstance.position = glm::vec3{ modelMatrix * glm::vec4{ vertexInstance.position, 1.f } };
+						glm::vec3 normal = normalMatrix * vertexInstance.normal;
+						if (glm::dot(normal, normal) > 0.f) vertexInstance.normal = glm::normalize(normal);
+						target.vertices.push_back(vertexInstance);
+					}
+					target.indices.push_back(remap[index]);
+				}
+			}
+		}
+
+		for (auto& kv : batches) {
+			for (auto& builderInstance : kv.second) {
+				if (builderInstance.indices.empty()) continue;
+				model::Submesh whole = builderInstance.getSubmeshes()[0];
+				whole.material = kv.first;
+				builderInstance.submeshes = { whole };
+				cell.chunks.push_back(std::make_shared<model>(deviceInstance, builderInstance));
+			}
+		}
+	}
+
+	void staticBatcher::retire(std::shared_ptr<model> chunk) {
+		retired.emplace_back(updateCount, std::move(chunk));
+	}
+
+	void staticBatcher::report(std::ostream& out) const {
+		out << "static batches: " << batched.size() << " entities in " << chunks.size() << " chunk(s) over " << cells.size() << " cell(s), "
+			<< rebuildCount << " cell rebuild(s), " << geometry.size() << " mesh(es) cached" << std::endl;
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "device.hpp"
+#include "entity.hpp"
+#include "model.hpp"
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace engine {
+	// merges the geometry of entities flagged static into world space chunks, so a field of small props costs one draw per
+	// chunk instead of one per entity even when every prop is a different mesh
+	// static entities are bucketed into a grid of CELL_SIZE cells by position; a cell's entities are pre-transformed into
+	// one model per material, split again past MAX_CHUNK_VERTICES, and each chunk is culled by its own bounds. update()
+	// compares every static entity's model and transform with what was batched and rebuilds only the cells that changed
+	class staticBatcher {
+	public:
+		static constexpr float CELL_SIZE = 32.f; // world units along each side of a cell
+		static constexpr uint32_t MAX_CHUNK_VERTICES = 65536; // a chunk takes entities until the next one would go over this
+
+		// one merged draw; the vertices are in world space, so it's drawn with an identity model matrix
+		struct Chunk {
+			model* modelInstance = nullptr;
+			int32_t material = -1; // the OBJ material index shared by everything in the chunk
+		};
+
+		staticBatcher(device& deviceInstance); // constructor
+		~staticBatcher(); // destructor
+
+		// not copyable or movable
+		staticBatcher(const staticBatcher&) = delete;
+		staticBatcher& operator = (const staticBatcher&) = delete;
+
+		// bring the chunks in line with the entities, called between frames; a rebuild reads new meshes back and uploads the
+		// chunks, so it waits for the queue. Returns the number of cells rebuilt
+		uint32_t update(entity::Map& entities);
+
+		bool isBatched(entity::id_t id) const { return batched.count(id) > 0; } // drawn by a chunk rather than on its own
+		const std::vector<Chunk>& getChunks() const { return chunks; }
+
+		void report(std::ostream& out) const; // entities, chunks, cells and rebuilds so far
+
+	private:
+		// what an entity looked like when it was batched, a difference means its cell has to be rebuilt
+		struct BatchedEntity {
+			model* modelInstance = nullptr;
+			TransformComponent transform = {};
+			uint64_t cell = 0;
+		};
+
+		struct Cell {
+			std::vector<entity::id_t> members = {};
+			std::vector<std::shared_ptr<model>> chunks = {};
+			bool dirty = false; // already queued for this update's rebuild
+		};
+
+		// a mesh read back from the GPU once, kept with its model so the address isn't reused while it's cached
+		struct Geometry {
+			std::shared_ptr<model> owner = {};
+			model::Builder mesh = {};
+		};
+
+		static uint64_t cellKey(const glm::vec3& position); // the grid cell a position falls in
+		void removeMember(uint64_t cell, entity::id_t id);
+		const model::Builder& geometryOf(const std::shared_ptr<model>& modelInstance); // cached read back
+		bool isBatchable(const entity& entityInstance); // static, fully streamed in and indexed
+		void markDirty(uint64_t cell);
+		void rebuildCell(Cell& cell, entity::Map& entities); // replace the cell's chunks with ones built from its members
+		void retire(std::shared_ptr<model> chunk); // keep a replaced chunk alive until no frame in flight can draw it
+
+		device& deviceInstance; // a handle for the device instance
+		std::unordered_map<entity::id_t, BatchedEntity> batched = {};
+		std::unordered_map<uint64_t, Cell> cells = {};
+		std::unordered_map<const model*, Geometry> geometry = {}; // meshes static entities use, dropped after a rebuild once nothing else holds their model
+		std::vector<uint64_t> dirtyCells = {}; // cells to rebuild in this update, reused so an update without changes doesn't allocate
+		std::vector<Chunk> chunks = {}; // every cell's chunks, regathered after a rebuild
+		std::vector<std::pair<uint64_t, std::shared_ptr<model>>> retired = {}; // replaced chunks and the update they were replaced in
+		uint64_t updateCount = 0;
+		uint64_t rebuildCount = 0; // cells rebuilt since startup
+	};
+}
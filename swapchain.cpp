@@ -1,4 +1,5 @@
 #include "swapchain.hpp"
+#include "startupprofiler.hpp"
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -20,6 +21,7 @@ namespace engine {
 	}
 
 	void swapchain::init() {
+		startupProfiler::phase phase{ "swapchain" };
 		createSwapchain();
 		createImageViews();
 		createRenderPass();
@@ -101,7 +103,7 @@ namespace engine {
 		presentInfo.pSwapchains = swapchains;
 		presentInfo.pImageIndices = imageIndex;
 		auto result = vkQueuePresentKHR(deviceInstance.getPresentQueue(), &presentInfo);
-		currentFrame = (currentFrame + 1) & MAX_FRAMES_IN_FLIGHT; // advance to the next frame
+		currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT; // advance to the next frame, in step with the renderer's frame index
 
 		return result;
 	}
@@ -135,6 +137,10 @@ namespace engine {
 		createInfo.imageExtent = extent;
 		createInfo.imageArrayLayers = 1;
 		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		readbackSupported = (swapchainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+		if (readbackSupported) {
+			createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT; // lets frames be copied out for screenshots
+		}
 
 		// specify how to handle images used across multiple queue families
 		// important for if the graphics queue family is different from the presentation queue
@@ -235,13 +241,22 @@ namespace engine {
 		subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
 		// set up subpass dependencies
-		VkSubpassDependency dependency = {};
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.srcAccessMask = 0;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		dependency.dstSubpass = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		std::array<VkSubpassDependency, 2> dependencies = {};
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].srcAccessMask = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		// the implicit dependency out of the pass only reaches bottom of pipe, so a frameReadback copy recorded after it
+		// would not wait for the color writes and the transition to the present layout
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
 		// set up render pass
 		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
@@ -251,8 +266,8 @@ namespace engine {
 		renderPassInfo.pAttachments = attachments.data();
 		renderPassInfo.subpassCount = 1;
 		renderPassInfo.pSubpasses = &subpass;
-		renderPassInfo.dependencyCount = 1;
-		renderPassInfo.pDependencies = &dependency;
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassInfo.pDependencies = dependencies.data();
 
 		if (vkCreateRenderPass(deviceInstance.getDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create render pass!");
@@ -21,6 +21,8 @@ namespace engine {
 		VkFramebuffer getFrameBuffer(int index) { return swapchainFramebuffers[index]; }
 		VkRenderPass getRenderPass() { return renderPass; }
 		VkImageView getImageView(int index) { return swapchainImageViews[index]; }
+		VkImage getImage(int index) { return swapchainImages[index]; }
+		bool supportsReadback() const { return readbackSupported; } // images can be copied from
 		size_t getImageCount() { return swapchainImages.size(); }
 		VkFormat getSwapchainImageFormat() { return swapchainImageFormat; }
 		VkExtent2D getSwapchainExtent() { return swapchainExtent; }
@@ -53,6 +55,7 @@ namespace engine {
 		VkFormat swapchainImageFormat;
 		VkFormat swapchainDepthFormat;
 		VkExtent2D swapchainExtent;
+		bool readbackSupported = false; // images were created with transfer source usage
 
 		std::vector<VkFramebuffer> swapchainFramebuffers; // a handle to hold the framebuffers
 		VkRenderPass renderPass; // a handle for the render pass
@@ -0,0 +1,258 @@
+#include "telemetry.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace engine {
+	static constexpr uint64_t REPORT_WINDOW_US = 1000000; // min/max/fps are computed over one second windows
+	static constexpr uint64_t MEMORY_SAMPLE_US = 500000; // memory usage changes slowly, so sample it twice a second
+	static constexpr float AVERAGE_WEIGHT = 0.05f; // weight of the newest frame in the moving average
+
+	static uint64_t nowMicroseconds() {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	static uint64_t currentProcessId() {
+#ifdef _WIN32
+		return static_cast<uint64_t>(GetCurrentProcessId());
+#else
+		return static_cast<uint64_t>(getpid());
+#endif
+	}
+
+	std::string telemetry::segmentName(uint64_t processId) {
+#ifdef _WIN32
+		return "Local\\UnnamedEngineTelemetry-" + std::to_string(processId);
+#else
+		return "/unnamedengine-telemetry-" + std::to_string(processId);
+#endif
+	}
+
+	// *************** Telemetry Writer *********************
+
+	telemetry::telemetry() : name{ segmentName(currentProcessId()) } {
+		void* memory = nullptr;
+
+#ifdef _WIN32
+		HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(TelemetryBlock), name.c_str());
+		if (mapping == nullptr) return; // telemetry is optional, run without it
+		memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(TelemetryBlock));
+		if (memory == nullptr) {
+			CloseHandle(mapping);
+			return;
+		}
+		mappingHandle = mapping;
+#else
+		int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+		if (fd < 0) return; // telemetry is optional, run without it
+		if (ftruncate(fd, sizeof(TelemetryBlock)) != 0) {
+			close(fd);
+			shm_unlink(name.c_str());
+			return;
+		}
+		memory = mmap(nullptr, sizeof(TelemetryBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd); // the mapping keeps the segment alive
+		if (memory == MAP_FAILED) {
+			shm_unlink(name.c_str());
+			return;
+		}
+		memoryStatsFile = open("/proc/self/statm", O_RDONLY);
+#endif
+
+		// fresh segments are zero filled, so only the header needs to be written; the magic goes last so readers never see a half initialized block
+		block = static_cast<TelemetryBlock*>(memory);
+		block->version = TelemetryBlock::VERSION;
+		block->processId = currentProcessId();
+		block->sequence.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		block->magic = TelemetryBlock::MAGIC;
+
+		startTime = nowMicroseconds();
+		windowStart = startTime;
+		sampleMemoryUsage();
+		publish(data);
+	}
+
+	telemetry::~telemetry() {
+		if (block == nullptr) return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(block);
+		CloseHandle(static_cast<HANDLE>(mappingHandle));
+#else
+		munmap(block, sizeof(TelemetryBlock));
+		shm_unlink(name.c_str());
+		if (memoryStatsFile >= 0) {
+			close(memoryStatsFile);
+		}
+#endif
+	}
+
+	void telemetry::recordFrame(float frameTime, uint32_t drawCount, uint32_t entityCount, uint32_t allocationCount) {
+		if (block == nullptr) return;
+
+		uint64_t now = nowMicroseconds();
+		float frameTimeMs = frameTime * 1000.f;
+
+		data.frameNumber++;
+		data.uptimeMicroseconds = now - startTime;
+		data.frameTimeMs = frameTimeMs;
+		data.frameTimeAvgMs = data.frameNumber == 1 ? frameTimeMs : data.frameTimeAvgMs + AVERAGE_WEIGHT * (frameTimeMs - data.frameTimeAvgMs);
+		data.drawCount = drawCount;
+		data.entityCount = entityCount;
+		data.frameAllocations = allocationCount;
+
+		// accumulate the reporting window and roll it over once it has covered a full second
+		windowMinMs = windowFrames == 0 ? frameTimeMs : std::min(windowMinMs, frameTimeMs);
+		windowMaxMs = windowFrames == 0 ? frameTimeMs : std::max(windowMaxMs, frameTimeMs);
+		windowFrames++;
+		if (now - windowStart >= REPORT_WINDOW_US) {
+			data.framesPerSecond = static_cast<float>(windowFrames) * 1e6f / static_cast<float>(now - windowStart);
+			data.frameTimeMinMs = windowMinMs;
+			data.frameTimeMaxMs = windowMaxMs;
+			windowStart = now;
+			windowFrames = 0;
+		}
+
+		if (now - lastMemorySample >= MEMORY_SAMPLE_US) {
+			sampleMemoryUsage();
+			lastMemorySample = now;
+		}
+
+		publish(data);
+	}
+
+	void telemetry::publish(const TelemetryData& snapshot) {
+		if (block == nullptr) return;
+
+		uint64_t words[TelemetryBlock::WORD_COUNT];
+		std::memcpy(words, &snapshot, sizeof(words));
+
+		// seqlock write: an odd sequence tells readers an update is in progress, the release store publishes the new words
+		uint32_t sequence = block->sequence.load(std::memory_order_relaxed);
+		block->sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (size_t i = 0; i < TelemetryBlock::WORD_COUNT; i++) {
+			block->words[i].store(words[i], std::memory_order_relaxed);
+		}
+		block->sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	void telemetry::sampleMemoryUsage() {
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters = {};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			data.residentBytes = counters.WorkingSetSize;
+			data.peakResidentBytes = counters.PeakWorkingSetSize;
+		}
+#else
+		// /proc/self/statm reports sizes in pages: total, resident, shared, ...
+		if (memoryStatsFile >= 0) {
+			char text[128] = {};
+			ssize_t length = pread(memoryStatsFile, text, sizeof(text) - 1, 0);
+			unsigned long long totalPages = 0, residentPages = 0;
+			if (length > 0 && sscanf(text, "%llu %llu", &totalPages, &residentPages) == 2) {
+				data.residentBytes = residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+			}
+		}
+
+		// ru_maxrss is reported in kilobytes on Linux
+		rusage usage = {};
+		if (getrusage(RUSAGE_SELF, &usage) == 0) {
+			data.peakResidentBytes = std::max(data.residentBytes, static_cast<uint64_t>(usage.ru_maxrss) * 1024);
+			if (memoryStatsFile < 0) {
+				data.residentBytes = data.peakResidentBytes;
+			}
+		}
+#endif
+	}
+
+	// *************** Telemetry Reader *********************
+
+	telemetryReader::telemetryReader(uint64_t processId) {
+		std::string name = telemetry::segmentName(processId);
+		const void* memory = nullptr;
+
+#ifdef _WIN32
+		HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+		if (mapping == nullptr) {
+			throw std::runtime_error("failed to open telemetry segment: " + name);
+		}
+		memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(TelemetryBlock));
+		if (memory == nullptr) {
+			CloseHandle(mapping);
+			throw std::runtime_error("failed to map telemetry segment: " + name);
+		}
+		mappingHandle = mapping;
+#else
+		int fd = shm_open(name.c_str(), O_RDONLY, 0);
+		if (fd < 0) {
+			throw std::runtime_error("failed to open telemetry segment: " + name);
+		}
+		memory = mmap(nullptr, sizeof(TelemetryBlock), PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (memory == MAP_FAILED) {
+			throw std::runtime_error("failed to map telemetry segment: " + name);
+		}
+#endif
+
+		block = static_cast<const TelemetryBlock*>(memory);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (block->magic != TelemetryBlock::MAGIC || block->version != TelemetryBlock::VERSION) {
+#ifdef _WIN32
+			UnmapViewOfFile(memory);
+			CloseHandle(mapping);
+#else
+			munmap(const_cast<void*>(memory), sizeof(TelemetryBlock));
+#endif
+			throw std::runtime_error("telemetry segment has an unknown layout: " + name);
+		}
+	}
+
+	telemetryReader::~telemetryReader() {
+		if (block == nullptr) return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(block);
+		CloseHandle(static_cast<HANDLE>(mappingHandle));
+#else
+		munmap(const_cast<TelemetryBlock*>(block), sizeof(TelemetryBlock));
+#endif
+		block = nullptr;
+	}
+
+	bool telemetryReader::read(TelemetryData& out) const {
+		uint64_t words[TelemetryBlock::WORD_COUNT];
+
+		// seqlock read: retry while the writer is mid-update or finished an update while we were copying
+		for (int attempt = 0; attempt < 64; attempt++) {
+			uint32_t before = block->sequence.load(std::memory_order_acquire);
+			if (before & 1) continue;
+
+			for (size_t i = 0; i < TelemetryBlock::WORD_COUNT; i++) {
+				words[i] = block->words[i].load(std::memory_order_relaxed);
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (block->sequence.load(std::memory_order_relaxed) == before) {
+				std::memcpy(&out, words, sizeof(out));
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace engine {
+	// plain snapshot of the engine statistics that get published every frame
+	struct TelemetryData {
+		uint64_t frameNumber = 0; // frames rendered since startup
+		uint64_t uptimeMicroseconds = 0; // time since the telemetry segment was created
+		float frameTimeMs = 0.f; // duration of the last frame
+		float frameTimeAvgMs = 0.f; // exponential moving average of the frame time
+		float frameTimeMinMs = 0.f; // shortest frame over the last reporting window
+		float frameTimeMaxMs = 0.f; // longest frame over the last reporting window
+		float framesPerSecond = 0.f; // frames completed over the last reporting window
+		uint32_t entityCount = 0; // entities in the scene
+		uint32_t drawCount = 0; // draw calls recorded in the last frame
+		uint32_t frameAllocations = 0; // heap allocations made during the last frame
+		uint64_t residentBytes = 0; // current resident set size of the process
+		uint64_t peakResidentBytes = 0; // peak resident set size of the process
+	};
+
+	// layout of the shared memory segment; data is guarded by a seqlock so the writer never waits on readers
+	struct TelemetryBlock {
+		static constexpr uint32_t MAGIC = 0x4d4c4554; // "TELM"
+		static constexpr uint32_t VERSION = 2;
+		static constexpr size_t WORD_COUNT = sizeof(TelemetryData) / sizeof(uint64_t);
+
+		uint32_t magic; // identifies the segment, written last during creation
+		uint32_t version; // layout version, bumped whenever TelemetryData changes
+		uint64_t processId; // process that owns the segment
+		std::atomic<uint32_t> sequence; // odd while the writer is updating the data words
+		std::atomic<uint64_t> words[WORD_COUNT]; // TelemetryData stored as relaxed atomic words
+	};
+
+	static_assert(std::is_trivially_copyable<TelemetryData>::value, "TelemetryData must be trivially copyable");
+	static_assert(sizeof(TelemetryData) % sizeof(uint64_t) == 0, "TelemetryData must be a whole number of words");
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "telemetry requires lock-free 64 bit atomics");
+
+	// publishes engine statistics into a named shared memory segment for external monitoring tools
+	class telemetry {
+	public:
+		telemetry(); // constructor, creates the segment for the current process
+		~telemetry(); // destructor, unmaps and removes the segment
+
+		// not copyable or movable
+		telemetry(const telemetry&) = delete;
+		telemetry& operator = (const telemetry&) = delete;
+
+		bool isEnabled() const { return block != nullptr; } // false if the segment could not be created
+		void recordFrame(float frameTime, uint32_t drawCount, uint32_t entityCount, uint32_t allocationCount); // update the frame statistics and publish them
+		void publish(const TelemetryData& data); // write a snapshot into the segment, never blocks
+
+		static std::string segmentName(uint64_t processId); // name of the segment for a given process
+
+	private:
+		void sampleMemoryUsage(); // refresh the resident memory statistics
+
+		TelemetryBlock* block = nullptr; // a handle for the mapped segment
+		void* mappingHandle = nullptr; // platform specific handle for the mapping
+		int memoryStatsFile = -1; // kept open so sampling memory is a single read
+		std::string name; // name of the segment
+		TelemetryData data = {}; // statistics that are accumulated between publishes
+		uint64_t startTime = 0; // time the segment was created, in microseconds
+		uint64_t windowStart = 0; // start of the current reporting window, in microseconds
+		uint64_t lastMemorySample = 0; // time memory usage was last sampled, in microseconds
+		uint32_t windowFrames = 0; // frames counted in the current reporting window
+		float windowMinMs = 0.f; // shortest frame in the current reporting window
+		float windowMaxMs = 0.f; // longest frame in the current reporting window
+	};
+
+	// read side of the telemetry segment, used by external tools
+	class telemetryReader {
+	public:
+		telemetryReader(uint64_t processId); // constructor, opens an existing segment read-only
+		~telemetryReader(); // destructor
+
+		// not copyable or movable
+		telemetryReader(const telemetryReader&) = delete;
+		telemetryReader& operator = (const telemetryReader&) = delete;
+
+		bool read(TelemetryData& out) const; // take a consistent snapshot, returns false if the writer kept racing us
+
+	private:
+		const TelemetryBlock* block = nullptr; // a handle for the mapped segment
+		void* mappingHandle = nullptr; // platform specific handle for the mapping
+	};
+}
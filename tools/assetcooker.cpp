@@ -0,0 +1,123 @@
+// asset pack cooker; parses OBJ models into the engine's vertex layout and bundles them with SPIR-V and any other files
+// into one pack for assetPack to map at startup. Each asset is stored under the name the engine asks for, which is the
+// path as given unless it's prefixed with <name>=, e.g. simple_shader.vert.spv=build/shaders/simple_shader.vert.spv
+// .obj files become MESH assets, ENCODED_MESH with --encode or PROGRESSIVE_MESH with up to n levels with --progressive,
+// anything else is stored as is; --mantissa-bits rounds the vertex floats first so encoded meshes shrink further,
+// trading precision. --list prints the contents of a pack
+// usage: assetcooker [--encode | --progressive <levels>] [--mantissa-bits <n>] <output pack> [<name>=]<file>... | assetcooker --list <pack>
+#include "../assetpack.hpp"
+#include "../assetreader.hpp"
+#include "../meshcodec.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+	bool isModel(const std::string& filepath) {
+		return filepath.size() >= 4 && filepath.compare(filepath.size() - 4, 4, ".obj") == 0;
+	}
+
+	void list(const std::string& filepath) {
+		engine::assetPack pack{ filepath };
+		for (const std::string& name : pack.names()) {
+			engine::assetPack::Asset asset = *pack.find(name);
+			const char* type = "raw         ";
+			if (asset.type == engine::assetPack::AssetType::MESH) type = "mesh        ";
+			else if (asset.type == engine::assetPack::AssetType::ENCODED_MESH) type = "encoded     ";
+			else if (asset.type == engine::assetPack::AssetType::PROGRESSIVE_MESH) type = "progressive ";
+			std::cout << type << asset.size << '\t' << name << '\n';
+		}
+		pack.report(std::cout);
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc == 3 && std::strcmp(argv[1], "--list") == 0) {
+		try {
+			list(argv[2]);
+		}
+		catch (const std::exception& e) {
+			std::cerr << e.what() << '\n';
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	bool encode = false;
+	uint32_t progressiveLevels = 0;
+	uint32_t mantissaBits = 23;
+	int first = 1;
+	for (; first < argc && argv[first][0] == '-'; first++) {
+		if (std::strcmp(argv[first], "--encode") == 0) encode = true;
+		else if (std::strcmp(argv[first], "--progressive") == 0 && first + 1 < argc) progressiveLevels = static_cast<uint32_t>(std::atoi(argv[++first]));
+		else if (std::strcmp(argv[first], "--mantissa-bits") == 0 && first + 1 < argc) mantissaBits = static_cast<uint32_t>(std::atoi(argv[++first]));
+		else break;
+	}
+	if (argc - first < 2 || argv[first][0] == '-' || (encode && progressiveLevels > 0)) {
+		std::cerr << "usage: " << argv[0] << " [--encode | --progressive <levels>] [--mantissa-bits <n>] <output pack> [<name>=]<file>... | " << argv[0] << " --list <pack>" << '\n';
+		return EXIT_FAILURE;
+	}
+	const char* outputPath = argv[first];
+
+	try {
+		std::vector<engine::assetPack::Source> sources = {};
+		uint64_t meshCount = 0;
+		uint64_t meshBytes = 0; // meshes at full size
+		uint64_t storedMeshBytes = 0;
+		uint64_t totalBytes = 0;
+		for (int i = first + 1; i < argc; i++) {
+			std::string argument = argv[i];
+			size_t separator = argument.find('=');
+			std::string filepath = separator == std::string::npos ? argument : argument.substr(separator + 1);
+
+			engine::assetPack::Source source = {};
+			source.name = separator == std::string::npos ? argument : argument.substr(0, separator);
+			std::vector<char> bytes = engine::assetReader::readFileBlocking(filepath);
+			if (isModel(filepath)) {
+				engine::model::Builder builderInstance = {};
+				builderInstance.loadModelFromMemory(bytes, filepath);
+				engine::meshCodec::quantize(reinterpret_cast<float*>(builderInstance.vertices.data()), builderInstance.vertices.size() * sizeof(engine::model::Vertex) / sizeof(float), mantissaBits);
+				if (progressiveLevels > 0) {
+					source.type = engine::assetPack::AssetType::PROGRESSIVE_MESH;
+					source.data = engine::assetPack::cookProgressiveMesh(builderInstance, progressiveLevels);
+					engine::assetPack::ProgressiveMeshHeader progressiveHeader = {};
+					engine::model::ProgressiveLevel coarsest = {};
+					std::memcpy(&progressiveHeader, source.data.data(), sizeof(progressiveHeader));
+					std::memcpy(&coarsest, source.data.data() + sizeof(progressiveHeader), sizeof(coarsest));
+					size_t coarsestBytes = coarsest.vertexCount * sizeof(engine::model::Vertex) + coarsest.indexCount * sizeof(uint32_t);
+					std::cout << source.name << ": " << progressiveHeader.levelCount << " level(s), the coarsest has " << coarsest.indexCount / 3 << " of " << builderInstance.indices.size() / 3
+						<< " triangles in " << 100.0 * static_cast<double>(coarsestBytes) / static_cast<double>(source.data.size()) << "% of the bytes" << '\n';
+				}
+				else {
+					source.type = encode ? engine::assetPack::AssetType::ENCODED_MESH : engine::assetPack::AssetType::MESH;
+					source.data = encode ? engine::assetPack::cookEncodedMesh(builderInstance) : engine::assetPack::cookMesh(builderInstance);
+				}
+				meshCount++;
+				meshBytes += builderInstance.vertices.size() * sizeof(engine::model::Vertex) + builderInstance.indices.size() * sizeof(uint32_t);
+				storedMeshBytes += source.data.size();
+			}
+			else {
+				source.data = std::move(bytes);
+			}
+			totalBytes += source.data.size();
+			sources.push_back(std::move(source));
+		}
+
+		size_t assetCount = sources.size();
+		engine::assetPack::write(outputPath, std::move(sources));
+		std::cout << "cooked " << assetCount << " asset(s), " << meshCount << " mesh(es), " << totalBytes << " bytes into " << outputPath << '\n';
+		if (meshBytes > 0) {
+			std::cout << "meshes: " << meshBytes << " bytes at full size, " << storedMeshBytes << " stored, ratio " << static_cast<double>(meshBytes) / static_cast<double>(storedMeshBytes) << ":1" << '\n';
+		}
+	}
+
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,176 @@
+// replays a frame capture recorded with --capture, isolating command recording and GPU work from the simulation
+// renders offscreen at the captured resolution; run from the directory holding the compiled shaders
+// usage: capturereplay <capture file> [--iterations <n>] [--warmup <n>] [--json <path>]
+#include "../benchmark.hpp"
+#include "../buffer.hpp"
+#include "../descriptors.hpp"
+#include "../device.hpp"
+#include "../framecapture.hpp"
+#include "../frameinfo.hpp"
+#include "../offscreenrenderer.hpp"
+#include "../pointlightsystem.hpp"
+#include "../rendersystem.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cerr << "usage: " << argv[0] << " <capture file> [--iterations <n>] [--warmup <n>] [--json <path>]" << '\n';
+		return EXIT_FAILURE;
+	}
+
+	uint32_t iterations = 100;
+	uint32_t warmupIterations = 5;
+	std::string jsonPath = {};
+	for (int i = 2; i < argc; i++) {
+		if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) iterations = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) warmupIterations = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) jsonPath = argv[++i];
+		else {
+			std::cerr << "usage: " << argv[0] << " <capture file> [--iterations <n>] [--warmup <n>] [--json <path>]" << '\n';
+			return EXIT_FAILURE;
+		}
+	}
+
+	try {
+		using clock = std::chrono::steady_clock;
+		engine::CaptureFile captureInstance = engine::frameCapture::load(argv[1]);
+		if (captureInstance.frames.empty()) {
+			throw std::runtime_error("capture holds no complete frames");
+		}
+
+		engine::device deviceInstance = {};
+		engine::offscreenRenderer rendererInstance{ deviceInstance, captureInstance.extent };
+
+		auto globalPool = engine::descriptorPool::Builder(deviceInstance).setMaxSets(engine::swapchain::MAX_FRAMES_IN_FLIGHT).addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, engine::swapchain::MAX_FRAMES_IN_FLIGHT).build();
+		auto globalSetLayout = engine::descriptorSetLayout::Builder(deviceInstance).addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS).build();
+		engine::rendersystem renderSystem{ deviceInstance, rendererInstance.getRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+		engine::pointlightsystem pointLightSystem{ deviceInstance, rendererInstance.getRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+
+		std::vector<std::unique_ptr<engine::buffer>> uboBuffers(engine::swapchain::MAX_FRAMES_IN_FLIGHT);
+		std::vector<VkDescriptorSet> globalDescriptorSets(engine::swapchain::MAX_FRAMES_IN_FLIGHT);
+		for (size_t i = 0; i < uboBuffers.size(); i++) {
+			uboBuffers[i] = std::make_unique<engine::buffer>(deviceInstance, sizeof(engine::GlobalUbo), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			uboBuffers[i]->map();
+			auto bufferInfo = uboBuffers[i]->descriptorInfo();
+			engine::descriptorWriter(*globalSetLayout, *globalPool).writeBuffer(0, &bufferInfo).build(globalDescriptorSets[i]);
+		}
+
+		std::vector<std::unique_ptr<engine::model>> models = {};
+		uint64_t drawsPerPass = 0;
+		for (const auto& mesh : captureInstance.meshes) {
+			models.push_back(std::make_unique<engine::model>(deviceInstance, mesh));
+		}
+		for (const auto& frame : captureInstance.frames) {
+			for (const auto& command : frame.commands) {
+				if (command.type == engine::CaptureCommand::Type::DRAW_MODEL || command.type == engine::CaptureCommand::Type::DRAW_SUBMESH || command.type == engine::CaptureCommand::Type::DRAW) drawsPerPass++;
+			}
+		}
+
+		// one sample per replayed frame; the command streams are decoded up front so only Vulkan calls are timed
+		std::vector<double> cpuSamples = {};
+		uint64_t replayedFrames = 0;
+		for (uint32_t iteration = 0; iteration < warmupIterations + iterations; iteration++) {
+			for (const auto& frame : captureInstance.frames) {
+				VkCommandBuffer commandBuffer = rendererInstance.beginFrame();
+				auto recordStart = clock::now();
+
+				int frameIndex = rendererInstance.getFrameIndex();
+				engine::GlobalUbo ubo = frame.ubo;
+				uboBuffers[frameIndex]->writeToBuffer(&ubo);
+				uboBuffers[frameIndex]->flush();
+
+				rendererInstance.beginRenderPass(commandBuffer);
+				VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+				for (const auto& command : frame.commands) {
+					switch (command.type) {
+					case engine::CaptureCommand::Type::BIND_SYSTEM:
+						if (static_cast<engine::CaptureSystem>(command.args[0]) == engine::CaptureSystem::POINT_LIGHTS) {
+							pointLightSystem.bind(commandBuffer, globalDescriptorSets[frameIndex]);
+							pipelineLayout = pointLightSystem.getPipelineLayout();
+						}
+						else {
+							renderSystem.bind(commandBuffer, globalDescriptorSets[frameIndex]);
+							pipelineLayout = renderSystem.getPipelineLayout();
+						}
+						break;
+					case engine::CaptureCommand::Type::PUSH_CONSTANTS:
+						vkCmdPushConstants(commandBuffer, pipelineLayout, command.args[0], command.args[1], command.args[2], frame.pushData.data() + command.args[3]);
+						break;
+					case engine::CaptureCommand::Type::BIND_MODEL:
+						models[command.args[0]]->bind(commandBuffer);
+						break;
+					case engine::CaptureCommand::Type::DRAW_MODEL:
+						models[command.args[0]]->draw(commandBuffer);
+						break;
+					case engine::CaptureCommand::Type::DRAW_SUBMESH: {
+						engine::model::Submesh submesh = {};
+						submesh.firstIndex = command.args[1];
+						submesh.indexCount = command.args[2];
+						models[command.args[0]]->drawSubmesh(commandBuffer, submesh);
+						break;
+					}
+					case engine::CaptureCommand::Type::DRAW:
+						vkCmdDraw(commandBuffer, command.args[0], command.args[1], command.args[2], command.args[3]);
+						break;
+					}
+				}
+				rendererInstance.endRenderPass(commandBuffer);
+				rendererInstance.endFrame();
+
+				if (iteration >= warmupIterations) {
+					cpuSamples.push_back(std::chrono::duration<double, std::milli>(clock::now() - recordStart).count());
+				}
+				replayedFrames++;
+			}
+		}
+		rendererInstance.finish();
+
+		engine::benchmarkSuite suite{ "capturereplay" };
+		suite.setContext("capture", argv[1]);
+		suite.setContext("device", deviceInstance.deviceProperties.deviceName);
+		suite.setContext("frames_per_pass", std::to_string(captureInstance.frames.size()));
+		suite.setContext("draws_per_pass", std::to_string(drawsPerPass));
+		suite.setContext("meshes", std::to_string(captureInstance.meshes.size()));
+		suite.setContext("resolution", std::to_string(captureInstance.extent.width) + "x" + std::to_string(captureInstance.extent.height));
+		suite.setContext("iterations", std::to_string(iterations));
+
+		// recording and submitting a captured frame, excluding the wait for a free frame slot
+		engine::BenchmarkResult cpuResult = {};
+		cpuResult.name = "replay.cpu";
+		cpuResult.unit = "ms";
+		cpuResult.samples = std::move(cpuSamples);
+		suite.addResult(std::move(cpuResult));
+
+		const auto& gpuFrameTimes = rendererInstance.getGpuFrameTimes();
+		size_t warmupFrames = static_cast<size_t>(warmupIterations) * captureInstance.frames.size();
+		if (gpuFrameTimes.size() > warmupFrames) {
+			engine::BenchmarkResult gpuResult = {};
+			gpuResult.name = "replay.gpu";
+			gpuResult.unit = "ms";
+			gpuResult.samples.assign(gpuFrameTimes.begin() + warmupFrames, gpuFrameTimes.end());
+			suite.addResult(std::move(gpuResult));
+		}
+		else {
+			std::cout << "timestamp queries unsupported, GPU times not reported" << std::endl;
+		}
+
+		std::cout << "replayed " << replayedFrames << " frames" << std::endl;
+		suite.printSummary(std::cout);
+		if (!jsonPath.empty()) {
+			suite.writeJson(jsonPath);
+		}
+	}
+
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+// headless CPU rendering benchmark; renders the same generated scene and camera orbit as framebench with cpuRasterizer,
+// without touching Vulkan, and reports frame times per pass; where there is no Vulkan loader to link, build it with
+// ENGINE_NULL_VULKAN (nullvulkan.cpp) since the image writer shares a file with the GPU readback
+// to compare against a software Vulkan driver, run framebench on lavapipe with the same scene settings and compare the files:
+//   VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json framebench --json lavapipe.json
+//   cpurender --json cpu.json
+//   perfcompare lavapipe.json cpu.json --filter frame.interval
+// usage: cpurender [--entities <n>] [--meshes <n>] [--depth <n>] [--seed <n>] [--frames <n>] [--warmup <n>] [--width <px>] [--height <px>] [--threads <n>] [--output <image>] [--json <path>]
+#include "../benchmark.hpp"
+#include "../camera.hpp"
+#include "../cpurasterizer.hpp"
+#include "../framereadback.hpp"
+#include "../scenegenerator.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+int main(int argc, char** argv) {
+	engine::SceneSettings sceneSettings = {};
+	uint32_t frameCount = 500;
+	uint32_t warmupFrames = 50;
+	uint32_t width = 1280;
+	uint32_t height = 720;
+	uint32_t threadCount = 0;
+	std::string outputPath = {};
+	std::string jsonPath = {};
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--entities") == 0 && i + 1 < argc) sceneSettings.entityCount = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--meshes") == 0 && i + 1 < argc) sceneSettings.meshCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--depth") == 0 && i + 1 < argc) sceneSettings.hierarchyDepth = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) sceneSettings.seed = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frameCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) warmupFrames = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--width") == 0 && i + 1 < argc) width = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--height") == 0 && i + 1 < argc) height = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) outputPath = argv[++i];
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) jsonPath = argv[++i];
+		else {
+			std::cerr << "usage: " << argv[0] << " [--entities <n>] [--meshes <n>] [--depth <n>] [--seed <n>] [--frames <n>] [--warmup <n>] [--width <px>] [--height <px>] [--threads <n>] [--output <image>] [--json <path>]" << '\n';
+			return EXIT_FAILURE;
+		}
+	}
+	if (const char* reason = engine::sceneGenerator::validate(sceneSettings)) {
+		std::cerr << "usage: " << reason << " (--entities, --meshes)" << '\n';
+		return EXIT_FAILURE;
+	}
+
+	try {
+		using clock = std::chrono::steady_clock;
+		engine::cpuRasterizer rasterizerInstance{ width, height, threadCount };
+
+		// the scene's hierarchy is resolved once, as createEntities would, and drawn directly without entities or GPU models
+		engine::Scene scene = engine::sceneGenerator::generate(sceneSettings);
+		for (const auto& mesh : scene.meshes) {
+			rasterizerInstance.addMesh(mesh);
+		}
+		std::vector<engine::TransformComponent> transforms = engine::sceneGenerator::worldTransforms(scene.nodes);
+		std::vector<engine::cpuRasterizer::Draw> draws(scene.nodes.size());
+		for (size_t i = 0; i < draws.size(); i++) {
+			draws[i].mesh = scene.nodes[i].mesh;
+			draws[i].modelMatrix = transforms[i].mat4();
+			draws[i].normalMatrix = transforms[i].normalMatrix();
+		}
+
+		engine::camera cameraInstance = {};
+		cameraInstance.setPerspectiveProjection(glm::radians(50.f), static_cast<float>(width) / static_cast<float>(height), 0.1f, 1000.f);
+
+		// same orbit as framebench, so both draw the same images frame for frame
+		constexpr float FRAME_TIME = 1.f / 60.f;
+		float radius = 0.5f * sceneSettings.spacing * std::sqrt(static_cast<float>(sceneSettings.entityCount)) + 3.f;
+		std::vector<double> intervalSamples = {};
+		std::vector<double> vertexSamples = {};
+		std::vector<double> binSamples = {};
+		std::vector<double> rasterSamples = {};
+		for (uint32_t frame = 0; frame < warmupFrames + frameCount; frame++) {
+			auto frameStart = clock::now();
+
+			float orbit = FRAME_TIME * static_cast<float>(frame) * 0.25f;
+			cameraInstance.setViewTarget(glm::vec3{ radius * std::cos(orbit), -0.5f * radius, radius * std::sin(orbit) }, glm::vec3{ 0.f });
+
+			engine::GlobalUbo ubo = {};
+			ubo.projection = cameraInstance.getProjection();
+			ubo.view = cameraInstance.getView();
+			if (!scene.lights.empty()) {
+				ubo.lightPosition = scene.lights[0].position;
+				ubo.lightColor = scene.lights[0].color;
+			}
+			rasterizerInstance.render(ubo, draws);
+
+			if (frame >= warmupFrames) {
+				const auto& stats = rasterizerInstance.getStats();
+				intervalSamples.push_back(std::chrono::duration<double, std::milli>(clock::now() - frameStart).count());
+				vertexSamples.push_back(stats.vertexMilliseconds);
+				binSamples.push_back(stats.binMilliseconds);
+				rasterSamples.push_back(stats.rasterMilliseconds);
+			}
+		}
+
+		engine::benchmarkSuite suite{ "cpurender" };
+		suite.setContext("device", "cpuRasterizer");
+		suite.setContext("threads", std::to_string(rasterizerInstance.getThreadCount()));
+		suite.setContext("hardware_threads", std::to_string(std::thread::hardware_concurrency()));
+		suite.setContext("entities", std::to_string(sceneSettings.entityCount));
+		suite.setContext("meshes", std::to_string(sceneSettings.meshCount));
+		suite.setContext("hierarchy_depth", std::to_string(sceneSettings.hierarchyDepth));
+		suite.setContext("seed", std::to_string(sceneSettings.seed));
+		suite.setContext("draws_per_frame", std::to_string(draws.size()));
+		suite.setContext("triangles_binned", std::to_string(rasterizerInstance.getStats().trianglesBinned));
+		suite.setContext("resolution", std::to_string(width) + "x" + std::to_string(height));
+		suite.setContext("frames", std::to_string(frameCount));
+
+		// a whole frame; named like framebench's start-to-start interval so the two can be compared directly
+		engine::BenchmarkResult intervalResult = {};
+		intervalResult.name = "frame.interval";
+		intervalResult.unit = "ms";
+		intervalResult.samples = std::move(intervalSamples);
+		suite.addResult(std::move(intervalResult));
+
+		engine::BenchmarkResult vertexResult = {};
+		vertexResult.name = "frame.vertex";
+		vertexResult.unit = "ms";
+		vertexResult.samples = std::move(vertexSamples);
+		suite.addResult(std::move(vertexResult));
+
+		engine::BenchmarkResult binResult = {};
+		binResult.name = "frame.bin";
+		binResult.unit = "ms";
+		binResult.samples = std::move(binSamples);
+		suite.addResult(std::move(binResult));
+
+		engine::BenchmarkResult rasterResult = {};
+		rasterResult.name = "frame.raster";
+		rasterResult.unit = "ms";
+		rasterResult.samples = std::move(rasterSamples);
+		suite.addResult(std::move(rasterResult));
+
+		suite.printSummary(std::cout);
+		if (!outputPath.empty()) {
+			engine::frameReadback::writeImage(outputPath, width, height, rasterizerInstance.getColor().data());
+		}
+		if (!jsonPath.empty()) {
+			suite.writeJson(jsonPath);
+		}
+	}
+
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
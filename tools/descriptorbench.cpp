@@ -0,0 +1,334 @@
+// descriptor update benchmark; writes a set of material-like descriptor sets (global uniforms, per-material uniforms and a
+// texture) every way the engine can and reports nanoseconds per set, so the paths can be compared on any driver
+// the per_draw results record one small set per draw into a command buffer, pushed where VK_KHR_push_descriptor is available
+// and allocated from a per-frame pool and bound otherwise
+// the churn results rewrite every set into per-frame memory each frame, from a per-frame pool or, where VK_EXT_descriptor_buffer
+// is available, straight into a descriptor buffer from one thread and from several
+// runs without a GPU on a software driver, e.g. VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json
+// usage: descriptorbench [--sets <n>] [--threads <n>] [--samples <n>] [--filter <substring>] [--json <path>]
+#include "../benchmark.hpp"
+#include "../buffer.hpp"
+#include "../descriptors.hpp"
+#include "../device.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	// per-material uniforms, the kind of data that changes from one material set to the next
+	struct MaterialUniforms {
+		float baseColor[4];
+		float roughness;
+		float metallic;
+		float padding[2];
+	};
+
+	// a 1x1 texture to point the image descriptors at; nothing is ever sampled, so its contents don't matter
+	struct Texture {
+		engine::device& deviceInstance;
+		VkImage image = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		VkSampler sampler = VK_NULL_HANDLE;
+
+		Texture(engine::device& deviceInstance) : deviceInstance{ deviceInstance } {
+			VkImageCreateInfo imageInfo = {};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+			imageInfo.extent = { 1, 1, 1 };
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			deviceInstance.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+
+			VkImageViewCreateInfo viewInfo = {};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.image = image;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+			viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			if (vkCreateImageView(deviceInstance.getDevice(), &viewInfo, nullptr, &view) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create texture image view!");
+			}
+
+			VkSamplerCreateInfo samplerInfo = {};
+			samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+			samplerInfo.magFilter = VK_FILTER_LINEAR;
+			samplerInfo.minFilter = VK_FILTER_LINEAR;
+			samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			samplerInfo.maxLod = 1.f;
+			if (vkCreateSampler(deviceInstance.getDevice(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create texture sampler!");
+			}
+		}
+
+		~Texture() {
+			vkDestroySampler(deviceInstance.getDevice(), sampler, nullptr);
+			vkDestroyImageView(deviceInstance.getDevice(), view, nullptr);
+			vkDestroyImage(deviceInstance.getDevice(), image, nullptr);
+			vkFreeMemory(deviceInstance.getDevice(), memory, nullptr);
+		}
+	};
+}
+
+int main(int argc, char** argv) {
+	uint32_t setCount = 10000;
+	uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	std::string jsonPath = {};
+	std::string filter = {};
+	engine::benchmarkSuite::Options options = {};
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--sets") == 0 && i + 1 < argc) setCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc) options.sampleCount = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) jsonPath = argv[++i];
+		else {
+			std::cerr << "usage: " << argv[0] << " [--sets <n>] [--threads <n>] [--samples <n>] [--filter <substring>] [--json <path>]" << '\n';
+			return EXIT_FAILURE;
+		}
+	}
+	if (setCount == 0) setCount = 1;
+	if (threadCount == 0) threadCount = 1;
+
+	try {
+		engine::device deviceInstance = {};
+		auto setLayout = engine::descriptorSetLayout::Builder(deviceInstance)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.build();
+		auto allocator = engine::descriptorAllocator::Builder(deviceInstance).setSetsPerPool(1024).addPoolRatio(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f).addPoolRatio(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.f).setFrameCount(1).build();
+
+		engine::buffer globalUniforms{ deviceInstance, 256, 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT };
+		engine::buffer materialUniforms{ deviceInstance, sizeof(MaterialUniforms), setCount, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, deviceInstance.deviceProperties.limits.minUniformBufferOffsetAlignment };
+		Texture texture{ deviceInstance };
+
+		// every set gets its own material range, the rest is shared
+		std::vector<VkDescriptorSet> sets(setCount);
+		std::vector<VkDescriptorBufferInfo> materialInfos(setCount);
+		for (uint32_t i = 0; i < setCount; i++) {
+			sets[i] = allocator->allocate(setLayout->getDescriptorSetLayout());
+			materialInfos[i] = materialUniforms.descriptorInfoForIndex(static_cast<int>(i));
+		}
+		VkDescriptorBufferInfo globalInfo = globalUniforms.descriptorInfo(256); // descriptor buffers need explicit ranges
+		VkDescriptorImageInfo imageInfo{ texture.sampler, texture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+		engine::benchmarkSuite suite{ "descriptorbench", options };
+		suite.setContext("device", deviceInstance.deviceProperties.deviceName);
+		suite.setContext("sets", std::to_string(setCount));
+		suite.setContext("update_templates", setLayout->hasUpdateTemplate() ? "yes" : "no");
+		auto enabled = [&filter](const char* name) { return filter.empty() || std::strstr(name, filter.c_str()) != nullptr; };
+
+		// what the engine did so far: a writer per set, its writes handed to vkUpdateDescriptorSets
+		if (enabled("descriptors.update.writes")) {
+			suite.run("descriptors.update.writes", setCount, [&]() {
+				for (uint32_t i = 0; i < setCount; i++) {
+					engine::descriptorWriter(*setLayout, *allocator).useUpdateTemplate(false).writeBuffer(0, &globalInfo).writeBuffer(1, &materialInfos[i]).writeImage(2, &imageInfo).overwrite(sets[i]);
+				}
+			});
+		}
+
+		// the best case for plain writes: every set's writes prepared up front and submitted in one call
+		if (enabled("descriptors.update.writes_batched")) {
+			std::vector<VkWriteDescriptorSet> writes(3 * static_cast<size_t>(setCount));
+			for (uint32_t i = 0; i < setCount; i++) {
+				for (uint32_t binding = 0; binding < 3; binding++) {
+					VkWriteDescriptorSet& write = writes[3 * i + binding];
+					write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+					write.dstSet = sets[i];
+					write.dstBinding = binding;
+					write.descriptorCount = 1;
+					write.descriptorType = binding == 2 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+					write.pBufferInfo = binding == 0 ? &globalInfo : &materialInfos[i];
+					write.pImageInfo = &imageInfo;
+				}
+			}
+			suite.run("descriptors.update.writes_batched", setCount, [&]() {
+				vkUpdateDescriptorSets(deviceInstance.getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+			});
+		}
+
+		if (setLayout->hasUpdateTemplate()) {
+			// the same writer, now turning its writes into one template update per set
+			if (enabled("descriptors.update.template")) {
+				suite.run("descriptors.update.template", setCount, [&]() {
+					for (uint32_t i = 0; i < setCount; i++) {
+						engine::descriptorWriter(*setLayout, *allocator).writeBuffer(0, &globalInfo).writeBuffer(1, &materialInfos[i]).writeImage(2, &imageInfo).overwrite(sets[i]);
+					}
+				});
+			}
+
+			// the floor: data already packed in template order, e.g. kept that way by a material system
+			if (enabled("descriptors.update.template_packed")) {
+				uint32_t stride = setLayout->getDescriptorCount();
+				std::vector<engine::DescriptorInfo> packed(static_cast<size_t>(stride) * setCount);
+				for (uint32_t i = 0; i < setCount; i++) {
+					packed[stride * i + setLayout->getDescriptorOffset(0)].buffer = globalInfo;
+					packed[stride * i + setLayout->getDescriptorOffset(1)].buffer = materialInfos[i];
+					packed[stride * i + setLayout->getDescriptorOffset(2)].image = imageInfo;
+				}
+				suite.run("descriptors.update.template_packed", setCount, [&]() {
+					for (uint32_t i = 0; i < setCount; i++) {
+						setLayout->updateWithTemplate(sets[i], &packed[static_cast<size_t>(stride) * i]);
+					}
+				});
+			}
+		}
+		else {
+			std::cerr << "the device doesn't support Vulkan 1.1, skipping the update template results" << '\n';
+		}
+
+		// descriptor churn: one frame's sets taken from per-frame memory and written from scratch, then the frame is reset
+		if (enabled("descriptors.churn.frame_pool")) {
+			suite.run("descriptors.churn.frame_pool", setCount, [&]() {
+				allocator->resetFrame(0);
+				for (uint32_t i = 0; i < setCount; i++) {
+					VkDescriptorSet set = allocator->allocateFrame(0, setLayout->getDescriptorSetLayout());
+					engine::descriptorWriter(*setLayout, *allocator).writeBuffer(0, &globalInfo).writeBuffer(1, &materialInfos[i]).writeImage(2, &imageInfo).overwrite(set);
+				}
+			});
+		}
+
+		// the same bindings with their sets kept in a descriptor buffer, sized for one frame of them
+		auto bufferLayout = engine::descriptorSetLayout::Builder(deviceInstance)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.setDescriptorBuffer()
+			.build();
+		std::unique_ptr<engine::descriptorBuffer> setBuffer = {};
+		suite.setContext("descriptor_buffers", bufferLayout->isDescriptorBuffer() ? "yes" : "no");
+		if (bufferLayout->isDescriptorBuffer()) {
+			VkDeviceSize setBytes = bufferLayout->getDescriptorBufferSize() + deviceInstance.descriptorBufferProperties.descriptorBufferOffsetAlignment;
+			setBuffer = engine::descriptorBuffer::Builder(deviceInstance).setPersistentSize(0).setFrameSize(setBytes * setCount).setFrameCount(1).build();
+			suite.setContext("descriptor_buffer_set_bytes", std::to_string(bufferLayout->getDescriptorBufferSize()));
+			suite.setContext("threads", std::to_string(threadCount));
+
+			auto writeSets = [&](uint32_t first, uint32_t last) {
+				for (uint32_t i = first; i < last; i++) {
+					VkDeviceSize offset = setBuffer->allocateFrame(0, *bufferLayout);
+					engine::descriptorWriter(*bufferLayout).writeBuffer(0, &globalInfo).writeBuffer(1, &materialInfos[i]).writeImage(2, &imageInfo).write(*setBuffer, offset);
+				}
+			};
+			if (enabled("descriptors.churn.descriptor_buffer")) {
+				suite.run("descriptors.churn.descriptor_buffer", setCount, [&]() {
+					setBuffer->resetFrame(0);
+					writeSets(0, setCount);
+				});
+			}
+
+			// workers only share the frame region's atomic offset; starting them is part of the measured time
+			if (threadCount > 1 && enabled("descriptors.churn.descriptor_buffer_threaded")) {
+				suite.run("descriptors.churn.descriptor_buffer_threaded", setCount, [&]() {
+					setBuffer->resetFrame(0);
+					std::vector<std::thread> workers = {};
+					for (uint32_t t = 0; t < threadCount; t++) {
+						uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(setCount) * t / threadCount);
+						uint32_t last = static_cast<uint32_t>(static_cast<uint64_t>(setCount) * (t + 1) / threadCount);
+						workers.emplace_back(writeSets, first, last);
+					}
+					for (auto& worker : workers) {
+						worker.join();
+					}
+				});
+			}
+		}
+		else {
+			std::cerr << "the device doesn't support VK_EXT_descriptor_buffer, skipping the descriptor buffer results" << '\n';
+		}
+
+		// per-draw resources, the same bindings once as a push descriptor layout and once as a regular one
+		auto pushLayout = engine::descriptorSetLayout::Builder(deviceInstance)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.setPushDescriptor()
+			.build();
+		auto poolLayout = engine::descriptorSetLayout::Builder(deviceInstance)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.build();
+		auto frameAllocator = engine::descriptorAllocator::Builder(deviceInstance).setSetsPerPool(1024).addPoolRatio(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.f).addPoolRatio(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.f).setFrameCount(1).build();
+		suite.setContext("push_descriptors", pushLayout->isPushDescriptor() ? "yes" : "no");
+
+		VkCommandBufferAllocateInfo commandBufferInfo = {};
+		commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		commandBufferInfo.commandPool = deviceInstance.getCommandPool();
+		commandBufferInfo.commandBufferCount = 1;
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		if (vkAllocateCommandBuffers(deviceInstance.getDevice(), &commandBufferInfo, &commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate command buffer!");
+		}
+
+		// one frame's worth of draws; nothing is submitted, beginning the command buffer again resets it
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		auto recordDraws = [&](engine::descriptorSetLayout& layout) {
+			VkPipelineLayout pipelineLayout = deviceInstance.getLayoutCache().getPipelineLayout({ layout.getDescriptorSetLayout() }, {});
+			vkBeginCommandBuffer(commandBuffer, &beginInfo);
+			frameAllocator->resetFrame(0);
+			for (uint32_t i = 0; i < setCount; i++) {
+				engine::descriptorWriter(layout, *frameAllocator).writeBuffer(0, &materialInfos[i]).writeImage(1, &imageInfo).push(commandBuffer, pipelineLayout, 0, 0);
+			}
+			vkEndCommandBuffer(commandBuffer);
+		};
+		if (pushLayout->isPushDescriptor() && enabled("descriptors.per_draw.push")) {
+			suite.run("descriptors.per_draw.push", setCount, [&]() { recordDraws(*pushLayout); });
+		}
+		if (enabled("descriptors.per_draw.frame_pool")) {
+			suite.run("descriptors.per_draw.frame_pool", setCount, [&]() { recordDraws(*poolLayout); });
+		}
+
+		// each draw's set written into the descriptor buffer, which is bound once, and selected by its offset
+		if (setBuffer != nullptr && enabled("descriptors.per_draw.descriptor_buffer")) {
+			auto drawLayout = engine::descriptorSetLayout::Builder(deviceInstance)
+				.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+				.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.setDescriptorBuffer()
+				.build();
+			VkPipelineLayout pipelineLayout = deviceInstance.getLayoutCache().getPipelineLayout({ drawLayout->getDescriptorSetLayout() }, {});
+			suite.run("descriptors.per_draw.descriptor_buffer", setCount, [&]() {
+				vkBeginCommandBuffer(commandBuffer, &beginInfo);
+				setBuffer->resetFrame(0);
+				setBuffer->bind(commandBuffer);
+				for (uint32_t i = 0; i < setCount; i++) {
+					VkDeviceSize offset = setBuffer->allocateFrame(0, *drawLayout);
+					engine::descriptorWriter(*drawLayout).writeBuffer(0, &materialInfos[i]).writeImage(1, &imageInfo).write(*setBuffer, offset);
+					setBuffer->setOffset(commandBuffer, pipelineLayout, 0, offset);
+				}
+				vkEndCommandBuffer(commandBuffer);
+			});
+		}
+		vkFreeCommandBuffers(deviceInstance.getDevice(), deviceInstance.getCommandPool(), 1, &commandBuffer);
+
+		suite.printSummary(std::cout);
+		allocator->report(std::cout);
+		frameAllocator->report(std::cout);
+		if (setBuffer != nullptr) setBuffer->report(std::cout);
+		if (!jsonPath.empty()) {
+			suite.writeJson(jsonPath);
+		}
+	}
+
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
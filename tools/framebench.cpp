@@ -0,0 +1,183 @@
+// headless end-to-end frame benchmark; renders a generated scene offscreen and reports CPU and GPU frame times
+// runs without a GPU on a software driver, e.g. VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json
+// run from the directory holding the compiled shaders; --static draws the scene from staticBatcher chunks instead of per entity
+// usage: framebench [--entities <n>] [--meshes <n>] [--depth <n>] [--seed <n>] [--static] [--frames <n>] [--warmup <n>] [--width <px>] [--height <px>] [--json <path>]
+#include "../benchmark.hpp"
+#include "../buffer.hpp"
+#include "../camera.hpp"
+#include "../descriptors.hpp"
+#include "../device.hpp"
+#include "../entity.hpp"
+#include "../framearena.hpp"
+#include "../frameinfo.hpp"
+#include "../offscreenrenderer.hpp"
+#include "../pointlightsystem.hpp"
+#include "../rendersystem.hpp"
+#include "../scenegenerator.hpp"
+#include "../staticbatcher.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char** argv) {
+	engine::SceneSettings sceneSettings = {};
+	uint32_t frameCount = 500;
+	uint32_t warmupFrames = 50;
+	VkExtent2D extent{ 1280, 720 };
+	std::string jsonPath = {};
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--entities") == 0 && i + 1 < argc) sceneSettings.entityCount = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--meshes") == 0 && i + 1 < argc) sceneSettings.meshCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--depth") == 0 && i + 1 < argc) sceneSettings.hierarchyDepth = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) sceneSettings.seed = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--static") == 0) sceneSettings.staticEntities = true;
+		else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frameCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) warmupFrames = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--width") == 0 && i + 1 < argc) extent.width = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--height") == 0 && i + 1 < argc) extent.height = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) jsonPath = argv[++i];
+		else {
+			std::cerr << "usage: " << argv[0] << " [--entities <n>] [--meshes <n>] [--depth <n>] [--seed <n>] [--static] [--frames <n>] [--warmup <n>] [--width <px>] [--height <px>] [--json <path>]" << '\n';
+			return EXIT_FAILURE;
+		}
+	}
+	if (const char* reason = engine::sceneGenerator::validate(sceneSettings)) {
+		std::cerr << "usage: " << reason << " (--entities, --meshes)" << '\n';
+		return EXIT_FAILURE;
+	}
+
+	try {
+		using clock = std::chrono::steady_clock;
+		engine::device deviceInstance = {};
+		engine::offscreenRenderer rendererInstance{ deviceInstance, extent };
+		engine::frameArena frameArenaInstance = {};
+
+		auto globalPool = engine::descriptorPool::Builder(deviceInstance).setMaxSets(engine::swapchain::MAX_FRAMES_IN_FLIGHT).addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, engine::swapchain::MAX_FRAMES_IN_FLIGHT).build();
+		auto globalSetLayout = engine::descriptorSetLayout::Builder(deviceInstance).addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS).build();
+		engine::rendersystem renderSystem{ deviceInstance, rendererInstance.getRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+		engine::pointlightsystem pointLightSystem{ deviceInstance, rendererInstance.getRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+
+		std::vector<std::unique_ptr<engine::buffer>> uboBuffers(engine::swapchain::MAX_FRAMES_IN_FLIGHT);
+		std::vector<VkDescriptorSet> globalDescriptorSets(engine::swapchain::MAX_FRAMES_IN_FLIGHT);
+		for (size_t i = 0; i < uboBuffers.size(); i++) {
+			uboBuffers[i] = std::make_unique<engine::buffer>(deviceInstance, sizeof(engine::GlobalUbo), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			uboBuffers[i]->map();
+			auto bufferInfo = uboBuffers[i]->descriptorInfo();
+			engine::descriptorWriter(*globalSetLayout, *globalPool).writeBuffer(0, &bufferInfo).build(globalDescriptorSets[i]);
+		}
+
+		engine::Scene scene = engine::sceneGenerator::generate(sceneSettings);
+		std::vector<std::shared_ptr<engine::model>> models = {};
+		for (auto& mesh : scene.meshes) {
+			models.push_back(std::make_shared<engine::model>(deviceInstance, mesh));
+		}
+		engine::entity::Map gameEntities = {};
+		engine::sceneGenerator::createEntities(scene.nodes, models, gameEntities);
+		engine::staticBatcher staticBatcherInstance{ deviceInstance };
+		if (sceneSettings.staticEntities) {
+			for (auto& kv : gameEntities) kv.second.isStatic = true;
+			staticBatcherInstance.update(gameEntities);
+			staticBatcherInstance.report(std::cout);
+		}
+		engine::camera cameraInstance = {};
+		cameraInstance.setPerspectiveProjection(glm::radians(50.f), rendererInstance.getAspectRatio(), 0.1f, 1000.f);
+
+		// frame times depend only on the frame number, never on wall time, so every run draws the same images
+		constexpr float FRAME_TIME = 1.f / 60.f;
+		float radius = 0.5f * sceneSettings.spacing * std::sqrt(static_cast<float>(sceneSettings.entityCount)) + 3.f;
+		std::vector<double> cpuSamples = {};
+		std::vector<double> wallSamples = {};
+		uint32_t drawCount = 0;
+		auto previousStart = clock::now();
+		for (uint32_t frame = 0; frame < warmupFrames + frameCount; frame++) {
+			auto frameStart = clock::now();
+			VkCommandBuffer commandBuffer = rendererInstance.beginFrame();
+			auto recordStart = clock::now();
+
+			float orbit = FRAME_TIME * static_cast<float>(frame) * 0.25f;
+			cameraInstance.setViewTarget(glm::vec3{ radius * std::cos(orbit), -0.5f * radius, radius * std::sin(orbit) }, glm::vec3{ 0.f });
+
+			int frameIndex = rendererInstance.getFrameIndex();
+			frameArenaInstance.beginFrame(frameIndex);
+			engine::GlobalUbo ubo = {};
+			ubo.projection = cameraInstance.getProjection();
+			ubo.view = cameraInstance.getView();
+			if (!scene.lights.empty()) {
+				ubo.lightPosition = scene.lights[0].position;
+				ubo.lightColor = scene.lights[0].color;
+			}
+			uboBuffers[frameIndex]->writeToBuffer(&ubo);
+			uboBuffers[frameIndex]->flush();
+
+			engine::FrameInfo frameInfo{ frameIndex, FRAME_TIME, commandBuffer, cameraInstance, globalDescriptorSets[frameIndex], gameEntities, frameArenaInstance, nullptr, nullptr, sceneSettings.staticEntities ? &staticBatcherInstance : nullptr };
+			rendererInstance.beginRenderPass(commandBuffer);
+			drawCount = renderSystem.renderEntities(frameInfo);
+			drawCount += pointLightSystem.render(frameInfo);
+			rendererInstance.endRenderPass(commandBuffer);
+			rendererInstance.endFrame();
+			auto frameEnd = clock::now();
+
+			if (frame >= warmupFrames) {
+				cpuSamples.push_back(std::chrono::duration<double, std::milli>(frameEnd - recordStart).count());
+				if (frame > warmupFrames) wallSamples.push_back(std::chrono::duration<double, std::milli>(frameStart - previousStart).count());
+			}
+			previousStart = frameStart;
+		}
+		rendererInstance.finish();
+
+		engine::benchmarkSuite suite{ "framebench" };
+		suite.setContext("device", deviceInstance.deviceProperties.deviceName);
+		suite.setContext("driver_version", std::to_string(deviceInstance.deviceProperties.driverVersion));
+		suite.setContext("entities", std::to_string(sceneSettings.entityCount));
+		suite.setContext("meshes", std::to_string(sceneSettings.meshCount));
+		suite.setContext("hierarchy_depth", std::to_string(sceneSettings.hierarchyDepth));
+		suite.setContext("seed", std::to_string(sceneSettings.seed));
+		suite.setContext("static", sceneSettings.staticEntities ? "true" : "false");
+		suite.setContext("draws_per_frame", std::to_string(drawCount));
+		suite.setContext("resolution", std::to_string(extent.width) + "x" + std::to_string(extent.height));
+		suite.setContext("frames", std::to_string(frameCount));
+
+		// time spent recording and submitting, excluding the wait for a free frame slot
+		engine::BenchmarkResult cpuResult = {};
+		cpuResult.name = "frame.cpu";
+		cpuResult.unit = "ms";
+		cpuResult.samples = std::move(cpuSamples);
+		suite.addResult(std::move(cpuResult));
+
+		// start-to-start interval, bounded by whichever of the CPU or GPU is slower
+		engine::BenchmarkResult wallResult = {};
+		wallResult.name = "frame.interval";
+		wallResult.unit = "ms";
+		wallResult.samples = std::move(wallSamples);
+		suite.addResult(std::move(wallResult));
+
+		// one GPU time per submitted frame, in order, so the warm-up frames are simply the first entries
+		const auto& gpuFrameTimes = rendererInstance.getGpuFrameTimes();
+		if (gpuFrameTimes.size() > warmupFrames) {
+			engine::BenchmarkResult gpuResult = {};
+			gpuResult.name = "frame.gpu";
+			gpuResult.unit = "ms";
+			gpuResult.samples.assign(gpuFrameTimes.begin() + warmupFrames, gpuFrameTimes.end());
+			suite.addResult(std::move(gpuResult));
+		}
+		else {
+			std::cout << "timestamp queries unsupported, GPU times not reported" << std::endl;
+		}
+
+		suite.printSummary(std::cout);
+		if (!jsonPath.empty()) {
+			suite.writeJson(jsonPath);
+		}
+	}
+
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+// asset read benchmark; reads the same set of files sequentially with std::ifstream (what the loaders did), through the
+// thread pool backend and through io_uring, and reports the time per set and per file; the median throughput and file rate
+// of each method are written to the context, since results are times that perfcompare treats lower as better
+// by default every run starts cold: the files are dropped from the page cache with posix_fadvise, which needs no privileges
+// but only evicts pages nobody else has mapped; --warm skips that to measure the cached path
+// usage: iobench <file list or directory> [--iterations <n>] [--queue-depth <n>] [--threads <n>] [--warm] [--json <path>]
+#include "../assetreader.hpp"
+#include "../benchmark.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	// a directory is scanned recursively, anything else is a text file with one path per line
+	std::vector<std::string> collectFiles(const std::string& path) {
+		std::vector<std::string> files = {};
+		if (std::filesystem::is_directory(path)) {
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+				if (entry.is_regular_file()) files.push_back(entry.path().string());
+			}
+			return files;
+		}
+
+		std::ifstream list{ path };
+		if (!list.is_open()) {
+			throw std::runtime_error("failed to open file list: " + path);
+		}
+		std::string line;
+		while (std::getline(list, line)) {
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			if (!line.empty()) files.push_back(line);
+		}
+		return files;
+	}
+
+	void evict(const std::vector<std::string>& files) {
+#if defined(__unix__)
+		for (const auto& filepath : files) {
+			int fd = ::open(filepath.c_str(), O_RDONLY);
+			if (fd < 0) continue;
+			::fdatasync(fd);
+			::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+			::close(fd);
+		}
+#else
+		(void)files;
+#endif
+	}
+
+	// the loaders' old path: open, seek to the end for the size, read through the stream buffer
+	uint64_t readSequential(const std::vector<std::string>& files) {
+		uint64_t total = 0;
+		for (const auto& filepath : files) {
+			std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
+			if (!file.is_open()) {
+				throw std::runtime_error("failed to open file: " + filepath);
+			}
+			std::vector<char> data(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(data.data(), static_cast<std::streamsize>(data.size()));
+			total += static_cast<uint64_t>(file.gcount());
+		}
+		return total;
+	}
+
+	// every file queued at once, then collected in order
+	uint64_t readAsync(engine::assetReader& readerInstance, const std::vector<std::string>& files) {
+		std::vector<std::future<std::vector<char>>> reads = {};
+		reads.reserve(files.size());
+		for (const auto& filepath : files) {
+			reads.push_back(readerInstance.readFile(filepath));
+		}
+		uint64_t total = 0;
+		for (auto& read : reads) {
+			total += read.get().size();
+		}
+		return total;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::string inputPath = {};
+	uint32_t iterations = 10;
+	uint32_t queueDepth = 64;
+	uint32_t threadCount = 4;
+	bool warm = false;
+	std::string jsonPath = {};
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) iterations = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--queue-depth") == 0 && i + 1 < argc) queueDepth = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--warm") == 0) warm = true;
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) jsonPath = argv[++i];
+		else if (argv[i][0] != '-' && inputPath.empty()) inputPath = argv[i];
+		else {
+			inputPath.clear();
+			break;
+		}
+	}
+	if (inputPath.empty()) {
+		std::cerr << "usage: " << argv[0] << " <file list or directory> [--iterations <n>] [--queue-depth <n>] [--threads <n>] [--warm] [--json <path>]" << '\n';
+		return EXIT_FAILURE;
+	}
+
+	try {
+		using clock = std::chrono::steady_clock;
+		std::vector<std::string> files = collectFiles(inputPath);
+		if (files.empty()) {
+			throw std::runtime_error("no files to read in " + inputPath);
+		}
+		uint64_t setBytes = 0;
+		for (const auto& filepath : files) {
+			setBytes += engine::assetReader::fileSize(filepath);
+		}
+
+		engine::assetReader poolReader{ queueDepth, threadCount, engine::assetReader::Backend::THREAD_POOL };
+		engine::assetReader ringReader{ queueDepth, threadCount, engine::assetReader::Backend::IO_URING };
+		if (ringReader.getBackend() != engine::assetReader::Backend::IO_URING) {
+			std::cerr << "io_uring is unavailable, its results are the thread pool's" << '\n';
+		}
+
+		engine::benchmarkSuite suite{ "iobench" };
+		suite.setContext("files", std::to_string(files.size()));
+		suite.setContext("set_bytes", std::to_string(setBytes));
+		suite.setContext("cache", warm ? "warm" : "cold");
+		suite.setContext("queue_depth", std::to_string(queueDepth));
+		suite.setContext("threads", std::to_string(threadCount));
+
+		struct Method {
+			const char* name;
+			engine::assetReader* readerInstance; // null for the sequential streams
+		};
+		const Method methods[] = { { "ifstream", nullptr }, { "thread_pool", &poolReader }, { "io_uring", &ringReader } };
+		for (const Method& method : methods) {
+			std::vector<double> setSamples = {};
+			std::vector<double> fileSamples = {};
+			for (uint32_t iteration = 0; iteration < std::max(iterations, 1u); iteration++) {
+				if (!warm) evict(files);
+				else if (iteration == 0) readSequential(files); // fill the cache once before the first timed run
+
+				auto start = clock::now();
+				uint64_t bytes = method.readerInstance ? readAsync(*method.readerInstance, files) : readSequential(files);
+				double seconds = std::chrono::duration<double>(clock::now() - start).count();
+				if (bytes != setBytes) {
+					throw std::runtime_error(std::string{ method.name } + " read " + std::to_string(bytes) + " of " + std::to_string(setBytes) + " bytes");
+				}
+
+				setSamples.push_back(seconds * 1000.0);
+				fileSamples.push_back(seconds * 1000.0 / static_cast<double>(files.size()));
+			}
+
+			std::vector<double> sorted = setSamples;
+			std::sort(sorted.begin(), sorted.end());
+			double medianSeconds = sorted[sorted.size() / 2] / 1000.0;
+			suite.setContext(std::string{ method.name } + "_mib_per_second", std::to_string(static_cast<double>(setBytes) / (1024.0 * 1024.0) / medianSeconds));
+			suite.setContext(std::string{ method.name } + "_files_per_second", std::to_string(static_cast<double>(files.size()) / medianSeconds));
+
+			engine::BenchmarkResult setResult = {};
+			setResult.name = std::string{ "read." } + method.name;
+			setResult.unit = "ms";
+			setResult.samples = std::move(setSamples);
+			suite.addResult(std::move(setResult));
+
+			engine::BenchmarkResult fileResult = {};
+			fileResult.name = std::string{ "read." } + method.name + ".per_file";
+			fileResult.unit = "ms";
+			fileResult.samples = std::move(fileSamples);
+			suite.addResult(std::move(fileResult));
+		}
+
+		suite.printSummary(std::cout);
+		poolReader.report(std::cout);
+		ringReader.report(std::cout);
+		if (!jsonPath.empty()) {
+			suite.writeJson(jsonPath);
+		}
+	}
+
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
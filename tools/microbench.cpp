@@ -0,0 +1,225 @@
+// CPU micro-benchmarks for engine hot paths; needs no GPU or display, so it can run on every commit
+// usage: microbench [--json <path>] [--samples <n>] [--filter <substring>]
+#include "../benchmark.hpp"
+#include "../camera.hpp"
+#include "../entity.hpp"
+#include "../meshcodec.hpp"
+#include "../model.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+	constexpr size_t BATCH = 1024; // items processed per timed call
+
+	// write a grid mesh as an OBJ file; every interior vertex is shared by six triangles, so dedup has real work to do
+	std::string writeGridObj(int resolution) {
+		auto filepath = std::filesystem::temp_directory_path() / ("microbench_grid_" + std::to_string(resolution) + ".obj");
+		std::ofstream file{ filepath };
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to write benchmark model: " + filepath.string());
+		}
+
+		for (int z = 0; z <= resolution; z++) {
+			for (int x = 0; x <= resolution; x++) {
+				float u = static_cast<float>(x) / resolution;
+				float v = static_cast<float>(z) / resolution;
+				file << "v " << u << " " << 0.1f * std::sin(u * 12.f) * std::cos(v * 9.f) << " " << v << " " << u << " " << v << " 0.5\n";
+				file << "vt " << u << " " << v << "\n";
+			}
+		}
+		file << "vn 0 1 0\n";
+
+		auto index = [resolution](int x, int z) { return z * (resolution + 1) + x + 1; };
+		for (int z = 0; z < resolution; z++) {
+			for (int x = 0; x < resolution; x++) {
+				int a = index(x, z), b = index(x + 1, z), c = index(x + 1, z + 1), d = index(x, z + 1);
+				file << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 " << c << "/" << c << "/1\n";
+				file << "f " << a << "/" << a << "/1 " << c << "/" << c << "/1 " << d << "/" << d << "/1\n";
+			}
+		}
+
+		return filepath.string();
+	}
+
+	std::vector<engine::TransformComponent> randomTransforms(size_t count, std::mt19937& rng) {
+		std::uniform_real_distribution<float> position{ -50.f, 50.f };
+		std::uniform_real_distribution<float> angle{ -3.14f, 3.14f };
+		std::uniform_real_distribution<float> scale{ 0.1f, 4.f };
+		std::vector<engine::TransformComponent> transforms(count);
+		for (auto& transform : transforms) {
+			transform.translation = { position(rng), position(rng), position(rng) };
+			transform.rotation = { angle(rng), angle(rng), angle(rng) };
+			transform.scale = { scale(rng), scale(rng), scale(rng) };
+		}
+		return transforms;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::string jsonPath = {};
+	std::string filter = {};
+	engine::benchmarkSuite::Options options = {};
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) jsonPath = argv[++i];
+		else if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc) options.sampleCount = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+		else {
+			std::cerr << "usage: " << argv[0] << " [--json <path>] [--samples <n>] [--filter <substring>]" << '\n';
+			return EXIT_FAILURE;
+		}
+	}
+
+	try {
+		engine::benchmarkSuite suite{ "microbench", options };
+		auto enabled = [&filter](const char* name) { return filter.empty() || std::strstr(name, filter.c_str()) != nullptr; };
+		std::mt19937 rng{ 1234 }; // fixed seed so every run measures the same inputs
+
+		// transform matrices, as computed per entity per frame by rendersystem
+		auto transforms = randomTransforms(BATCH, rng);
+		if (enabled("transform.mat4")) {
+			suite.run("transform.mat4", BATCH, [&]() {
+				for (auto& transform : transforms) engine::doNotOptimize(transform.mat4());
+			});
+		}
+		if (enabled("transform.normalMatrix")) {
+			suite.run("transform.normalMatrix", BATCH, [&]() {
+				for (auto& transform : transforms) engine::doNotOptimize(transform.normalMatrix());
+			});
+		}
+
+		// camera updates, done once per frame but cheap enough to batch
+		engine::camera cameraInstance = {};
+		if (enabled("camera.setViewYXZ")) {
+			suite.run("camera.setViewYXZ", BATCH, [&]() {
+				for (auto& transform : transforms) {
+					cameraInstance.setViewYXZ(transform.translation, transform.rotation);
+					engine::doNotOptimize(cameraInstance.getView());
+				}
+			});
+		}
+		if (enabled("camera.setPerspectiveProjection")) {
+			suite.run("camera.setPerspectiveProjection", BATCH, [&]() {
+				for (auto& transform : transforms) {
+					cameraInstance.setPerspectiveProjection(glm::radians(50.f), transform.scale.x, 0.1f, 100.f);
+					engine::doNotOptimize(cameraInstance.getProjection());
+				}
+			});
+		}
+
+		// vertex hashing and deduplication from model::Builder::loadModel
+		std::string gridPath = writeGridObj(128);
+		engine::model::Builder grid = {};
+		grid.loadModel(gridPath);
+		std::vector<engine::model::Vertex> expanded = {};
+		expanded.reserve(grid.indices.size());
+		for (uint32_t index : grid.indices) {
+			expanded.push_back(grid.vertices[index]);
+		}
+
+		if (enabled("vertex.hashCombine")) {
+			std::hash<engine::model::Vertex> hasher = {};
+			suite.run("vertex.hashCombine", BATCH, [&]() {
+				for (size_t i = 0; i < BATCH; i++) engine::doNotOptimize(hasher(expanded[i]));
+			});
+		}
+		if (enabled("vertex.dedup")) {
+			suite.run("vertex.dedup", expanded.size(), [&]() {
+				std::unordered_map<engine::model::Vertex, uint32_t> uniqueVertices = {};
+				std::vector<uint32_t> indices = {};
+				uint32_t next = 0;
+				for (const auto& vertex : expanded) {
+					auto inserted = uniqueVertices.emplace(vertex, next);
+					if (inserted.second) next++;
+					indices.push_back(inserted.first->second);
+				}
+				engine::doNotOptimize(indices.data());
+			});
+		}
+		if (enabled("model.loadModel")) {
+			suite.run("model.loadModel.grid128", grid.indices.size(), [&]() {
+				engine::model::Builder builderInstance = {};
+				builderInstance.loadModel(gridPath);
+				engine::doNotOptimize(builderInstance.vertices.data());
+			});
+		}
+		std::filesystem::remove(gridPath);
+
+		// the cooked mesh codec, timed per decoded byte; ratio and throughput go to the context since results are times
+		if (enabled("meshcodec")) {
+			const uint32_t vertexTotal = static_cast<uint32_t>(grid.vertices.size());
+			const uint32_t indexTotal = static_cast<uint32_t>(grid.indices.size());
+			std::vector<char> vertexData = engine::meshCodec::encodeVertices(grid.vertices.data(), vertexTotal, sizeof(engine::model::Vertex));
+			std::vector<char> indexData = engine::meshCodec::encodeIndices(grid.indices.data(), indexTotal);
+			std::vector<engine::model::Vertex> vertices(vertexTotal);
+			std::vector<uint32_t> indices(indexTotal);
+			const size_t vertexBytes = vertices.size() * sizeof(engine::model::Vertex);
+			const size_t indexBytes = indices.size() * sizeof(uint32_t);
+
+			suite.run("meshcodec.decodeVertices.grid128", vertexBytes, [&]() {
+				engine::meshCodec::decodeVertices(vertices.data(), vertexTotal, sizeof(engine::model::Vertex), vertexData.data(), vertexData.size());
+				engine::doNotOptimize(vertices.data());
+			});
+			suite.run("meshcodec.decodeIndices.grid128", indexBytes, [&]() {
+				engine::meshCodec::decodeIndices(indices.data(), indexTotal, indexData.data(), indexData.size());
+				engine::doNotOptimize(indices.data());
+			});
+			if (std::memcmp(vertices.data(), grid.vertices.data(), vertexBytes) != 0 || indices != grid.indices) {
+				throw std::runtime_error("mesh codec round trip changed the grid");
+			}
+
+			// nanoseconds per byte to gigabytes per second is one over the median
+			auto gigabytesPerSecond = [&suite](const char* name) {
+				for (const auto& result : suite.getResults()) {
+					if (result.name == name) return 1.0 / engine::BenchmarkStats::compute(result.samples).median;
+				}
+				return 0.0;
+			};
+			double vertexRatio = static_cast<double>(vertexBytes) / static_cast<double>(vertexData.size());
+			double indexRatio = static_cast<double>(indexBytes) / static_cast<double>(indexData.size());
+			double vertexRate = gigabytesPerSecond("meshcodec.decodeVertices.grid128");
+			double indexRate = gigabytesPerSecond("meshcodec.decodeIndices.grid128");
+			suite.setContext("meshcodec_vertex_ratio", std::to_string(vertexRatio));
+			suite.setContext("meshcodec_index_ratio", std::to_string(indexRatio));
+			suite.setContext("meshcodec_vertex_decode_gb_per_second", std::to_string(vertexRate));
+			suite.setContext("meshcodec_index_decode_gb_per_second", std::to_string(indexRate));
+			std::cout << "mesh codec: vertices " << vertexRatio << ":1 decoded at " << vertexRate << " GB/s, indices " << indexRatio << ":1 decoded at " << indexRate << " GB/s" << '\n';
+		}
+
+		// iteration over the entity map, the outer loop of every render system
+		if (enabled("entity.map.iterate")) {
+			constexpr size_t ENTITY_COUNT = 10000;
+			auto entityTransforms = randomTransforms(ENTITY_COUNT, rng);
+			engine::entity::Map entities = {};
+			for (auto& transform : entityTransforms) {
+				auto entityInstance = engine::entity::createEntity();
+				entityInstance.transform = transform;
+				entities.emplace(entityInstance.getId(), std::move(entityInstance));
+			}
+			suite.run("entity.map.iterate", ENTITY_COUNT, [&]() {
+				glm::vec3 sum{ 0.f };
+				for (auto& kv : entities) sum += kv.second.transform.translation;
+				engine::doNotOptimize(sum);
+			});
+		}
+
+		suite.printSummary(std::cout);
+		if (!jsonPath.empty()) {
+			suite.writeJson(jsonPath);
+		}
+	}
+
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
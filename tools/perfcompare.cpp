@@ -0,0 +1,112 @@
+// compares two benchmark result files written by benchmarkSuite (microbench, framebench, flythrough) and flags regressions
+// exits with 1 when any result got slower beyond the threshold, 2 when the inputs can't be read, 0 otherwise
+// usage: perfcompare <baseline.json> <candidate.json> [--threshold <percent>] [--alpha <p>] [--filter <substring>]
+#include "../benchmark.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+	const char* verdictName(engine::BenchmarkComparison::Verdict verdict) {
+		switch (verdict) {
+		case engine::BenchmarkComparison::Verdict::REGRESSION: return "REGRESSION";
+		case engine::BenchmarkComparison::Verdict::IMPROVEMENT: return "improvement";
+		default: return "";
+		}
+	}
+
+	const engine::BenchmarkResult* findResult(const engine::benchmarkSuite& suite, const std::string& name) {
+		for (const auto& result : suite.getResults()) {
+			if (result.name == name) return &result;
+		}
+		return nullptr;
+	}
+
+	// results are only comparable when taken on the same device and scene, so point out any difference in how the runs were set up
+	void printContextDifferences(const engine::benchmarkSuite& baseline, const engine::benchmarkSuite& candidate) {
+		for (const auto& entry : baseline.getContext()) {
+			for (const auto& other : candidate.getContext()) {
+				if (entry.first == other.first && entry.second != other.second) {
+					std::cout << "note: " << entry.first << " differs: " << entry.second << " -> " << other.second << '\n';
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr << "usage: " << argv[0] << " <baseline.json> <candidate.json> [--threshold <percent>] [--alpha <p>] [--filter <substring>]" << '\n';
+		return 2;
+	}
+
+	double threshold = 0.05;
+	double alpha = 0.01;
+	std::string filter = {};
+	for (int i = 3; i < argc; i++) {
+		if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) threshold = std::atof(argv[++i]) / 100.0;
+		else if (std::strcmp(argv[i], "--alpha") == 0 && i + 1 < argc) alpha = std::atof(argv[++i]);
+		else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+		else {
+			std::cerr << "usage: " << argv[0] << " <baseline.json> <candidate.json> [--threshold <percent>] [--alpha <p>] [--filter <substring>]" << '\n';
+			return 2;
+		}
+	}
+
+	try {
+		engine::benchmarkSuite baseline = engine::benchmarkSuite::readJson(argv[1]);
+		engine::benchmarkSuite candidate = engine::benchmarkSuite::readJson(argv[2]);
+		if (baseline.getName() != candidate.getName()) {
+			std::cout << "note: comparing suite " << baseline.getName() << " against " << candidate.getName() << '\n';
+		}
+		printContextDifferences(baseline, candidate);
+
+		std::cout << std::left << std::setw(40) << "benchmark" << std::right
+			<< std::setw(14) << "baseline" << std::setw(14) << "candidate" << std::setw(10) << "change" << std::setw(10) << "p" << "  unit" << std::endl;
+
+		uint32_t regressions = 0;
+		uint32_t improvements = 0;
+		for (const auto& result : candidate.getResults()) {
+			if (!filter.empty() && result.name.find(filter) == std::string::npos) continue;
+			const engine::BenchmarkResult* previous = findResult(baseline, result.name);
+			if (previous == nullptr) {
+				std::cout << std::left << std::setw(40) << result.name << "  new, no baseline" << std::endl;
+				continue;
+			}
+			if (previous->unit != result.unit) {
+				std::cout << std::left << std::setw(40) << result.name << "  unit changed from " << previous->unit << " to " << result.unit << ", skipped" << std::endl;
+				continue;
+			}
+
+			auto comparison = engine::BenchmarkComparison::compare(*previous, result, threshold, alpha);
+			if (comparison.verdict == engine::BenchmarkComparison::Verdict::REGRESSION) regressions++;
+			if (comparison.verdict == engine::BenchmarkComparison::Verdict::IMPROVEMENT) improvements++;
+
+			std::cout << std::left << std::setw(40) << result.name << std::right << std::fixed << std::setprecision(3)
+				<< std::setw(14) << comparison.baselineMedian << std::setw(14) << comparison.candidateMedian
+				<< std::setw(9) << std::showpos << comparison.change * 100.0 << std::noshowpos << "%";
+			if (std::isnan(comparison.pValue)) std::cout << std::setw(10) << "n/a";
+			else std::cout << std::setw(10) << std::setprecision(4) << comparison.pValue;
+			std::cout << "  " << std::left << std::setw(4) << result.unit << "  " << verdictName(comparison.verdict) << std::endl;
+		}
+
+		for (const auto& result : baseline.getResults()) {
+			if (!filter.empty() && result.name.find(filter) == std::string::npos) continue;
+			if (findResult(candidate, result.name) == nullptr) {
+				std::cout << std::left << std::setw(40) << result.name << "  missing from candidate" << std::endl;
+			}
+		}
+
+		std::cout << std::defaultfloat << regressions << " regression(s), " << improvements << " improvement(s) beyond " << threshold * 100.0 << "% at alpha " << alpha << std::endl;
+		return regressions > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return 2;
+	}
+}
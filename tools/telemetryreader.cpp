@@ -0,0 +1,69 @@
+// command line monitor for a running engine instance; reads the telemetry segment published by engine::telemetry
+// usage: telemetryreader <pid> [--interval <ms>] [--once]
+#include "../telemetry.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+static void printSnapshot(const engine::TelemetryData& data) {
+	std::cout << std::fixed << std::setprecision(2)
+		<< "frame " << data.frameNumber
+		<< "  uptime " << static_cast<double>(data.uptimeMicroseconds) / 1e6 << "s"
+		<< "  fps " << data.framesPerSecond
+		<< "  frame " << data.frameTimeMs << "ms"
+		<< " (avg " << data.frameTimeAvgMs << " min " << data.frameTimeMinMs << " max " << data.frameTimeMaxMs << ")"
+		<< "  entities " << data.entityCount
+		<< "  draws " << data.drawCount
+		<< "  allocs " << data.frameAllocations
+		<< "  rss " << static_cast<double>(data.residentBytes) / (1024.0 * 1024.0) << "MiB"
+		<< " (peak " << static_cast<double>(data.peakResidentBytes) / (1024.0 * 1024.0) << "MiB)"
+		<< std::endl;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cerr << "usage: " << argv[0] << " <pid> [--interval <ms>] [--once]" << '\n';
+		return EXIT_FAILURE;
+	}
+
+	uint64_t processId = std::strtoull(argv[1], nullptr, 10);
+	int intervalMs = 1000;
+	bool once = false;
+	for (int i = 2; i < argc; i++) {
+		if (std::strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+			intervalMs = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--once") == 0) {
+			once = true;
+		}
+	}
+
+	try {
+		engine::telemetryReader reader{ processId };
+		engine::TelemetryData data = {};
+
+		do {
+			if (reader.read(data)) {
+				printSnapshot(data);
+			}
+			else {
+				std::cerr << "writer busy, skipping sample" << '\n';
+			}
+
+			if (!once) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+			}
+		} while (!once);
+	}
+
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
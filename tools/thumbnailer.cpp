@@ -0,0 +1,297 @@
+// batch thumbnail renderer; renders every model of a list from evenly spaced viewpoints around it, offscreen and without a window
+// parsing runs ahead on loader threads, many renders are kept in flight and the images are encoded on worker threads,
+// so the throughput is bounded by whichever of the three is slowest. Reports images per second
+// the model list holds one OBJ path per line, blank lines and lines starting with # are skipped
+// run from the directory holding the compiled shaders
+// usage: thumbnailer <model list> [--out <dir>] [--size <px>] [--views <n>] [--elevation <degrees>] [--in-flight <n>] [--loaders <n>] [--encoders <n>] [--format png|ppm] [--json <path>]
+#include "../benchmark.hpp"
+#include "../buffer.hpp"
+#include "../camera.hpp"
+#include "../descriptors.hpp"
+#include "../device.hpp"
+#include "../entity.hpp"
+#include "../framearena.hpp"
+#include "../frameinfo.hpp"
+#include "../framereadback.hpp"
+#include "../offscreenrenderer.hpp"
+#include "../rendersystem.hpp"
+#include "../startupprofiler.hpp"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	// a parsed model, or the reason it couldn't be parsed
+	struct LoadedModel {
+		std::string filepath = {};
+		engine::model::Builder builderInstance = {};
+		std::string error = {};
+	};
+
+	std::vector<std::string> readModelList(const std::string& filepath) {
+		std::ifstream file{ filepath };
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open model list: " + filepath);
+		}
+
+		std::vector<std::string> paths = {};
+		std::string line = {};
+		while (std::getline(file, line)) {
+			while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back()))) line.pop_back(); // also strips the \r of CRLF lists
+			if (line.empty() || line[0] == '#') continue;
+			paths.push_back(line);
+		}
+		return paths;
+	}
+
+	void usage(const char* program) {
+		std::cerr << "usage: " << program << " <model list> [--out <dir>] [--size <px>] [--views <n>] [--elevation <degrees>] [--in-flight <n>] [--loaders <n>] [--encoders <n>] [--format png|ppm] [--json <path>]" << '\n';
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	std::string outputDirectory = "thumbnails";
+	uint32_t size = 256;
+	uint32_t viewCount = 4;
+	float elevation = 25.f;
+	uint32_t framesInFlight = 8;
+	uint32_t loaderCount = std::max(std::thread::hardware_concurrency() / 2, 1u);
+	uint32_t encoderCount = std::max(std::thread::hardware_concurrency() / 2, 1u);
+	std::string format = "png";
+	std::string jsonPath = {};
+	for (int i = 2; i < argc; i++) {
+		if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) outputDirectory = argv[++i];
+		else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) size = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--views") == 0 && i + 1 < argc) viewCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--elevation") == 0 && i + 1 < argc) elevation = static_cast<float>(std::atof(argv[++i]));
+		else if (std::strcmp(argv[i], "--in-flight") == 0 && i + 1 < argc) framesInFlight = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--loaders") == 0 && i + 1 < argc) loaderCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--encoders") == 0 && i + 1 < argc) encoderCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc && (std::strcmp(argv[i + 1], "png") == 0 || std::strcmp(argv[i + 1], "ppm") == 0)) format = argv[++i];
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) jsonPath = argv[++i];
+		else {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (size == 0 || viewCount == 0 || framesInFlight == 0 || loaderCount == 0 || encoderCount == 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	try {
+		using clock = std::chrono::steady_clock;
+		std::vector<std::string> modelPaths = readModelList(argv[1]);
+		std::filesystem::create_directories(outputDirectory);
+
+		engine::device deviceInstance = {};
+		engine::offscreenRenderer rendererInstance{ deviceInstance, VkExtent2D{ size, size }, framesInFlight };
+		// a buffer for every render in flight, plus as many again so encoding can lag behind the GPU without stalling it
+		engine::frameReadback readbackInstance{ deviceInstance, 2 * framesInFlight + encoderCount, encoderCount };
+		engine::frameArena frameArenaInstance = {};
+
+		auto globalPool = engine::descriptorPool::Builder(deviceInstance).setMaxSets(framesInFlight).addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, framesInFlight).build();
+		auto globalSetLayout = engine::descriptorSetLayout::Builder(deviceInstance).addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS).build();
+		engine::rendersystem renderSystem{ deviceInstance, rendererInstance.getRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+
+		std::vector<std::unique_ptr<engine::buffer>> uboBuffers(framesInFlight);
+		std::vector<VkDescriptorSet> globalDescriptorSets(framesInFlight);
+		for (size_t i = 0; i < uboBuffers.size(); i++) {
+			uboBuffers[i] = std::make_unique<engine::buffer>(deviceInstance, sizeof(engine::GlobalUbo), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			uboBuffers[i]->map();
+			auto bufferInfo = uboBuffers[i]->descriptorInfo();
+			engine::descriptorWriter(*globalSetLayout, *globalPool).writeBuffer(0, &bufferInfo).build(globalDescriptorSets[i]);
+		}
+
+		// keeps each model alive until the last frame slot that draws it has been reused
+		std::vector<std::shared_ptr<engine::model>> slotModels(framesInFlight);
+
+		// setup is done; close the startup report so the phases of every model load and upload aren't kept for the whole batch
+		engine::startupProfiler::markFirstFrame();
+
+		constexpr float FIELD_OF_VIEW = glm::radians(40.f);
+		auto start = clock::now();
+
+		// parse up to loaderCount models ahead of the one being rendered
+		std::deque<std::future<LoadedModel>> loads = {};
+		size_t nextLoad = 0;
+		auto startLoads = [&]() {
+			while (nextLoad < modelPaths.size() && loads.size() < loaderCount) {
+				loads.push_back(std::async(std::launch::async, [filepath = modelPaths[nextLoad]]() {
+					LoadedModel loaded{ filepath };
+					try {
+						loaded.builderInstance.loadModel(filepath);
+						if (loaded.builderInstance.vertices.size() < 3) loaded.error = "no triangles";
+					}
+					catch (const std::exception& e) {
+						loaded.error = e.what();
+					}
+					return loaded;
+				}));
+				nextLoad++;
+			}
+		};
+
+		std::vector<double> cpuSamples = {};
+		std::vector<double> intervalSamples = {};
+		uint64_t imageCount = 0;
+		uint64_t failedModels = 0;
+		auto previousStart = clock::now();
+		startLoads();
+		while (!loads.empty()) {
+			LoadedModel loaded = loads.front().get();
+			loads.pop_front();
+			startLoads();
+			if (!loaded.error.empty()) {
+				std::cerr << "skipping " << loaded.filepath << ": " << loaded.error << std::endl;
+				failedModels++;
+				continue;
+			}
+
+			// the mesh is drawn once per view and then dropped, so it's written straight into host visible memory
+			// instead of going through a staging copy that would wait for the queue to drain
+			auto modelInstance = std::make_shared<engine::model>(deviceInstance, loaded.builderInstance, engine::model::Residency::HOST_VISIBLE);
+
+			// frame the bounding sphere, centered on the origin
+			glm::vec3 minimum{ loaded.builderInstance.vertices[0].position };
+			glm::vec3 maximum{ minimum };
+			for (const auto& vertex : loaded.builderInstance.vertices) {
+				minimum = glm::min(minimum, vertex.position);
+				maximum = glm::max(maximum, vertex.position);
+			}
+			glm::vec3 center = 0.5f * (minimum + maximum);
+			float radius = std::max(0.5f * glm::length(maximum - minimum), 1e-4f);
+			float distance = radius / std::sin(0.5f * FIELD_OF_VIEW) * 1.05f;
+
+			engine::entity::Map gameEntities = {};
+			auto entityInstance = engine::entity::createEntity();
+			entityInstance.modelInstance = modelInstance;
+			entityInstance.transform.translation = -center;
+			gameEntities.emplace(entityInstance.getId(), std::move(entityInstance));
+
+			engine::camera cameraInstance = {};
+			cameraInstance.setPerspectiveProjection(FIELD_OF_VIEW, 1.f, 0.01f * distance, distance + 2.f * radius);
+			std::string stem = std::filesystem::path{ loaded.filepath }.stem().string();
+
+			for (uint32_t view = 0; view < viewCount; view++) {
+				auto frameStart = clock::now();
+				VkCommandBuffer commandBuffer = rendererInstance.beginFrame();
+				auto recordStart = clock::now();
+
+				// this slot's previous render has finished, hand its image to the encoders and release its model
+				int frameIndex = rendererInstance.getFrameIndex();
+				readbackInstance.collect(frameIndex);
+				slotModels[frameIndex] = modelInstance;
+				// the draw list is the only scratch allocation and it's dead once recording ends, so one arena slot serves every frame
+				frameArenaInstance.beginFrame(0);
+
+				// evenly spaced around the vertical axis, looking slightly down (-y is up)
+				float azimuth = glm::two_pi<float>() * static_cast<float>(view) / static_cast<float>(viewCount) + glm::quarter_pi<float>();
+				float pitch = glm::radians(elevation);
+				glm::vec3 position = distance * glm::vec3{ std::cos(pitch) * std::sin(azimuth), -std::sin(pitch), std::cos(pitch) * std::cos(azimuth) };
+				cameraInstance.setViewTarget(position, glm::vec3{ 0.f });
+
+				// a light just above the camera, bright enough to cancel the falloff over the viewing distance
+				engine::GlobalUbo ubo = {};
+				ubo.projection = cameraInstance.getProjection();
+				ubo.view = cameraInstance.getView();
+				ubo.ambientLightColor = { 1.f, 1.f, 1.f, .15f };
+				ubo.lightPosition = position + glm::vec3{ 0.f, -radius, 0.f };
+				ubo.lightColor = { 1.f, 1.f, 1.f, distance * distance };
+				uboBuffers[frameIndex]->writeToBuffer(&ubo);
+				uboBuffers[frameIndex]->flush();
+
+				engine::FrameInfo frameInfo{ frameIndex, 0.f, commandBuffer, cameraInstance, globalDescriptorSets[frameIndex], gameEntities, frameArenaInstance };
+				rendererInstance.beginRenderPass(commandBuffer);
+				renderSystem.renderEntities(frameInfo);
+				rendererInstance.endRenderPass(commandBuffer);
+
+				std::string filepath = (std::filesystem::path{ outputDirectory } / (stem + "_" + std::to_string(view) + "." + format)).string();
+				readbackInstance.record(commandBuffer, frameIndex, rendererInstance.getColorImage(frameIndex), engine::offscreenRenderer::COLOR_FORMAT, rendererInstance.getExtent(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, filepath);
+				rendererInstance.endFrame();
+				auto frameEnd = clock::now();
+
+				cpuSamples.push_back(std::chrono::duration<double, std::milli>(frameEnd - recordStart).count());
+				if (imageCount > 0) intervalSamples.push_back(std::chrono::duration<double, std::milli>(frameStart - previousStart).count());
+				previousStart = frameStart;
+				imageCount++;
+			}
+		}
+		rendererInstance.finish();
+		readbackInstance.flush();
+		double seconds = std::chrono::duration<double>(clock::now() - start).count();
+		double imagesPerSecond = seconds > 0.0 ? static_cast<double>(imageCount) / seconds : 0.0;
+
+		engine::benchmarkSuite suite{ "thumbnailer" };
+		suite.setContext("device", deviceInstance.deviceProperties.deviceName);
+		suite.setContext("models", std::to_string(modelPaths.size() - failedModels));
+		suite.setContext("failed_models", std::to_string(failedModels));
+		suite.setContext("views", std::to_string(viewCount));
+		suite.setContext("resolution", std::to_string(size) + "x" + std::to_string(size));
+		suite.setContext("format", format);
+		suite.setContext("frames_in_flight", std::to_string(framesInFlight));
+		suite.setContext("loaders", std::to_string(loaderCount));
+		suite.setContext("encoders", std::to_string(encoderCount));
+		suite.setContext("images", std::to_string(imageCount));
+		suite.setContext("seconds", std::to_string(seconds));
+		suite.setContext("images_per_second", std::to_string(imagesPerSecond));
+
+		// recording and submitting one image, excluding the wait for a free frame slot
+		engine::BenchmarkResult cpuResult = {};
+		cpuResult.name = "thumbnail.cpu";
+		cpuResult.unit = "ms";
+		cpuResult.samples = std::move(cpuSamples);
+		suite.addResult(std::move(cpuResult));
+
+		// start-to-start interval, bounded by whichever of parsing, the GPU or encoding is slowest
+		if (!intervalSamples.empty()) {
+			engine::BenchmarkResult intervalResult = {};
+			intervalResult.name = "thumbnail.interval";
+			intervalResult.unit = "ms";
+			intervalResult.samples = std::move(intervalSamples);
+			suite.addResult(std::move(intervalResult));
+		}
+
+		const auto& gpuFrameTimes = rendererInstance.getGpuFrameTimes();
+		if (!gpuFrameTimes.empty()) {
+			engine::BenchmarkResult gpuResult = {};
+			gpuResult.name = "thumbnail.gpu";
+			gpuResult.unit = "ms";
+			gpuResult.samples = gpuFrameTimes;
+			suite.addResult(std::move(gpuResult));
+		}
+
+		std::cout << "rendered " << imageCount << " image(s) of " << (modelPaths.size() - failedModels) << " model(s) in " << seconds << " s, " << imagesPerSecond << " images/s" << std::endl;
+		readbackInstance.report(std::cout);
+		suite.printSummary(std::cout);
+		if (!jsonPath.empty()) {
+			suite.writeJson(jsonPath);
+		}
+	}
+
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -1,4 +1,5 @@
 #include "window.hpp"
+#include "startupprofiler.hpp"
 #include <stdexcept>
 
 namespace engine {
@@ -13,6 +14,10 @@ namespace engine {
 	}
 
 	void window::init() {
+		startupProfiler::phase phase{ "window" };
+#if defined(ENGINE_NULL_VULKAN) && defined(GLFW_PLATFORM_NULL)
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL); // nothing is presented, so don't require a display either
+#endif
 		glfwInit(); // initialize the GLFW library
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API); // specify GLFW to not open with OpenGL context (default)
 		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE); // handling resized windows takes special care
@@ -22,9 +27,18 @@ namespace engine {
 	}
 
 	void window::createWindowSurface(VkInstance vulkanInstance, VkSurfaceKHR* surface) {
+#ifdef ENGINE_NULL_VULKAN
+		// the null backend has no window system integration, so a headless surface stands in for the window
+		VkHeadlessSurfaceCreateInfoEXT createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+		if (vkCreateHeadlessSurfaceEXT(vulkanInstance, &createInfo, nullptr, surface) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create window surface!");
+		}
+#else
 		if (glfwCreateWindowSurface(vulkanInstance, windowInstance, nullptr, surface) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create window surface!");
 		}
+#endif
 	}
 
 	void window::framebufferResizeCallback(GLFWwindow* windowInstance, int width, int height) {